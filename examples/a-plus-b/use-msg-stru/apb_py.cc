@@ -19,6 +19,8 @@
 
 #include "apb.h"
 
+#include "ns3-ai-msg-binding.h"
+
 #include <ns3/ai-module.h>
 
 #include <iostream>
@@ -35,24 +37,8 @@ PYBIND11_MODULE(ns3ai_apb_py_stru, m)
 
     py::class_<ActStruct>(m, "PyActStruct").def(py::init<>()).def_readwrite("c", &ActStruct::act_c);
 
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>>(m, "Ns3AiMsgInterfaceImpl")
-        .def(py::init<bool,
-                      bool,
-                      bool,
-                      uint32_t,
-                      const char*,
-                      const char*,
-                      const char*,
-                      const char*>())
-        .def("PyRecvBegin", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PyRecvBegin)
-        .def("PyRecvEnd", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PyRecvEnd)
-        .def("PySendBegin", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PySendBegin)
-        .def("PySendEnd", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PySendEnd)
-        .def("PyGetFinished", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PyGetFinished)
-        .def("GetCpp2PyStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::GetCpp2PyStruct,
-             py::return_value_policy::reference)
-        .def("GetPy2CppStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::GetPy2CppStruct,
-             py::return_value_policy::reference);
+    ns3::Ns3AiPyDefStats(m);
+    ns3::Ns3AiPyDefSubscriber<EnvStruct>(m);
+
+    ns3::Ns3AiPyDefInterface<EnvStruct, ActStruct>(m);
 }
@@ -18,6 +18,7 @@
 
 import ns3ai_apb_py_vec as py_binding
 from ns3ai_utils import Experiment
+import numpy as np
 import sys
 import traceback
 
@@ -36,9 +37,11 @@ try:
 
         # send to C++ side
         msgInterface.PySendBegin()
-        for i in range(len(msgInterface.GetCpp2PyVector())):
-            # calculate the sums
-            msgInterface.GetPy2CppVector()[i].c = msgInterface.GetCpp2PyVector()[i].a + msgInterface.GetCpp2PyVector()[i].b
+        # NumPy views of the vectors in shared memory, without copying
+        env = np.asarray(msgInterface.GetCpp2PyVector())
+        act = np.asarray(msgInterface.GetPy2CppVector())
+        # calculate the sums
+        act['c'] = env['a'] + env['b']
         msgInterface.PyRecvEnd()
         msgInterface.PySendEnd()
 
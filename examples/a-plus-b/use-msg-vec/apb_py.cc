@@ -19,9 +19,12 @@
 
 #include "apb.h"
 
+#include "ns3-ai-msg-binding.h"
+
 #include <ns3/ai-module.h>
 
 #include <iostream>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 
 namespace py = pybind11;
@@ -38,7 +41,24 @@ PYBIND11_MODULE(ns3ai_apb_py_vec, m)
 
     py::class_<ActStruct>(m, "PyActStruct").def(py::init<>()).def_readwrite("c", &ActStruct::act_c);
 
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::Cpp2PyMsgVector>(m, "PyEnvVector")
+    // NumPy dtypes of the structs, with the same field names as above
+    PYBIND11_NUMPY_DTYPE_EX(EnvStruct, env_a, "a", env_b, "b");
+    PYBIND11_NUMPY_DTYPE_EX(ActStruct, act_c, "c");
+
+    ns3::Ns3AiPyDefStats(m);
+
+    py::class_<ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::Cpp2PyMsgVector>(
+        m,
+        "PyEnvVector",
+        py::buffer_protocol())
+        .def_buffer([](ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::Cpp2PyMsgVector& vec) {
+            return py::buffer_info(vec.data(),
+                                   sizeof(EnvStruct),
+                                   py::format_descriptor<EnvStruct>::format(),
+                                   1,
+                                   {vec.size()},
+                                   {sizeof(EnvStruct)});
+        })
         .def(
             "resize",
             static_cast<void (ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::Cpp2PyMsgVector::*)(
@@ -59,7 +79,18 @@ PYBIND11_MODULE(ns3ai_apb_py_vec, m)
             },
             py::return_value_policy::reference);
 
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::Py2CppMsgVector>(m, "PyActVector")
+    py::class_<ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::Py2CppMsgVector>(
+        m,
+        "PyActVector",
+        py::buffer_protocol())
+        .def_buffer([](ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::Py2CppMsgVector& vec) {
+            return py::buffer_info(vec.data(),
+                                   sizeof(ActStruct),
+                                   py::format_descriptor<ActStruct>::format(),
+                                   1,
+                                   {vec.size()},
+                                   {sizeof(ActStruct)});
+        })
         .def(
             "resize",
             static_cast<void (ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::Py2CppMsgVector::*)(
@@ -80,24 +111,6 @@ PYBIND11_MODULE(ns3ai_apb_py_vec, m)
             },
             py::return_value_policy::reference);
 
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>>(m, "Ns3AiMsgInterfaceImpl")
-        .def(py::init<bool,
-                      bool,
-                      bool,
-                      uint32_t,
-                      const char*,
-                      const char*,
-                      const char*,
-                      const char*>())
-        .def("PyRecvBegin", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PyRecvBegin)
-        .def("PyRecvEnd", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PyRecvEnd)
-        .def("PySendBegin", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PySendBegin)
-        .def("PySendEnd", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PySendEnd)
-        .def("PyGetFinished", &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::PyGetFinished)
-        .def("GetCpp2PyVector",
-             &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::GetCpp2PyVector,
-             py::return_value_policy::reference)
-        .def("GetPy2CppVector",
-             &ns3::Ns3AiMsgInterfaceImpl<EnvStruct, ActStruct>::GetPy2CppVector,
-             py::return_value_policy::reference);
+    auto msgInterface = ns3::Ns3AiPyDefInterface<EnvStruct, ActStruct>(m);
+    ns3::Ns3AiPyDefVectors(msgInterface);
 }
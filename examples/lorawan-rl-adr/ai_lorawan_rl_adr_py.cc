@@ -1,4 +1,7 @@
 #include "lorawan_rl_adr.h"
+
+#include "ns3-ai-msg-binding.h"
+
 #include <ns3/ai-module.h>
 
 #include <pybind11/pybind11.h>
@@ -54,37 +57,8 @@ PYBIND11_MODULE(ns3ai_lorawan_adr_rl_py, m)
         });
 
 
-    // Handling message exchange between Python and C++
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<ns3::AiAdrStatesStruct, ns3::AiAdrActionStruct>>(m, "Ns3AiMsgInterfaceImpl")
-        .def(py::init<bool,
-                      bool,
-                      bool,
-                      uint32_t,
-                      const char*,
-                      const char*,
-                      const char*,
-                      const char*>())
-        .def("PyRecvBegin",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiAdrStatesStruct,
-                                         ns3::AiAdrActionStruct>::PyRecvBegin)
-        .def("PyRecvEnd",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiAdrStatesStruct,
-                                         ns3::AiAdrActionStruct>::PyRecvEnd)
-        .def("PySendBegin",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiAdrStatesStruct,
-                                         ns3::AiAdrActionStruct>::PySendBegin)
-        .def("PySendEnd",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiAdrStatesStruct,
-                                         ns3::AiAdrActionStruct>::PySendEnd)
-        .def("PyGetFinished",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiAdrStatesStruct,
-                                         ns3::AiAdrActionStruct>::PyGetFinished)
-        .def("GetCpp2PyStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiAdrStatesStruct,
-                                         ns3::AiAdrActionStruct>::GetCpp2PyStruct,
-             py::return_value_policy::reference)
-        .def("GetPy2CppStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiAdrStatesStruct,
-                                         ns3::AiAdrActionStruct>::GetPy2CppStruct,
-             py::return_value_policy::reference);
+    ns3::Ns3AiPyDefStats(m);
+    ns3::Ns3AiPyDefSubscriber<ns3::AiAdrStatesStruct>(m);
+
+    ns3::Ns3AiPyDefInterface<ns3::AiAdrStatesStruct, ns3::AiAdrActionStruct>(m);
 }
@@ -19,6 +19,8 @@
 
 #include "cqi-dl-env.h"
 
+#include "ns3-ai-msg-binding.h"
+
 #include <ns3/ai-module.h>
 
 #include <pybind11/pybind11.h>
@@ -35,31 +37,8 @@ PYBIND11_MODULE(ns3ai_ltecqi_py, m)
         .def(py::init<>())
         .def_readwrite("new_wbCqi", &ns3::CqiPredicted::new_wbCqi);
 
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<ns3::CqiFeature, ns3::CqiPredicted>>(
-        m,
-        "Ns3AiMsgInterfaceImpl")
-        .def(py::init<bool,
-                      bool,
-                      bool,
-                      uint32_t,
-                      const char*,
-                      const char*,
-                      const char*,
-                      const char*>())
-        .def("PyRecvBegin",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::CqiFeature, ns3::CqiPredicted>::PyRecvBegin)
-        .def("PyRecvEnd",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::CqiFeature, ns3::CqiPredicted>::PyRecvEnd)
-        .def("PySendBegin",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::CqiFeature, ns3::CqiPredicted>::PySendBegin)
-        .def("PySendEnd",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::CqiFeature, ns3::CqiPredicted>::PySendEnd)
-        .def("PyGetFinished",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::CqiFeature, ns3::CqiPredicted>::PyGetFinished)
-        .def("GetCpp2PyStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::CqiFeature, ns3::CqiPredicted>::GetCpp2PyStruct,
-             py::return_value_policy::reference)
-        .def("GetPy2CppStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::CqiFeature, ns3::CqiPredicted>::GetPy2CppStruct,
-             py::return_value_policy::reference);
+    ns3::Ns3AiPyDefStats(m);
+    ns3::Ns3AiPyDefSubscriber<ns3::CqiFeature>(m);
+
+    ns3::Ns3AiPyDefInterface<ns3::CqiFeature, ns3::CqiPredicted>(m);
 }
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+/*
+ * Lockstep round trips with the RL-TCP messages, comparing the layout of the
+ * message interface (every semaphore and message on its own cache lines)
+ * with a packed layout where the semaphores and both messages share lines.
+ * Both sides run in C++: the parent process plays the Python side.
+ *
+ * Run it with both processes on different cores, e.g.
+ *   perf stat -e cache-misses,LLC-load-misses ./ns3 run "ns3ai_msg_layout_bench --layout=packed"
+ *   perf stat -e cache-misses,LLC-load-misses ./ns3 run "ns3ai_msg_layout_bench --layout=aligned"
+ * or use perf c2c to see the shared lines.
+ */
+
+#include <ns3/ai-module.h>
+#include <ns3/core-module.h>
+
+#include <chrono>
+#include <iostream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+// same as the RL-TCP example
+struct TcpRlEnv
+{
+    uint32_t nodeId;
+    uint32_t socketUid;
+    uint8_t envType;
+    int64_t simTime_us;
+    uint32_t ssThresh;
+    uint32_t cWnd;
+    uint32_t segmentSize;
+    uint32_t segmentsAcked;
+    uint32_t bytesInFlight;
+};
+
+struct TcpRlAct
+{
+    uint32_t new_ssThresh;
+    uint32_t new_cWnd;
+};
+
+// semaphores and messages sharing cache lines
+struct PackedMsg
+{
+    volatile uint32_t m_cpp2pyEmptyCount{1};
+    volatile uint32_t m_cpp2pyFullCount{0};
+    volatile uint32_t m_py2cppEmptyCount{1};
+    volatile uint32_t m_py2cppFullCount{0};
+    volatile uint32_t m_cpp2pyEmptyWaiters{0};
+    volatile uint32_t m_cpp2pyFullWaiters{0};
+    volatile uint32_t m_py2cppEmptyWaiters{0};
+    volatile uint32_t m_py2cppFullWaiters{0};
+    TcpRlEnv m_env;
+    TcpRlAct m_act;
+};
+
+static const char* SEG_NAME = "ns3ai_msg_layout_bench";
+
+// the C++ side of one round trip in each layout
+
+static uint32_t
+CppRoundTrip(PackedMsg* msg, uint32_t i, uint32_t spinBudget)
+{
+    Ns3AiSemaphore::sem_wait(&msg->m_cpp2pyEmptyCount, &msg->m_cpp2pyEmptyWaiters, spinBudget);
+    msg->m_env.cWnd = i;
+    Ns3AiSemaphore::sem_post(&msg->m_cpp2pyFullCount, &msg->m_cpp2pyFullWaiters);
+    Ns3AiSemaphore::sem_wait(&msg->m_py2cppFullCount, &msg->m_py2cppFullWaiters, spinBudget);
+    uint32_t cWnd = msg->m_act.new_cWnd;
+    Ns3AiSemaphore::sem_post(&msg->m_py2cppEmptyCount, &msg->m_py2cppEmptyWaiters);
+    return cWnd;
+}
+
+static uint32_t
+CppRoundTrip(Ns3AiMsgInterfaceImpl<TcpRlEnv, TcpRlAct>* msg, uint32_t i, uint32_t)
+{
+    msg->CppSendBegin();
+    msg->GetCpp2PyStruct()->cWnd = i;
+    msg->CppSendEnd();
+    msg->CppRecvBegin();
+    uint32_t cWnd = msg->GetPy2CppStruct()->new_cWnd;
+    msg->CppRecvEnd();
+    return cWnd;
+}
+
+// the Python side of one round trip in each layout
+
+static void
+PyRoundTrip(PackedMsg* msg, uint32_t spinBudget)
+{
+    Ns3AiSemaphore::sem_wait(&msg->m_cpp2pyFullCount, &msg->m_cpp2pyFullWaiters, spinBudget);
+    uint32_t cWnd = msg->m_env.cWnd;
+    Ns3AiSemaphore::sem_post(&msg->m_cpp2pyEmptyCount, &msg->m_cpp2pyEmptyWaiters);
+    Ns3AiSemaphore::sem_wait(&msg->m_py2cppEmptyCount, &msg->m_py2cppEmptyWaiters, spinBudget);
+    msg->m_act.new_cWnd = cWnd + 1;
+    Ns3AiSemaphore::sem_post(&msg->m_py2cppFullCount, &msg->m_py2cppFullWaiters);
+}
+
+static void
+PyRoundTrip(Ns3AiMsgInterfaceImpl<TcpRlEnv, TcpRlAct>* msg, uint32_t)
+{
+    msg->PyRecvBegin();
+    uint32_t cWnd = msg->GetCpp2PyStruct()->cWnd;
+    msg->PyRecvEnd();
+    msg->PySendBegin();
+    msg->GetPy2CppStruct()->new_cWnd = cWnd + 1;
+    msg->PySendEnd();
+}
+
+/**
+ * Runs the round trips with the C++ side in a child process, which prints
+ * the nanoseconds per round trip
+ */
+template <typename Msg>
+static void
+Run(Msg* pyMsg, Msg* cppMsg, uint32_t rounds, uint32_t spinBudget)
+{
+    pid_t pid = fork();
+    NS_ABORT_MSG_IF(pid < 0, "fork failed");
+    if (pid == 0)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < rounds; ++i)
+        {
+            if (CppRoundTrip(cppMsg, i, spinBudget) != i + 1)
+            {
+                _exit(1);
+            }
+        }
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        std::cout << elapsed.count() / rounds << std::endl;
+        _exit(0);
+    }
+    for (uint32_t i = 0; i < rounds; ++i)
+    {
+        PyRoundTrip(pyMsg, spinBudget);
+    }
+    int status;
+    waitpid(pid, &status, 0);
+    NS_ABORT_MSG_IF(!WIFEXITED(status) || WEXITSTATUS(status) != 0, "Wrong reply");
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t rounds = 1000000;
+    uint32_t spinBudget = Ns3AiSemaphore::DEFAULT_SPIN_BUDGET;
+    std::string layout = "both";
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("rounds", "Number of round trips", rounds);
+    cmd.AddValue("spinBudget", "Busy-wait iterations before sleeping", spinBudget);
+    cmd.AddValue("layout", "packed, aligned or both", layout);
+    cmd.Parse(argc, argv);
+
+    std::cout << "sizeof(TcpRlEnv) = " << sizeof(TcpRlEnv)
+              << ", sizeof(TcpRlAct) = " << sizeof(TcpRlAct) << std::endl;
+
+    if (layout == "packed" || layout == "both")
+    {
+        // the child inherits the mapping of the segment
+        boost::interprocess::shared_memory_object::remove(SEG_NAME);
+        boost::interprocess::managed_shared_memory segment(boost::interprocess::create_only,
+                                                           SEG_NAME,
+                                                           4096);
+        PackedMsg* msg = segment.construct<PackedMsg>("packed")();
+        std::cout << "packed layout, ns per round trip: " << std::flush;
+        Run(msg, msg, rounds, spinBudget);
+        boost::interprocess::shared_memory_object::remove(SEG_NAME);
+    }
+    if (layout == "aligned" || layout == "both")
+    {
+        Ns3AiMsgInterfaceImpl<TcpRlEnv, TcpRlAct> py(true,
+                                                     false,
+                                                     false,
+                                                     4096,
+                                                     SEG_NAME,
+                                                     "env",
+                                                     "act",
+                                                     "sync",
+                                                     spinBudget);
+        Ns3AiMsgInterfaceImpl<TcpRlEnv, TcpRlAct> cpp(false,
+                                                      false,
+                                                      false,
+                                                      4096,
+                                                      SEG_NAME,
+                                                      "env",
+                                                      "act",
+                                                      "sync",
+                                                      spinBudget);
+        std::cout << "aligned layout, ns per round trip: " << std::flush;
+        Run(&py, &cpp, rounds, spinBudget);
+    }
+    return 0;
+}
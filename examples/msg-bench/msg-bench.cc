@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+/*
+ * C++ side of the message interface benchmark, driven by msg_bench.py.
+ * Each round trip fills a message of the given size, sends it and waits
+ * for Python side to echo its sequence number. Nothing is printed in the
+ * loop, so the results only include the interface and the fill cost.
+ * With the ring-buffer interface, several messages are in flight and Python
+ * side drains them in bulk.
+ */
+
+#include "msg-bench.h"
+
+#include <ns3/ai-module.h>
+#include <ns3/core-module.h>
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Runs warmup + rounds round trips, recording the latency of the last
+ * rounds ones
+ *
+ * \return the duration of the recorded round trips in nanoseconds
+ */
+template <typename Msg>
+static uint64_t
+Run(bool useVector, uint32_t warmup, uint32_t rounds, Ns3AiHistogram& rtt)
+{
+    Ns3AiMsgInterfaceImpl<Msg, BenchAck>* msgInterface =
+        Ns3AiMsgInterface::Get()->GetInterface<Msg, BenchAck>();
+
+    uint64_t start = Ns3AiMsgStats::Now();
+    for (uint32_t i = 0; i < warmup + rounds; ++i)
+    {
+        if (i == warmup)
+        {
+            start = Ns3AiMsgStats::Now();
+        }
+        uint64_t sent = Ns3AiMsgStats::Now();
+
+        msgInterface->CppSendBegin();
+        if (useVector)
+        {
+            for (auto& msg : *msgInterface->GetCpp2PyVector())
+            {
+                msg.data[0] = i;
+            }
+        }
+        else
+        {
+            Msg* msg = msgInterface->GetCpp2PyStruct();
+            for (uint64_t& word : msg->data)
+            {
+                word = i;
+            }
+        }
+        msgInterface->CppSendEnd();
+
+        msgInterface->CppRecvBegin();
+        uint64_t seq = useVector ? msgInterface->GetPy2CppVector()->at(0).seq
+                                 : msgInterface->GetPy2CppStruct()->seq;
+        msgInterface->CppRecvEnd();
+        NS_ABORT_MSG_IF(seq != i, "Python side echoed " << seq << " instead of " << i);
+
+        if (i >= warmup)
+        {
+            rtt.Record(Ns3AiMsgStats::Now() - sent);
+        }
+    }
+    return Ns3AiMsgStats::Now() - start;
+}
+
+/**
+ * Like Run, with the ring-buffer interface: up to window messages are in
+ * flight, and the latency of a message lasts until C++ side sees its echo
+ */
+template <typename Msg>
+static uint64_t
+RunRing(uint32_t window, uint32_t warmup, uint32_t rounds, Ns3AiHistogram& rtt)
+{
+    Ns3AiMsgRingImpl<Msg, BenchAck>* msgInterface =
+        Ns3AiMsgInterface::Get()->GetRingInterface<Msg, BenchAck>();
+    NS_ABORT_MSG_IF(window == 0 || window > msgInterface->GetCapacity(),
+                    "Window must be between 1 and the ring capacity "
+                        << msgInterface->GetCapacity());
+
+    // send times of the messages in flight, whose sequence numbers are
+    // consecutive
+    std::vector<uint64_t> sent(window);
+    uint32_t inFlight = 0;
+    uint32_t acked = 0;
+    uint64_t start = Ns3AiMsgStats::Now();
+    for (uint32_t i = 0; i < warmup + rounds || inFlight; ++i)
+    {
+        if (i < warmup + rounds)
+        {
+            if (i == warmup)
+            {
+                start = Ns3AiMsgStats::Now();
+            }
+            Msg* msg = msgInterface->CppSendBegin();
+            for (uint64_t& word : msg->data)
+            {
+                word = i;
+            }
+            uint64_t seq = msgInterface->CppSendEnd();
+            sent[seq % window] = Ns3AiMsgStats::Now();
+            ++inFlight;
+        }
+        if (inFlight < window && i + 1 < warmup + rounds)
+        {
+            continue;
+        }
+        uint32_t count = msgInterface->CppRecvBegin();
+        for (uint32_t j = 0; j < count; ++j, ++acked)
+        {
+            uint64_t seq = msgInterface->GetPy2CppSeq(j);
+            NS_ABORT_MSG_IF(seq != acked || msgInterface->GetPy2CppStructAt(j)->seq != acked,
+                            "Python side echoed " << seq << " instead of " << acked);
+            if (acked >= warmup)
+            {
+                rtt.Record(Ns3AiMsgStats::Now() - sent[seq % window]);
+            }
+        }
+        msgInterface->CppRecvEnd(count);
+        inFlight -= count;
+    }
+    return Ns3AiMsgStats::Now() - start;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t size = 8;
+    bool useVector = false;
+    uint32_t window = 0;
+    uint32_t warmup = 1000;
+    uint32_t rounds = 100000;
+    uint32_t spinBudget = Ns3AiSemaphore::DEFAULT_SPIN_BUDGET;
+    std::string result;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("size", "Message size in bytes (struct mode)", size);
+    cmd.AddValue("useVector", "Use vector mode, whose length is set by Python side", useVector);
+    cmd.AddValue("window",
+                 "Use the ring-buffer interface with this many messages in flight (default: "
+                 "lockstep interface)",
+                 window);
+    cmd.AddValue("warmup", "Number of round trips before recording", warmup);
+    cmd.AddValue("rounds", "Number of recorded round trips", rounds);
+    cmd.AddValue("spinBudget", "Busy-wait iterations before sleeping on futex", spinBudget);
+    cmd.AddValue("result", "JSON file of the results (default: stdout)", result);
+    cmd.Parse(argc, argv);
+    NS_ABORT_MSG_IF(rounds == 0, "No round trip to record");
+
+    auto interface = Ns3AiMsgInterface::Get();
+    interface->SetIsMemoryCreator(false);
+    interface->SetUseVector(useVector);
+    interface->SetHandleFinish(true);
+    interface->SetSpinBudget(spinBudget);
+
+    // about 4 KB, keep it off the stack
+    auto rtt = std::make_unique<Ns3AiHistogram>();
+    uint64_t elapsed = 0;
+    if (useVector)
+    {
+        elapsed = Run<BenchMsg<8>>(true, warmup, rounds, *rtt);
+    }
+    else if (window)
+    {
+        switch (size)
+        {
+#define MSG_BENCH_CASE(SIZE)                                                                       \
+    case SIZE:                                                                                     \
+        elapsed = RunRing<BenchMsg<SIZE>>(window, warmup, rounds, *rtt);                           \
+        break;
+            MSG_BENCH_FOR_EACH_SIZE(MSG_BENCH_CASE)
+#undef MSG_BENCH_CASE
+        default:
+            NS_FATAL_ERROR("Unsupported message size " << size);
+        }
+    }
+    else
+    {
+        switch (size)
+        {
+#define MSG_BENCH_CASE(SIZE)                                                                       \
+    case SIZE:                                                                                     \
+        elapsed = Run<BenchMsg<SIZE>>(false, warmup, rounds, *rtt);                                \
+        break;
+            MSG_BENCH_FOR_EACH_SIZE(MSG_BENCH_CASE)
+#undef MSG_BENCH_CASE
+        default:
+            NS_FATAL_ERROR("Unsupported message size " << size);
+        }
+    }
+
+    std::ofstream file;
+    if (!result.empty())
+    {
+        file.open(result);
+        NS_ABORT_MSG_IF(!file, "Cannot open " << result);
+    }
+    std::ostream& out = result.empty() ? std::cout : file;
+    out << "{\"rounds\": " << rounds << ", \"elapsed_ns\": " << elapsed
+        << ", \"msgs_per_s\": " << rounds * 1e9 / elapsed << ", \"rtt_mean_ns\": " << rtt->GetMean()
+        << ", \"rtt_p50_ns\": " << rtt->GetPercentile(0.5)
+        << ", \"rtt_p99_ns\": " << rtt->GetPercentile(0.99) << ", \"rtt_max_ns\": " << rtt->GetMax()
+        << "}" << std::endl;
+    return 0;
+}
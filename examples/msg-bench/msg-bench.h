@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef MSG_BENCH_H
+#define MSG_BENCH_H
+
+#include <cstdint>
+
+/**
+ * Message of Size bytes sent by C++ side. data[0] is the sequence number.
+ * In vector mode, the message is a vector of BenchMsg<8>.
+ */
+template <uint32_t Size>
+struct BenchMsg
+{
+    static_assert(Size >= 8 && Size % 8 == 0, "Size must be a multiple of 8");
+    uint64_t data[Size / 8];
+};
+
+/**
+ * Reply of Python side, echoing the sequence number
+ */
+struct BenchAck
+{
+    uint64_t seq;
+};
+
+/**
+ * Expands MACRO(Size) for each message size supported in struct mode
+ * (8 B to 1 MB, every factor of 8)
+ */
+#define MSG_BENCH_FOR_EACH_SIZE(MACRO)                                                             \
+    MACRO(8)                                                                                       \
+    MACRO(64)                                                                                      \
+    MACRO(512)                                                                                     \
+    MACRO(4096)                                                                                    \
+    MACRO(32768)                                                                                   \
+    MACRO(262144)                                                                                  \
+    MACRO(1048576)
+
+#endif // MSG_BENCH_H
@@ -0,0 +1,199 @@
+# Copyright (c) 2023 Huazhong University of Science and Technology
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Author: Muyuan Shen <muyuan_shen@hust.edu.cn>
+
+# Python side of the message interface benchmark. For every combination of
+# the swept parameters, it runs ns3ai_msg_bench, echoes its messages and
+# collects the round-trip latency and throughput measured by C++ side.
+
+import argparse
+import json
+import os
+import platform
+import sys
+import tempfile
+import time
+import traceback
+import types
+
+import ns3ai_msg_bench_py as py_binding
+from ns3ai_utils import Experiment
+
+# message sizes supported in struct mode, see MSG_BENCH_FOR_EACH_SIZE
+STRUCT_SIZES = [8, 64, 512, 4096, 32768, 262144, 1048576]
+
+# wait strategies: spin budget of both sides
+WAIT_STRATEGIES = {
+    'futex': 0,           # sleep at once
+    'adaptive': None,     # default budget
+    'spin': 1 << 30,      # busy-wait only
+}
+
+
+def echo_struct(msgInterface):
+    while True:
+        msgInterface.PyRecvBegin()
+        if msgInterface.PyGetFinished():
+            break
+        seq = msgInterface.GetCpp2PyStruct().seq
+        msgInterface.PyRecvEnd()
+        msgInterface.PySendBegin()
+        msgInterface.GetPy2CppStruct().seq = seq
+        msgInterface.PySendEnd()
+
+
+def echo_vector(msgInterface):
+    while True:
+        msgInterface.PyRecvBegin()
+        if msgInterface.PyGetFinished():
+            break
+        seq = msgInterface.GetCpp2PyVector()[0].seq
+        msgInterface.PyRecvEnd()
+        msgInterface.PySendBegin()
+        msgInterface.GetPy2CppVector()[0].seq = seq
+        msgInterface.PySendEnd()
+
+
+# drains every message C++ side has in flight before echoing them
+def echo_ring(msgInterface):
+    while True:
+        count = msgInterface.PyRecvBegin()
+        if count == 0 and msgInterface.PyGetFinished():
+            break
+        for i in range(count):
+            seq = msgInterface.GetCpp2PySeq(i)
+            msgSeq = msgInterface.GetCpp2PyStructAt(i).seq
+            msgInterface.PySendBegin()
+            msgInterface.GetPy2CppStruct().seq = msgSeq
+            msgInterface.PySendEnd(seq)
+        msgInterface.PyRecvEnd(count)
+
+
+def run_one(ns3Path, mode, size, length, strategy, rounds, warmup, window):
+    budget = WAIT_STRATEGIES[strategy]
+    if mode == 'struct':
+        impl = getattr(py_binding, 'Ns3AiMsgInterfaceImpl{}'.format(size))
+        payload = size
+    elif mode == 'ring':
+        impl = getattr(py_binding, 'Ns3AiMsgRingImpl{}'.format(size))
+        payload = size
+    else:
+        impl = py_binding.Ns3AiMsgInterfaceImpl8
+        payload = 8 * length
+    # each message type has its own class in the binding
+    msgModule = types.SimpleNamespace(Ns3AiMsgInterfaceImpl=impl, Ns3AiMsgRingImpl=impl)
+    # smallest power of two holding the window
+    ringCapacity = 1 << (window - 1).bit_length() if mode == 'ring' else None
+
+    fd, resultPath = tempfile.mkstemp(suffix='.json')
+    os.close(fd)
+    setting = {'size': size, 'useVector': int(mode == 'vector'), 'rounds': rounds,
+               'warmup': warmup, 'result': resultPath}
+    if budget is not None:
+        setting['spinBudget'] = budget
+    if mode == 'ring':
+        setting['window'] = window
+
+    exp = Experiment('ns3ai_msg_bench', ns3Path, msgModule, handleFinish=True,
+                     useVector=mode == 'vector', vectorSize=length if mode == 'vector' else None,
+                     spinBudget=budget, ringCapacity=ringCapacity)
+    try:
+        msgInterface = exp.run(setting=setting)
+        if mode == 'struct':
+            echo_struct(msgInterface)
+        elif mode == 'ring':
+            echo_ring(msgInterface)
+        else:
+            echo_vector(msgInterface)
+        exp.proc.communicate()
+        with open(resultPath) as f:
+            result = json.load(f)
+    finally:
+        del exp
+        os.remove(resultPath)
+
+    result.update({'mode': mode, 'payload_bytes': payload, 'strategy': strategy})
+    if mode == 'vector':
+        result['vector_length'] = length
+    elif mode == 'ring':
+        result['window'] = window
+    return result
+
+
+def main():
+    parser = argparse.ArgumentParser(description='ns3-ai message interface benchmark')
+    parser.add_argument('--ns3-path', default='../../../../',
+                        help='ns-3 directory (default: the one containing contrib/ai)')
+    parser.add_argument('--modes', nargs='+', default=['struct', 'vector'],
+                        choices=['struct', 'vector', 'ring'])
+    parser.add_argument('--sizes', nargs='+', type=int, default=STRUCT_SIZES,
+                        help='message sizes in bytes, struct and ring modes')
+    parser.add_argument('--lengths', nargs='+', type=int, default=[1, 16, 256, 4096, 131072],
+                        help='vector lengths (8 bytes per element), vector mode')
+    parser.add_argument('--window', type=int, default=64,
+                        help='messages in flight, ring mode')
+    parser.add_argument('--strategies', nargs='+', default=['adaptive'],
+                        choices=list(WAIT_STRATEGIES.keys()))
+    parser.add_argument('--rounds', type=int, default=100000)
+    parser.add_argument('--warmup', type=int, default=1000)
+    parser.add_argument('--output', default='msg_bench.json', help='JSON file of the results')
+    args = parser.parse_args()
+
+    for size in args.sizes:
+        if size not in STRUCT_SIZES:
+            parser.error('size {} is not one of {}'.format(size, STRUCT_SIZES))
+    if args.window < 1:
+        parser.error('window must be positive')
+    # Experiment changes the working directory
+    ns3Path = os.path.abspath(args.ns3_path)
+    output = os.path.abspath(args.output)
+
+    results = []
+    for strategy in args.strategies:
+        for mode in args.modes:
+            for value in (args.lengths if mode == 'vector' else args.sizes):
+                size = 8 if mode == 'vector' else value
+                length = value if mode == 'vector' else None
+                result = run_one(ns3Path, mode, size, length, strategy, args.rounds, args.warmup,
+                                 args.window)
+                print('{:6} {:8} {:>8} B: p50 {:>9} ns, p99 {:>9} ns, {:>10.0f} msgs/s'.format(
+                    mode, strategy, result['payload_bytes'], result['rtt_p50_ns'],
+                    result['rtt_p99_ns'], result['msgs_per_s']))
+                results.append(result)
+
+    report = {
+        'timestamp': time.strftime('%Y-%m-%dT%H:%M:%S'),
+        'host': platform.node(),
+        'machine': platform.machine(),
+        'cpus': os.cpu_count(),
+        'rounds': args.rounds,
+        'warmup': args.warmup,
+        'results': results,
+    }
+    with open(output, 'w') as f:
+        json.dump(report, f, indent=2)
+    print('Results written to {}'.format(output))
+
+
+if __name__ == '__main__':
+    try:
+        main()
+    except Exception as e:
+        exc_type, exc_value, exc_traceback = sys.exc_info()
+        print("Exception occurred: {}".format(e))
+        print("Traceback:")
+        traceback.print_tb(exc_traceback)
+        exit(1)
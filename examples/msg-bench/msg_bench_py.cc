@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#include "msg-bench.h"
+
+#include "ns3-ai-msg-binding.h"
+
+#include <ns3/ai-module.h>
+
+#include <pybind11/pybind11.h>
+
+#include <string>
+
+namespace py = pybind11;
+
+typedef ns3::Ns3AiMsgInterfaceImpl<BenchMsg<8>, BenchAck> BenchVectorImpl;
+
+PYBIND11_MAKE_OPAQUE(BenchVectorImpl::Cpp2PyMsgVector);
+PYBIND11_MAKE_OPAQUE(BenchVectorImpl::Py2CppMsgVector);
+
+/**
+ * Binds BenchMsg<Size> as BenchMsg<Size>, its interface as
+ * Ns3AiMsgInterfaceImpl<Size> and its ring-buffer interface as
+ * Ns3AiMsgRingImpl<Size>
+ */
+template <uint32_t Size>
+static py::class_<ns3::Ns3AiMsgInterfaceImpl<BenchMsg<Size>, BenchAck>>
+BindSize(py::module& m)
+{
+    typedef BenchMsg<Size> Msg;
+    std::string suffix = std::to_string(Size);
+
+    py::class_<Msg>(m, ("BenchMsg" + suffix).c_str())
+        .def_property_readonly("seq", [](const Msg& msg) { return msg.data[0]; });
+
+    ns3::Ns3AiPyDefSubscriber<Msg>(m, ("Ns3AiMsgSubscriber" + suffix).c_str());
+    ns3::Ns3AiPyDefRing<Msg, BenchAck>(m, ("Ns3AiMsgRingImpl" + suffix).c_str());
+
+    return ns3::Ns3AiPyDefInterface<Msg, BenchAck>(m, ("Ns3AiMsgInterfaceImpl" + suffix).c_str());
+}
+
+PYBIND11_MODULE(ns3ai_msg_bench_py, m)
+{
+    py::class_<BenchAck>(m, "BenchAck").def(py::init<>()).def_readwrite("seq", &BenchAck::seq);
+
+    ns3::Ns3AiPyDefStats(m);
+
+    // vector mode uses the 8-byte message as vector element
+    py::class_<BenchVectorImpl::Cpp2PyMsgVector>(m, "BenchMsgVector")
+        .def("resize",
+             static_cast<void (BenchVectorImpl::Cpp2PyMsgVector::*)(
+                 BenchVectorImpl::Cpp2PyMsgVector::size_type)>(
+                 &BenchVectorImpl::Cpp2PyMsgVector::resize))
+        .def("__len__", &BenchVectorImpl::Cpp2PyMsgVector::size)
+        .def(
+            "__getitem__",
+            [](BenchVectorImpl::Cpp2PyMsgVector& vec, uint32_t i) -> BenchMsg<8>& {
+                if (i >= vec.size())
+                {
+                    throw py::index_error();
+                }
+                return vec[i];
+            },
+            py::return_value_policy::reference);
+
+    py::class_<BenchVectorImpl::Py2CppMsgVector>(m, "BenchAckVector")
+        .def("resize",
+             static_cast<void (BenchVectorImpl::Py2CppMsgVector::*)(
+                 BenchVectorImpl::Py2CppMsgVector::size_type)>(
+                 &BenchVectorImpl::Py2CppMsgVector::resize))
+        .def("__len__", &BenchVectorImpl::Py2CppMsgVector::size)
+        .def(
+            "__getitem__",
+            [](BenchVectorImpl::Py2CppMsgVector& vec, uint32_t i) -> BenchAck& {
+                if (i >= vec.size())
+                {
+                    throw py::index_error();
+                }
+                return vec[i];
+            },
+            py::return_value_policy::reference);
+
+    auto vectorInterface = BindSize<8>(m);
+    ns3::Ns3AiPyDefVectors(vectorInterface);
+
+#define MSG_BENCH_BIND(SIZE)                                                                       \
+    if (SIZE != 8)                                                                                 \
+    {                                                                                              \
+        BindSize<SIZE>(m);                                                                         \
+    }
+    MSG_BENCH_FOR_EACH_SIZE(MSG_BENCH_BIND)
+#undef MSG_BENCH_BIND
+}
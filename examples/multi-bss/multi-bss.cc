@@ -975,6 +975,9 @@ MeasureIntervalThroughputHolDelay()
     msgInterface->CppRecvBegin();
     double nextCca = msgInterface->GetPy2CppVector()->at(0).newCcaSensitivity;
     msgInterface->CppRecvEnd();
+    // with delayed actions, Python side has not answered the first intervals yet
+    static uint32_t interval = 0;
+    bool hasAction = interval++ >= msgInterface->GetActionDelay();
 
     std::cout << "At " << Simulator::Now().GetMilliSeconds() << "ms:" << std::endl;
 
@@ -989,6 +992,10 @@ MeasureIntervalThroughputHolDelay()
         // Only change CCA for nodes in BSS-0
         NS_ASSERT(ssid.IsEqual(Ssid("BSS-0")));
         double currentCca = wifi_phy->GetCcaSensitivityThreshold();
+        if (!hasAction)
+        {
+            nextCca = currentCca;
+        }
 
         Ptr<ThresholdPreambleDetectionModel> preambleCaptureModel =
             CreateObject<ThresholdPreambleDetectionModel>();
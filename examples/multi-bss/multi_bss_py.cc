@@ -19,9 +19,12 @@
 
 #include "multi-bss.h"
 
+#include "ns3-ai-msg-binding.h"
+
 #include <ns3/ai-module.h>
 
 #include <iostream>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl_bind.h>
 
@@ -58,7 +61,24 @@ PYBIND11_MODULE(ns3ai_multibss_py, m)
         .def(py::init<>())
         .def_readwrite("newCcaSensitivity", &Act::newCcaSensitivity);
 
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Cpp2PyMsgVector>(m, "PyEnvVector")
+    // NumPy dtypes of the structs, with the same field names as above
+    PYBIND11_NUMPY_DTYPE(Env, txNode, rxPower, mcs, holDelay, throughput);
+    PYBIND11_NUMPY_DTYPE(Act, newCcaSensitivity);
+
+    ns3::Ns3AiPyDefStats(m);
+
+    py::class_<ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Cpp2PyMsgVector>(
+        m,
+        "PyEnvVector",
+        py::buffer_protocol())
+        .def_buffer([](ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Cpp2PyMsgVector& vec) {
+            return py::buffer_info(vec.data(),
+                                   sizeof(Env),
+                                   py::format_descriptor<Env>::format(),
+                                   1,
+                                   {vec.size()},
+                                   {sizeof(Env)});
+        })
         .def("resize",
              static_cast<void (ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Cpp2PyMsgVector::*)(
                  ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Cpp2PyMsgVector::size_type)>(
@@ -77,7 +97,18 @@ PYBIND11_MODULE(ns3ai_multibss_py, m)
             },
             py::return_value_policy::reference);
 
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Py2CppMsgVector>(m, "PyActVector")
+    py::class_<ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Py2CppMsgVector>(
+        m,
+        "PyActVector",
+        py::buffer_protocol())
+        .def_buffer([](ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Py2CppMsgVector& vec) {
+            return py::buffer_info(vec.data(),
+                                   sizeof(Act),
+                                   py::format_descriptor<Act>::format(),
+                                   1,
+                                   {vec.size()},
+                                   {sizeof(Act)});
+        })
         .def("resize",
              static_cast<void (ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Py2CppMsgVector::*)(
                  ns3::Ns3AiMsgInterfaceImpl<Env, Act>::Py2CppMsgVector::size_type)>(
@@ -96,24 +127,6 @@ PYBIND11_MODULE(ns3ai_multibss_py, m)
             },
             py::return_value_policy::reference);
 
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<Env, Act>>(m, "Ns3AiMsgInterfaceImpl")
-        .def(py::init<bool,
-                      bool,
-                      bool,
-                      uint32_t,
-                      const char*,
-                      const char*,
-                      const char*,
-                      const char*>())
-        .def("PyRecvBegin", &ns3::Ns3AiMsgInterfaceImpl<Env, Act>::PyRecvBegin)
-        .def("PyRecvEnd", &ns3::Ns3AiMsgInterfaceImpl<Env, Act>::PyRecvEnd)
-        .def("PySendBegin", &ns3::Ns3AiMsgInterfaceImpl<Env, Act>::PySendBegin)
-        .def("PySendEnd", &ns3::Ns3AiMsgInterfaceImpl<Env, Act>::PySendEnd)
-        .def("PyGetFinished", &ns3::Ns3AiMsgInterfaceImpl<Env, Act>::PyGetFinished)
-        .def("GetCpp2PyVector",
-             &ns3::Ns3AiMsgInterfaceImpl<Env, Act>::GetCpp2PyVector,
-             py::return_value_policy::reference)
-        .def("GetPy2CppVector",
-             &ns3::Ns3AiMsgInterfaceImpl<Env, Act>::GetPy2CppVector,
-             py::return_value_policy::reference);
+    auto msgInterface = ns3::Ns3AiPyDefInterface<Env, Act>(m);
+    ns3::Ns3AiPyDefVectors(msgInterface);
 }
@@ -75,6 +75,9 @@ ns3Settings = {
     'drl': True,
     'configFile': 'contrib/ai/examples/multi-bss/config.txt',
 }
+# Set to 1 to let ns-3 simulate the next interval while the agent computes the
+# action of the current one; each action is then applied one interval later
+action_delay = 0
 n_ap = int(ns3Settings['apNodes'])
 n_sta = int(ns3Settings['networkSize'])
 n_total = n_ap * (n_sta + 1)
@@ -206,7 +209,8 @@ vrtpt_cons = 14.7
 eta = 1
 
 exp = Experiment("ns3ai_multibss", "../../../../", py_binding,
-                 handleFinish=True, useVector=True, vectorSize=n_total)
+                 handleFinish=True, useVector=True, vectorSize=n_total,
+                 actionDelay=action_delay)
 msgInterface = exp.run(setting=ns3Settings, show_output=True)
 
 try:
@@ -216,20 +220,20 @@ try:
         if msgInterface.PyGetFinished():
             print("Finished")
             break
-        throughput = 0
-        for i in range(n_total):
-            txNode = msgInterface.GetCpp2PyVector()[i].txNode
-            # print("processing i {} txNode {}".format(i, txNode))
-            for j in range(n_sta+1):
-                state[j, txNode] = msgInterface.GetCpp2PyVector()[i].rxPower[j]
-            # state[:, txNode] = msgInterface.GetCpp2PyVector()[i].rxPower
-            if txNode % n_ap == 0:  # record mcs in BSS-0
-                state[int(txNode/n_ap)][-1] = msgInterface.GetCpp2PyVector()[i].mcs
-            if txNode == n_ap:     # record delay and tpt of the VR node
-                vrDelay = msgInterface.GetCpp2PyVector()[i].holDelay
-                vrThroughput = msgInterface.GetCpp2PyVector()[i].throughput
-            # Sum all nodes' throughput
-            throughput += msgInterface.GetCpp2PyVector()[i].throughput
+        # NumPy view of the vector in shared memory, valid until PyRecvEnd
+        env = np.asarray(msgInterface.GetCpp2PyVector())
+        txNode = env['txNode']
+        state[:n_sta + 1, txNode] = env['rxPower'][:, :n_sta + 1].T
+        # record mcs in BSS-0
+        bss0 = txNode % n_ap == 0
+        state[txNode[bss0] // n_ap, -1] = env['mcs'][bss0]
+        # record delay and tpt of the VR node
+        vr = np.flatnonzero(txNode == n_ap)
+        if vr.size:
+            vrDelay = float(env['holDelay'][vr[-1]])
+            vrThroughput = float(env['throughput'][vr[-1]])
+        # Sum all nodes' throughput
+        throughput = float(env['throughput'].sum())
         msgInterface.PyRecvEnd()
 
         print("step = {}, VR avg delay = {} ms, VR UL tpt = {} Mbps, total UL tpt = {} Mbps".format(
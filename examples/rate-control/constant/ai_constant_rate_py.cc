@@ -19,6 +19,8 @@
 
 #include "ai-constant-rate-wifi-manager.h"
 
+#include "ns3-ai-msg-binding.h"
+
 #include <ns3/ai-module.h>
 
 #include <pybind11/pybind11.h>
@@ -38,39 +40,8 @@ PYBIND11_MODULE(ns3ai_ratecontrol_constant_py, m)
         .def_readwrite("nss", &ns3::AiConstantRateActStruct::nss)
         .def_readwrite("next_mcs", &ns3::AiConstantRateActStruct::next_mcs);
 
-    py::class_<
-        ns3::Ns3AiMsgInterfaceImpl<ns3::AiConstantRateEnvStruct, ns3::AiConstantRateActStruct>>(
-        m,
-        "Ns3AiMsgInterfaceImpl")
-        .def(py::init<bool,
-                      bool,
-                      bool,
-                      uint32_t,
-                      const char*,
-                      const char*,
-                      const char*,
-                      const char*>())
-        .def("PyRecvBegin",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiConstantRateEnvStruct,
-                                         ns3::AiConstantRateActStruct>::PyRecvBegin)
-        .def("PyRecvEnd",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiConstantRateEnvStruct,
-                                         ns3::AiConstantRateActStruct>::PyRecvEnd)
-        .def("PySendBegin",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiConstantRateEnvStruct,
-                                         ns3::AiConstantRateActStruct>::PySendBegin)
-        .def("PySendEnd",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiConstantRateEnvStruct,
-                                         ns3::AiConstantRateActStruct>::PySendEnd)
-        .def("PyGetFinished",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiConstantRateEnvStruct,
-                                         ns3::AiConstantRateActStruct>::PyGetFinished)
-        .def("GetCpp2PyStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiConstantRateEnvStruct,
-                                         ns3::AiConstantRateActStruct>::GetCpp2PyStruct,
-             py::return_value_policy::reference)
-        .def("GetPy2CppStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiConstantRateEnvStruct,
-                                         ns3::AiConstantRateActStruct>::GetPy2CppStruct,
-             py::return_value_policy::reference);
+    ns3::Ns3AiPyDefStats(m);
+    ns3::Ns3AiPyDefSubscriber<ns3::AiConstantRateEnvStruct>(m);
+
+    ns3::Ns3AiPyDefInterface<ns3::AiConstantRateEnvStruct, ns3::AiConstantRateActStruct>(m);
 }
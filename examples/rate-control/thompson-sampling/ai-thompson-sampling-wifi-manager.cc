@@ -247,19 +247,14 @@ AiThompsonSamplingWifiManager::DoReportDataFailed(WifiRemoteStation* st)
         Ns3AiMsgInterface::Get()
             ->GetInterface<AiThompsonSamplingEnvStruct, AiThompsonSamplingActStruct>();
 
-    msgInterface->CppSendBegin();
-    msgInterface->GetCpp2PyStruct()->type = 0x05;
-    msgInterface->GetCpp2PyStruct()->managerId = m_ns3ai_manager_id;
-    msgInterface->GetCpp2PyStruct()->stationId = station->m_ns3ai_station_id;
-    msgInterface->GetCpp2PyStruct()->data.decay.decay = m_decay;
-    msgInterface->GetCpp2PyStruct()->data.decay.now = Simulator::Now().GetSeconds();
-    msgInterface->CppSendEnd();
-
-    msgInterface->CppRecvBegin();
-    NS_ASSERT_MSG(msgInterface->GetPy2CppStruct()->stationId ==
-                      msgInterface->GetCpp2PyStruct()->stationId,
-                  "Error 0x05");
-    msgInterface->CppRecvEnd();
+    // report only, Python side does not reply
+    AiThompsonSamplingEnvStruct* msg = msgInterface->CppPostBegin();
+    msg->type = 0x05;
+    msg->managerId = m_ns3ai_manager_id;
+    msg->stationId = station->m_ns3ai_station_id;
+    msg->data.decay.decay = m_decay;
+    msg->data.decay.now = Simulator::Now().GetSeconds();
+    msgInterface->CppPostEnd();
 }
 
 void
@@ -311,19 +306,14 @@ AiThompsonSamplingWifiManager::DoReportDataOk(WifiRemoteStation* st,
         Ns3AiMsgInterface::Get()
             ->GetInterface<AiThompsonSamplingEnvStruct, AiThompsonSamplingActStruct>();
 
-    msgInterface->CppSendBegin();
-    msgInterface->GetCpp2PyStruct()->type = 0x06;
-    msgInterface->GetCpp2PyStruct()->managerId = m_ns3ai_manager_id;
-    msgInterface->GetCpp2PyStruct()->stationId = station->m_ns3ai_station_id;
-    msgInterface->GetCpp2PyStruct()->data.decay.decay = m_decay;
-    msgInterface->GetCpp2PyStruct()->data.decay.now = Simulator::Now().GetSeconds();
-    msgInterface->CppSendEnd();
-
-    msgInterface->CppRecvBegin();
-    NS_ASSERT_MSG(msgInterface->GetPy2CppStruct()->stationId ==
-                      msgInterface->GetCpp2PyStruct()->stationId,
-                  "Error 0x06");
-    msgInterface->CppRecvEnd();
+    // report only, Python side does not reply
+    AiThompsonSamplingEnvStruct* msg = msgInterface->CppPostBegin();
+    msg->type = 0x06;
+    msg->managerId = m_ns3ai_manager_id;
+    msg->stationId = station->m_ns3ai_station_id;
+    msg->data.decay.decay = m_decay;
+    msg->data.decay.now = Simulator::Now().GetSeconds();
+    msgInterface->CppPostEnd();
 }
 
 void
@@ -342,20 +332,15 @@ AiThompsonSamplingWifiManager::DoReportAmpduTxStatus(WifiRemoteStation* st,
         Ns3AiMsgInterface::Get()
             ->GetInterface<AiThompsonSamplingEnvStruct, AiThompsonSamplingActStruct>();
 
-    msgInterface->CppSendBegin();
-    msgInterface->GetCpp2PyStruct()->type = 0x07;
-    msgInterface->GetCpp2PyStruct()->managerId = m_ns3ai_manager_id;
-    msgInterface->GetCpp2PyStruct()->stationId = station->m_ns3ai_station_id;
-    msgInterface->GetCpp2PyStruct()->var = (uint64_t)nSuccessfulMpdus << 32 | nFailedMpdus;
-    msgInterface->GetCpp2PyStruct()->data.decay.decay = m_decay;
-    msgInterface->GetCpp2PyStruct()->data.decay.now = Simulator::Now().GetSeconds();
-    msgInterface->CppSendEnd();
-
-    msgInterface->CppRecvBegin();
-    NS_ASSERT_MSG(msgInterface->GetPy2CppStruct()->stationId ==
-                      msgInterface->GetCpp2PyStruct()->stationId,
-                  "Error 0x07");
-    msgInterface->CppRecvEnd();
+    // report only, Python side does not reply
+    AiThompsonSamplingEnvStruct* msg = msgInterface->CppPostBegin();
+    msg->type = 0x07;
+    msg->managerId = m_ns3ai_manager_id;
+    msg->stationId = station->m_ns3ai_station_id;
+    msg->var = (uint64_t)nSuccessfulMpdus << 32 | nFailedMpdus;
+    msg->data.decay.decay = m_decay;
+    msg->data.decay.now = Simulator::Now().GetSeconds();
+    msgInterface->CppPostEnd();
 }
 
 void
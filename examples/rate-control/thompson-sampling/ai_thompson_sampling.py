@@ -18,7 +18,6 @@
 #         Muyuan Shen <muyuan_shen@hust.edu.cn>
 
 
-import copy
 from typing import List
 import numpy as np
 import ns3ai_ratecontrol_ts_py as py_binding
@@ -31,38 +30,48 @@ class AiThompsonSamplingStation:
     _id = -1
     m_nextMode: int = 0
     m_lastMode: int = 0
-    m_mcsStats: List[py_binding.ThompsonSamplingRateStats]
+    # structured array with the fields of ThompsonSamplingRateStats
+    m_mcsStats: np.ndarray
 
     def __init__(self, id=-1) -> None:
         self._id = id
-        self.m_mcsStats = []
+        self.m_mcsStats = np.empty(0)
 
     def Decay(self, decayIdx, decay, now) -> None:
         if decayIdx >= len(self.m_mcsStats):
             print('Invalid mscStats[{}] @ {}'.format(decayIdx, self._id))
             return
-        stats = self.m_mcsStats[decayIdx]
-        if now > stats.lastDecay:
-            coefficient = np.exp(decay * (stats.lastDecay - now))
-            stats.success = coefficient * stats.success
-            stats.fails = coefficient * stats.fails
-            stats.lastDecay = now
+        stats = self.m_mcsStats
+        lastDecay = stats['lastDecay'][decayIdx]
+        if now > lastDecay:
+            coefficient = np.exp(decay * (lastDecay - now))
+            stats['success'][decayIdx] *= coefficient
+            stats['fails'][decayIdx] *= coefficient
+            stats['lastDecay'][decayIdx] = now
+
+    def DecayAll(self, decay, now) -> None:
+        stats = self.m_mcsStats
+        stale = now > stats['lastDecay']
+        coefficient = np.exp(decay * (stats['lastDecay'][stale] - now))
+        stats['success'][stale] *= coefficient
+        stats['fails'][stale] *= coefficient
+        stats['lastDecay'][stale] = now
 
     def DoReportDataFailed(self, decay, now) -> None:
         idx = self.m_lastMode
         self.Decay(idx, decay, now)
-        self.m_mcsStats[idx].fails = self.m_mcsStats[idx].fails + 1
+        self.m_mcsStats['fails'][idx] += 1
 
     def DoReportDataOk(self, decay, now) -> None:
         idx = self.m_lastMode
         self.Decay(idx, decay, now)
-        self.m_mcsStats[idx].success = self.m_mcsStats[idx].success + 1
+        self.m_mcsStats['success'][idx] += 1
 
     def DoReportAmpduTxStatus(self, decay, now, successful, failed) -> None:
         idx = self.m_lastMode
         self.Decay(idx, decay, now)
-        self.m_mcsStats[idx].fails = self.m_mcsStats[idx].fails + failed
-        self.m_mcsStats[idx].success = self.m_mcsStats[idx].success + successful
+        self.m_mcsStats['fails'][idx] += failed
+        self.m_mcsStats['success'][idx] += successful
 
     pass
 
@@ -76,24 +85,20 @@ class AiThompsonSamplingManager:
         self.m_gammaRandomVariable = np.random.RandomState(seed=stream)
 
     def SampleBetaVariable(self, alpha, beta):
-        X = self.m_gammaRandomVariable.gamma(alpha, 1.0)
-        Y = self.m_gammaRandomVariable.gamma(beta, 1.0)
-        return X / (X + Y)
+        # draws X and Y of each pair in turn, as one pair at a time would
+        XY = self.m_gammaRandomVariable.gamma(np.stack((alpha, beta), axis=-1), 1.0)
+        return XY[..., 0] / (XY[..., 0] + XY[..., 1])
 
     def UpdateNextMode(self, station: AiThompsonSamplingStation, decay, now):
-        maxThroughput = 0.0
-        frameSuccessRate = 1.0
         station.m_nextMode = 0
-        for i in range(len(station.m_mcsStats)):
-            station.Decay(i, decay, now)
-            frameSuccessRate = self.SampleBetaVariable(
-                1.0 + station.m_mcsStats[i].success,
-                1.0 + station.m_mcsStats[i].fails
-            )
-            rate = station.m_mcsStats[i].dataRate
-            if (frameSuccessRate * rate > maxThroughput):
-                maxThroughput = frameSuccessRate * rate
-                station.m_nextMode = i
+        stats = station.m_mcsStats
+        if len(stats) == 0:
+            return
+        station.DecayAll(decay, now)
+        frameSuccessRate = self.SampleBetaVariable(1.0 + stats['success'], 1.0 + stats['fails'])
+        throughput = frameSuccessRate * stats['dataRate']
+        # the first mode with the highest throughput, if any is above 0
+        station.m_nextMode = int(np.argmax(throughput))
         pass
 
 
@@ -103,9 +108,35 @@ class AiThompsonSamplingContainer:
 
     def __init__(self, msgInterface=None, stream=1) -> None:
         self.msgInterface = msgInterface
+        # NumPy views of the messages in shared memory, for the stats arrays
+        self.envView = msgInterface.GetCpp2PyStructView()
+        self.actView = msgInterface.GetPy2CppStructView()
         self.default_stream = stream
         pass
 
+    def report(self, env: py_binding.PyEnvStruct):
+        # reports are posted by ns-3 without waiting for a reply
+        man = self.wifiManager[env.managerId]
+        sta = self.wifiStation[env.stationId]
+        decay = env.data.decay.decay
+        now = env.data.decay.now
+        if env.type == 0x05:  # DoReportDataFailed
+            sta.DoReportDataFailed(decay, now)
+        elif env.type == 0x06:  # DoReportDataOk
+            sta.DoReportDataOk(decay, now)
+        elif env.type == 0x07:  # DoReportAmpduTxStatus
+            successful = env.var >> 32
+            failed = env.var & 0xffffffff
+            sta.DoReportAmpduTxStatus(decay, now, successful, failed)
+        man.UpdateNextMode(sta, decay, now)
+
+    def drain(self):
+        # apply all reports posted before the pending request, in order
+        n = self.msgInterface.PyDrainBegin()
+        for i in range(n):
+            self.report(self.msgInterface.GetPostedStruct(i))
+        self.msgInterface.PyDrainEnd(n)
+
     def do(self, env: py_binding.PyEnvStruct, act: py_binding.PyActStruct):
         if env.type == 0x01:  # AiThompsonSamplingWifiManager
             n_manager = len(self.wifiManager)
@@ -120,10 +151,10 @@ class AiThompsonSamplingContainer:
 
         elif env.type == 0x03:  # InitializeStation
             sta = self.wifiStation[env.stationId]
-            for i in range(64):
-                if env.data.stats[i].lastDecay < 0:
-                    break
-                sta.m_mcsStats.append(copy.copy(env.data.stats[i]))
+            # the valid modes end at the first negative lastDecay
+            stats = self.envView['data']['stats']
+            invalid = np.flatnonzero(stats['lastDecay'] < 0)
+            sta.m_mcsStats = stats[:invalid[0] if invalid.size else len(stats)].copy()
             # print('{} > {} sta {} msc {}'.format(env.managerId, env.type, env.stationId, len(sta.m_mcsStats)))
             act.stationId = env.stationId  # only for check
 
@@ -133,36 +164,10 @@ class AiThompsonSamplingContainer:
             sta.Decay(env.data.decay.decayIdx, env.data.decay.decay, env.data.decay.now)
             act.stationId = env.stationId  # only for check
 
-        elif env.type == 0x05:  # DoReportDataFailed
-            # print('{} > {} sta {} failed'.format(env.managerId, env.type, env.stationId))
-            man = self.wifiManager[env.managerId]
-            sta = self.wifiStation[env.stationId]
-            sta.DoReportDataFailed(env.data.decay.decay, env.data.decay.now)
-            man.UpdateNextMode(sta, env.data.decay.decay, env.data.decay.now)
-            act.stationId = env.stationId  # only for check
-
-        elif env.type == 0x06:  # DoReportDataOk
-            # print('{} > {} sta {} ok'.format(env.managerId, env.type, env.stationId))
-            man = self.wifiManager[env.managerId]
-            sta = self.wifiStation[env.stationId]
-            sta.DoReportDataOk(env.data.decay.decay, env.data.decay.now)
-            man.UpdateNextMode(sta, env.data.decay.decay, env.data.decay.now)
-            act.stationId = env.stationId  # only for check
-
-        elif env.type == 0x07:  # DoReportAmpduTxStatus
-            man = self.wifiManager[env.managerId]
-            sta = self.wifiStation[env.stationId]
-            successful = env.var >> 32
-            failed = env.var & 0xffffffff
-            # print('{} > {} sta {} ampdu {}/{}'.format(env.managerId, env.type, env.stationId, successful, failed))
-            sta.DoReportAmpduTxStatus(env.data.decay.decay, env.data.decay.now, successful, failed)
-            man.UpdateNextMode(sta, env.data.decay.decay, env.data.decay.now)
-            act.stationId = env.stationId  # only for check
-
         elif env.type == 0x08:  # DoGetDataTxVector
             sta = self.wifiStation[env.stationId]
             act.res = sta.m_nextMode
-            act.stats = sta.m_mcsStats[sta.m_nextMode]
+            self.actView['stats'] = sta.m_mcsStats[sta.m_nextMode]
             sta.m_lastMode = sta.m_nextMode
             # print('{} > {} sta {} dv {}/{}'.
             #       format(env.managerId, env.type, env.stationId, act.res, len(sta.m_mcsStats)))
@@ -170,7 +175,7 @@ class AiThompsonSamplingContainer:
         elif env.type == 0x09:  # DoGetRtsTxVector
             sta = self.wifiStation[env.stationId]
             act.res = 0
-            act.stats = sta.m_mcsStats[0]
+            self.actView['stats'] = sta.m_mcsStats[0]
 
         elif env.type == 0x0a:  # UpdateNextMode
             # print('{} > {} sta {} up {}, {}'.
@@ -187,17 +192,22 @@ ns3Settings = {
     'standard': '11ac',
     'duration': 5}
 
-exp = Experiment("ns3ai_ratecontrol_ts", "../../../../../", py_binding, handleFinish=True)
+exp = Experiment("ns3ai_ratecontrol_ts", "../../../../../", py_binding, handleFinish=True,
+                 postCapacity=256)
 msgInterface = exp.run(setting=ns3Settings, show_output=True)
 random_stream = 100
 c = AiThompsonSamplingContainer(msgInterface=msgInterface, stream=random_stream)
 
 try:
     while True:
-        c.msgInterface.PyRecvBegin()
+        # ns-3 may fill the ring of reports before its next request
+        if not c.msgInterface.PyRecvOrDrainBegin():
+            c.drain()
+            continue
         c.msgInterface.PySendBegin()
         if c.msgInterface.PyGetFinished():
             break
+        c.drain()
         c.do(c.msgInterface.GetCpp2PyStruct(), c.msgInterface.GetPy2CppStruct())
         c.msgInterface.PyRecvEnd()
         c.msgInterface.PySendEnd()
@@ -18,6 +18,7 @@
  */
 
 #include "ai-thompson-sampling-wifi-manager.h"
+#include "ns3-ai-msg-binding.h"
 
 #include <ns3/ai-module.h>
 
@@ -33,15 +34,16 @@ PYBIND11_MAKE_OPAQUE(std::array<ns3::ThompsonSamplingRateStats, 64>);  // Opaque
 
 PYBIND11_MODULE(ns3ai_ratecontrol_ts_py, m)
 {
-    py::class_<ns3::ThompsonSamplingRateStats>(m, "ThompsonSamplingRateStats")
-        .def(py::init<>())
-        .def_readwrite("nss", &ns3::ThompsonSamplingRateStats::nss)
-        .def_readwrite("channelWidth", &ns3::ThompsonSamplingRateStats::channelWidth)
-        .def_readwrite("guardInterval", &ns3::ThompsonSamplingRateStats::guardInterval)
-        .def_readwrite("dataRate", &ns3::ThompsonSamplingRateStats::dataRate)
-        .def_readwrite("success", &ns3::ThompsonSamplingRateStats::success)
-        .def_readwrite("fails", &ns3::ThompsonSamplingRateStats::fails)
-        .def_readwrite("lastDecay", &ns3::ThompsonSamplingRateStats::lastDecay)
+    NS3_AI_PY_STRUCT(m,
+                     ns3::ThompsonSamplingRateStats,
+                     "ThompsonSamplingRateStats",
+                     nss,
+                     channelWidth,
+                     guardInterval,
+                     dataRate,
+                     success,
+                     fails,
+                     lastDecay)
         .def("__copy__", [](const ns3::ThompsonSamplingRateStats& self) {       // Creating copy of the object in python. [] means that the function is overloaded
             return ns3::ThompsonSamplingRateStats(self);
         });
@@ -62,66 +64,41 @@ PYBIND11_MODULE(ns3ai_ratecontrol_ts_py, m)
                  return arr.at(i);
              });
 
-    py::class_<ns3::ThompsonSamplingEnvDecay>(m, "ThompsonSamplingEnvDecay")
-        .def(py::init<>())
-        .def_readwrite("decayIdx", &ns3::ThompsonSamplingEnvDecay::decayIdx)
-        .def_readwrite("decay", &ns3::ThompsonSamplingEnvDecay::decay)
-        .def_readwrite("now", &ns3::ThompsonSamplingEnvDecay::now);
+    NS3_AI_PY_STRUCT(m,
+                     ns3::ThompsonSamplingEnvDecay,
+                     "ThompsonSamplingEnvDecay",
+                     decayIdx,
+                     decay,
+                     now);
 
-    py::class_<ns3::ThompsonSamplingEnvPayloadStruct>(m, "ThompsonSamplingEnvPayloadStruct")
-        .def(py::init<>())
-        .def_readwrite("stats", &ns3::ThompsonSamplingEnvPayloadStruct::stats)  // stats is a ThompsonSamplingRateStatsArray. But python will see it as a class with attributes
-        .def_readwrite("decay", &ns3::ThompsonSamplingEnvPayloadStruct::decay);
+    // stats is a ThompsonSamplingRateStatsArray. But python will see it as a class with attributes
+    NS3_AI_PY_STRUCT(m,
+                     ns3::ThompsonSamplingEnvPayloadStruct,
+                     "ThompsonSamplingEnvPayloadStruct",
+                     stats,
+                     decay);
 
-    py::class_<ns3::AiThompsonSamplingEnvStruct>(m, "PyEnvStruct")
-        .def(py::init<>())
-        .def_readwrite("type", &ns3::AiThompsonSamplingEnvStruct::type)
-        .def_readwrite("managerId", &ns3::AiThompsonSamplingEnvStruct::managerId)
-        .def_readwrite("stationId", &ns3::AiThompsonSamplingEnvStruct::stationId)
-        .def_readwrite("var", &ns3::AiThompsonSamplingEnvStruct::var)
-        .def_readwrite("data", &ns3::AiThompsonSamplingEnvStruct::data);
+    NS3_AI_PY_STRUCT(m,
+                     ns3::AiThompsonSamplingEnvStruct,
+                     "PyEnvStruct",
+                     type,
+                     managerId,
+                     stationId,
+                     var,
+                     data);
 
-    py::class_<ns3::AiThompsonSamplingActStruct>(m, "PyActStruct")
-        .def(py::init<>())
-        .def_readwrite("managerId", &ns3::AiThompsonSamplingActStruct::managerId)
-        .def_readwrite("stationId", &ns3::AiThompsonSamplingActStruct::stationId)
-        .def_readwrite("res", &ns3::AiThompsonSamplingActStruct::res)
-        .def_readwrite("stats", &ns3::AiThompsonSamplingActStruct::stats);
+    NS3_AI_PY_STRUCT(m,
+                     ns3::AiThompsonSamplingActStruct,
+                     "PyActStruct",
+                     managerId,
+                     stationId,
+                     res,
+                     stats);
+
+    ns3::Ns3AiPyDefStats(m);
+    ns3::Ns3AiPyDefSubscriber<ns3::AiThompsonSamplingEnvStruct>(m);
 
-    // Handling message exchange between Python and C++
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<ns3::AiThompsonSamplingEnvStruct,
-                                          ns3::AiThompsonSamplingActStruct>>(
-        m,
-        "Ns3AiMsgInterfaceImpl")
-        .def(py::init<bool,
-                      bool,
-                      bool,
-                      uint32_t,
-                      const char*,
-                      const char*,
-                      const char*,
-                      const char*>())
-        .def("PyRecvBegin",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiThompsonSamplingEnvStruct,
-                                         ns3::AiThompsonSamplingActStruct>::PyRecvBegin)
-        .def("PyRecvEnd",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiThompsonSamplingEnvStruct,
-                                         ns3::AiThompsonSamplingActStruct>::PyRecvEnd)
-        .def("PySendBegin",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiThompsonSamplingEnvStruct,
-                                         ns3::AiThompsonSamplingActStruct>::PySendBegin)
-        .def("PySendEnd",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiThompsonSamplingEnvStruct,
-                                         ns3::AiThompsonSamplingActStruct>::PySendEnd)
-        .def("PyGetFinished",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiThompsonSamplingEnvStruct,
-                                         ns3::AiThompsonSamplingActStruct>::PyGetFinished)
-        .def("GetCpp2PyStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiThompsonSamplingEnvStruct,
-                                         ns3::AiThompsonSamplingActStruct>::GetCpp2PyStruct,
-             py::return_value_policy::reference)
-        .def("GetPy2CppStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::AiThompsonSamplingEnvStruct,
-                                         ns3::AiThompsonSamplingActStruct>::GetPy2CppStruct,
-             py::return_value_policy::reference);
+    auto msgInterface = ns3::Ns3AiPyDefInterface<ns3::AiThompsonSamplingEnvStruct,
+                                                  ns3::AiThompsonSamplingActStruct>(m);
+    ns3::Ns3AiPyDefStructViews(msgInterface);
 }
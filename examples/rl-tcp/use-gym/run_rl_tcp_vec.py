@@ -0,0 +1,105 @@
+# Copyright (c) 2020-2023 Huazhong University of Science and Technology
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License version 2 as
+# published by the Free Software Foundation;
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+# Author: Pengyu Liu <eic_lpy@hust.edu.cn>
+#         Hao Yin <haoyin@uw.edu>
+#         Muyuan Shen <muyuan_shen@hust.edu.cn>
+
+# Runs several rl-tcp simulations at once behind one vectorized environment.
+# A simulation whose episode ends restarts in the same step with the next
+# run number (simSeed), until the given number of steps is done.
+
+import torch
+import argparse
+import numpy as np
+from agents import TcpNewRenoAgent, TcpDeepQAgent, TcpQAgent
+from ns3ai_gym_env.envs import Ns3VectorEnv
+import sys
+import traceback
+
+
+def new_agent(useRl):
+    if useRl:
+        if args.rl_algo == 'DeepQ':
+            return TcpDeepQAgent()
+        return TcpQAgent()
+    return TcpNewRenoAgent()
+
+
+parser = argparse.ArgumentParser()
+parser.add_argument('--num_envs', type=int, default=4,
+                    help='number of simulations running at once')
+parser.add_argument('--steps', type=int, default=2000,
+                    help='number of steps of every simulation')
+parser.add_argument('--seed', type=int, default=42,
+                    help='set seed for reproducibility, of both sides')
+parser.add_argument('--duration', type=float, default=10,
+                    help='set simulation duration (seconds) of an episode')
+parser.add_argument('--use_rl', action='store_true',
+                    help='whether use rl algorithm')
+parser.add_argument('--rl_algo', type=str,
+                    default='DeepQ', help='RL Algorithm, Q or DeepQ')
+
+args = parser.parse_args()
+print("Python side random seed {}".format(args.seed))
+np.random.seed(args.seed)
+torch.manual_seed(args.seed)
+
+if args.use_rl:
+    if (args.rl_algo != 'Q') and (args.rl_algo != 'DeepQ'):
+        print("Invalid RL Algorithm {}".format(args.rl_algo))
+        exit(1)
+
+ns3Settings = {
+    'transport_prot': 'TcpRlTimeBased',
+    'duration': args.duration}
+envs = Ns3VectorEnv(targetName="ns3ai_rltcp_gym", ns3Path="../../../../../",
+                    numEnvs=args.num_envs, ns3Settings=ns3Settings, seedKey='simSeed')
+print("Observation space: ", envs.single_observation_space)
+print("Action space: ", envs.single_action_space)
+
+try:
+    # episode n of simulation i runs with simSeed = seed + i + n * num_envs
+    obs, infos = envs.reset(seed=args.seed)
+    rewards = np.zeros(args.num_envs)
+    dones = np.zeros(args.num_envs, dtype=np.bool_)
+    # one agent per simulation, which keeps learning over its episodes
+    tcpAgents = [new_agent(args.use_rl) for _ in range(args.num_envs)]
+    episodes = 0
+
+    for step in range(args.steps):
+        actions = np.array([agent.get_action(obs[i], rewards[i], dones[i], {})
+                            for i, agent in enumerate(tcpAgents)],
+                           dtype=envs.single_action_space.dtype)
+        obs, rewards, terminations, truncations, infos = envs.step(actions)
+        dones = terminations | truncations
+        for i in np.flatnonzero(dones):
+            episodes += 1
+            print("Step {}: simulation {} ended, its next episode starts".format(step, i))
+
+except Exception as e:
+    exc_type, exc_value, exc_traceback = sys.exc_info()
+    print("Exception occurred: {}".format(e))
+    print("Traceback:")
+    traceback.print_tb(exc_traceback)
+    exit(1)
+
+else:
+    print("{} episodes ended in {} steps of {} simulations".format(
+        episodes, args.steps, args.num_envs))
+
+finally:
+    print("Finally exiting...")
+    envs.close()
@@ -19,6 +19,8 @@
 
 #include "tcp-rl-env.h"
 
+#include "ns3-ai-msg-binding.h"
+
 #include <ns3/ai-module.h>
 
 #include <pybind11/pybind11.h>
@@ -27,42 +29,27 @@ namespace py = pybind11;
 
 PYBIND11_MODULE(ns3ai_rltcp_msg_py, m)
 {
-    py::class_<ns3::TcpRlEnv>(m, "PyEnvStruct")
-        .def(py::init<>())
-        .def_readwrite("nodeId", &ns3::TcpRlEnv::nodeId)
-        .def_readwrite("socketUid", &ns3::TcpRlEnv::socketUid)
-        .def_readwrite("envType", &ns3::TcpRlEnv::envType)
-        .def_readwrite("simTime_us", &ns3::TcpRlEnv::simTime_us)
-        .def_readwrite("ssThresh", &ns3::TcpRlEnv::ssThresh)
-        .def_readwrite("cWnd", &ns3::TcpRlEnv::cWnd)
-        .def_readwrite("segmentSize", &ns3::TcpRlEnv::segmentSize)
-        .def_readwrite("segmentsAcked", &ns3::TcpRlEnv::segmentsAcked)
-        .def_readwrite("bytesInFlight", &ns3::TcpRlEnv::bytesInFlight);
+    NS3_AI_PY_STRUCT(m,
+                     ns3::TcpRlEnv,
+                     "PyEnvStruct",
+                     nodeId,
+                     socketUid,
+                     envType,
+                     simTime_us,
+                     ssThresh,
+                     cWnd,
+                     segmentSize,
+                     segmentsAcked,
+                     bytesInFlight);
+
+    NS3_AI_PY_STRUCT(m, ns3::TcpRlAct, "PyActStruct", new_ssThresh, new_cWnd);
+
+    ns3::Ns3AiPyDefStats(m);
+    ns3::Ns3AiPyDefSubscriber<ns3::TcpRlEnv>(m);
 
-    py::class_<ns3::TcpRlAct>(m, "PyActStruct")
-        .def(py::init<>())
-        .def_readwrite("new_ssThresh", &ns3::TcpRlAct::new_ssThresh)
-        .def_readwrite("new_cWnd", &ns3::TcpRlAct::new_cWnd);
+    auto msgInterface = ns3::Ns3AiPyDefInterface<ns3::TcpRlEnv, ns3::TcpRlAct>(m);
+    ns3::Ns3AiPyDefStructViews(msgInterface);
 
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<ns3::TcpRlEnv, ns3::TcpRlAct>>(m, "Ns3AiMsgInterfaceImpl")
-        .def(py::init<bool,
-                      bool,
-                      bool,
-                      uint32_t,
-                      const char*,
-                      const char*,
-                      const char*,
-                      const char*>())
-        .def("PyRecvBegin", &ns3::Ns3AiMsgInterfaceImpl<ns3::TcpRlEnv, ns3::TcpRlAct>::PyRecvBegin)
-        .def("PyRecvEnd", &ns3::Ns3AiMsgInterfaceImpl<ns3::TcpRlEnv, ns3::TcpRlAct>::PyRecvEnd)
-        .def("PySendBegin", &ns3::Ns3AiMsgInterfaceImpl<ns3::TcpRlEnv, ns3::TcpRlAct>::PySendBegin)
-        .def("PySendEnd", &ns3::Ns3AiMsgInterfaceImpl<ns3::TcpRlEnv, ns3::TcpRlAct>::PySendEnd)
-        .def("PyGetFinished",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::TcpRlEnv, ns3::TcpRlAct>::PyGetFinished)
-        .def("GetCpp2PyStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::TcpRlEnv, ns3::TcpRlAct>::GetCpp2PyStruct,
-             py::return_value_policy::reference)
-        .def("GetPy2CppStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<ns3::TcpRlEnv, ns3::TcpRlAct>::GetPy2CppStruct,
-             py::return_value_policy::reference);
+    // for Experiment(..., ringCapacity=N), with GetRingInterface on C++ side
+    ns3::Ns3AiPyDefRing<ns3::TcpRlEnv, ns3::TcpRlAct>(m);
 }
@@ -21,6 +21,8 @@
 
 #include "container.h"
 
+#include <ns3/abort.h>
+#include <ns3/assert.h>
 #include <ns3/log.h>
 
 namespace ns3
@@ -30,6 +32,246 @@ NS_LOG_COMPONENT_DEFINE("OpenGymDataContainer");
 
 NS_OBJECT_ENSURE_REGISTERED(OpenGymDataContainer);
 
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+/**
+ * Gets the type URL of the Any holding the message of a container type
+ */
+static const std::string&
+GetDataContainerTypeUrl(ns3_ai_gym::SpaceType type)
+{
+    static const std::string typeUrls[] = {
+        "",
+        "type.googleapis.com/ns3_ai_gym.DiscreteDataContainer",
+        "type.googleapis.com/ns3_ai_gym.BoxDataContainer",
+        "type.googleapis.com/ns3_ai_gym.TupleDataContainer",
+        "type.googleapis.com/ns3_ai_gym.DictDataContainer",
+    };
+    return typeUrls[type];
+}
+
+/**
+ * Gets the bytes of the Any of a DataContainer message
+ */
+static std::size_t
+GetAnyPbSize(ns3_ai_gym::SpaceType type, std::size_t valueSize)
+{
+    std::size_t typeUrlSize = GetDataContainerTypeUrl(type).size();
+    std::size_t size = 1 + CodedOutputStream::VarintSize64(typeUrlSize) + typeUrlSize;
+    if (valueSize)
+    {
+        size += 1 + CodedOutputStream::VarintSize64(valueSize) + valueSize;
+    }
+    return size;
+}
+
+/**
+ * Fields of an encoded DataContainer message, pointing into it
+ */
+struct DataContainerPbFields
+{
+    ns3_ai_gym::SpaceType type{ns3_ai_gym::NoSpaceType};
+    const uint8_t* value{nullptr}; //!< the encoded message in the Any
+    std::size_t valueSize{0};
+    const uint8_t* name{nullptr};
+    std::size_t nameSize{0};
+};
+
+/**
+ * Reads a length-delimited field, leaving data pointing at its bytes
+ */
+static bool
+ReadPbBytes(CodedInputStream* in, const uint8_t* start, const uint8_t** data, std::size_t* size)
+{
+    uint32_t length;
+    if (!in->ReadVarint32(&length))
+    {
+        return false;
+    }
+    *data = start + in->CurrentPosition();
+    *size = length;
+    return in->Skip(length);
+}
+
+/**
+ * Finds the fields of an encoded DataContainer message, without decoding
+ * the message in its Any
+ */
+static bool
+ParseDataContainerPb(const uint8_t* data, std::size_t size, DataContainerPbFields* fields)
+{
+    CodedInputStream in(data, size);
+    uint32_t tag;
+    while ((tag = in.ReadTag()) != 0)
+    {
+        uint32_t field = WireFormatLite::GetTagFieldNumber(tag);
+        bool ok;
+        if (field == ns3_ai_gym::DataContainer::kTypeFieldNumber)
+        {
+            uint32_t type;
+            ok = in.ReadVarint32(&type) && ns3_ai_gym::SpaceType_IsValid(type);
+            fields->type = static_cast<ns3_ai_gym::SpaceType>(type);
+        }
+        else if (field == ns3_ai_gym::DataContainer::kDataFieldNumber)
+        {
+            const uint8_t* any;
+            std::size_t anySize;
+            ok = ReadPbBytes(&in, data, &any, &anySize);
+            // the Any: its type URL, which the type tells, and its value
+            CodedInputStream anyIn(any, anySize);
+            while (ok && (tag = anyIn.ReadTag()) != 0)
+            {
+                ok = WireFormatLite::GetTagFieldNumber(tag) == 2
+                         ? ReadPbBytes(&anyIn, any, &fields->value, &fields->valueSize)
+                         : WireFormatLite::SkipField(&anyIn, tag);
+            }
+        }
+        else if (field == ns3_ai_gym::DataContainer::kNameFieldNumber)
+        {
+            ok = ReadPbBytes(&in, data, &fields->name, &fields->nameSize);
+        }
+        else
+        {
+            ok = WireFormatLite::SkipField(&in, tag);
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Counts the elements of an encoded TupleDataContainer or DictDataContainer
+ */
+static bool
+CountPbElements(const uint8_t* data, std::size_t size, std::size_t* count)
+{
+    CodedInputStream in(data, size);
+    *count = 0;
+    uint32_t tag;
+    while ((tag = in.ReadTag()) != 0)
+    {
+        if (WireFormatLite::GetTagFieldNumber(tag) == 1)
+        {
+            ++*count;
+        }
+        if (!WireFormatLite::SkipField(&in, tag))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+OpenGymDataContainerPbLayout::OpenGymDataContainerPbLayout()
+    : m_msgCount(0),
+      m_raw(false),
+      m_rawSize(0),
+      m_rawArea(nullptr),
+      m_nextEntry(0),
+      m_nextMsg(0)
+{
+}
+
+void
+OpenGymDataContainerPbLayout::Clear(bool raw)
+{
+    m_entries.clear();
+    m_msgCount = 0;
+    m_raw = raw;
+    m_rawSize = 0;
+    m_rawArea = nullptr;
+    m_nextEntry = 0;
+    m_nextMsg = 0;
+}
+
+bool
+OpenGymDataContainerPbLayout::IsRaw() const
+{
+    return m_raw;
+}
+
+uint64_t
+OpenGymDataContainerPbLayout::AddRaw(uint64_t bytes)
+{
+    uint64_t offset =
+        (m_rawSize + NS3_AI_GYM_RAW_ALIGN - 1) & ~uint64_t(NS3_AI_GYM_RAW_ALIGN - 1);
+    m_rawSize = offset + bytes;
+    return offset;
+}
+
+uint64_t
+OpenGymDataContainerPbLayout::GetRawSize() const
+{
+    return m_rawSize;
+}
+
+std::size_t
+OpenGymDataContainerPbLayout::AddEntry()
+{
+    m_entries.emplace_back();
+    return m_entries.size() - 1;
+}
+
+OpenGymDataContainerPbLayout::Entry&
+OpenGymDataContainerPbLayout::GetEntry(std::size_t index)
+{
+    return m_entries[index];
+}
+
+ns3_ai_gym::DataContainer*
+OpenGymDataContainerPbLayout::AddMsg()
+{
+    if (m_msgCount == m_msgs.size())
+    {
+        m_msgs.emplace_back();
+    }
+    return &m_msgs[m_msgCount++];
+}
+
+void
+OpenGymDataContainerPbLayout::BeginWrite(uint8_t* raw)
+{
+    NS_ASSERT_MSG(raw || !m_rawSize, "The raw area is missing");
+    m_rawArea = raw;
+    m_nextEntry = 0;
+    m_nextMsg = 0;
+}
+
+const OpenGymDataContainerPbLayout::Entry&
+OpenGymDataContainerPbLayout::NextEntry()
+{
+    NS_ASSERT_MSG(m_nextEntry < m_entries.size(),
+                  "WriteDataContainerPb of a container GetDataContainerPbSize did not size");
+    return m_entries[m_nextEntry++];
+}
+
+const OpenGymDataContainerPbLayout::Entry&
+OpenGymDataContainerPbLayout::PeekEntry() const
+{
+    NS_ASSERT_MSG(m_nextEntry < m_entries.size(),
+                  "WriteDataContainerPb of a container GetDataContainerPbSize did not size");
+    return m_entries[m_nextEntry];
+}
+
+const ns3_ai_gym::DataContainer&
+OpenGymDataContainerPbLayout::NextMsg()
+{
+    NS_ASSERT_MSG(m_nextMsg < m_msgCount,
+                  "WriteDataContainerPb of a container GetDataContainerPbSize did not size");
+    return m_msgs[m_nextMsg++];
+}
+
+uint8_t*
+OpenGymDataContainerPbLayout::GetRawArea() const
+{
+    return m_rawArea;
+}
+
 TypeId
 OpenGymDataContainer::GetTypeId()
 {
@@ -60,8 +302,147 @@ OpenGymDataContainer::DoInitialize()
     // NS_LOG_FUNCTION (this);
 }
 
+std::size_t
+OpenGymDataContainer::GetDataContainerPbSize(const std::string& name,
+                                             OpenGymDataContainerPbLayout* layout)
+{
+    ns3_ai_gym::DataContainer* dataContainerPbMsg = layout->AddMsg();
+    *dataContainerPbMsg = GetDataContainerPbMsg();
+    dataContainerPbMsg->set_name(name);
+    OpenGymDataContainerPbLayout::Entry& entry = layout->GetEntry(layout->AddEntry());
+    entry.size = dataContainerPbMsg->ByteSizeLong();
+    return entry.size;
+}
+
+void
+OpenGymDataContainer::WriteDataContainerPb(CodedOutputStream* out,
+                                           const std::string& name,
+                                           OpenGymDataContainerPbLayout* layout) const
+{
+    layout->NextEntry();
+    layout->NextMsg().SerializeWithCachedSizes(out);
+}
+
+bool
+OpenGymDataContainer::ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                                          const uint8_t* data,
+                                          std::size_t size,
+                                          const uint8_t* raw,
+                                          uint64_t rawSize)
+{
+    return false;
+}
+
+std::size_t
+OpenGymDataContainer::ComputeDataContainerPbSize(ns3_ai_gym::SpaceType type,
+                                                 std::size_t valueSize,
+                                                 const std::string& name)
+{
+    std::size_t anySize = GetAnyPbSize(type, valueSize);
+    std::size_t size = 1 + CodedOutputStream::VarintSize64(anySize) + anySize;
+    if (type != ns3_ai_gym::NoSpaceType)
+    {
+        size += 1 + CodedOutputStream::VarintSize32(type);
+    }
+    if (!name.empty())
+    {
+        size += 1 + CodedOutputStream::VarintSize64(name.size()) + name.size();
+    }
+    return size;
+}
+
+void
+OpenGymDataContainer::WriteDataContainerPbBegin(CodedOutputStream* out,
+                                                ns3_ai_gym::SpaceType type,
+                                                std::size_t valueSize)
+{
+    if (type != ns3_ai_gym::NoSpaceType)
+    {
+        WireFormatLite::WriteEnum(ns3_ai_gym::DataContainer::kTypeFieldNumber, type, out);
+    }
+    WireFormatLite::WriteTag(ns3_ai_gym::DataContainer::kDataFieldNumber,
+                             WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                             out);
+    out->WriteVarint64(GetAnyPbSize(type, valueSize));
+    WireFormatLite::WriteString(1, GetDataContainerTypeUrl(type), out);
+    if (valueSize)
+    {
+        WireFormatLite::WriteTag(2, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, out);
+        out->WriteVarint64(valueSize);
+    }
+}
+
+void
+OpenGymDataContainer::WriteDataContainerPbEnd(CodedOutputStream* out, const std::string& name)
+{
+    if (!name.empty())
+    {
+        WireFormatLite::WriteString(ns3_ai_gym::DataContainer::kNameFieldNumber, name, out);
+    }
+}
+
+Ptr<OpenGymDataContainer>
+OpenGymDataContainer::CreateFromDataContainerPb(const uint8_t* data,
+                                                std::size_t size,
+                                                const uint8_t* raw,
+                                                uint64_t rawSize,
+                                                const Ptr<OpenGymDataContainer>& reuse)
+{
+    DataContainerPbFields fields;
+    if (reuse && ParseDataContainerPb(data, size, &fields) &&
+        reuse->ReadDataContainerPb(fields.type, fields.value, fields.valueSize, raw, rawSize))
+    {
+        return reuse;
+    }
+    // another structure: decode the whole message and create new containers
+    ns3_ai_gym::DataContainer dataContainerPbMsg;
+    NS_ABORT_MSG_IF(!dataContainerPbMsg.ParseFromArray(data, size),
+                    "Invalid DataContainer message");
+    return CreateFromDataContainerPbMsg(dataContainerPbMsg, raw, rawSize);
+}
+
+/**
+ * Creates a Box container from the repeated field of its items, or from the
+ * raw area if the data is there
+ */
+template <typename T, typename Field>
+static Ptr<OpenGymDataContainer>
+CreateBoxContainer(const ns3_ai_gym::BoxDataContainer& boxContainerPbMsg,
+                   const Field& field,
+                   const uint8_t* raw,
+                   uint64_t rawSize)
+{
+    Ptr<OpenGymBoxContainer<T>> box = CreateObject<OpenGymBoxContainer<T>>(
+        std::vector<uint32_t>(boxContainerPbMsg.shape().begin(), boxContainerPbMsg.shape().end()));
+    std::vector<T> myData;
+    if (boxContainerPbMsg.raw())
+    {
+        uint64_t offset = boxContainerPbMsg.rawoffset();
+        uint64_t count = boxContainerPbMsg.count();
+        NS_ABORT_MSG_IF(boxContainerPbMsg.itemsize() != sizeof(T) ||
+                            offset > rawSize || count > (rawSize - offset) / sizeof(T),
+                        "Invalid raw data of a Box container");
+        myData.resize(count);
+        std::memcpy(myData.data(), raw + offset, count * sizeof(T));
+    }
+    else
+    {
+        myData.assign(field.begin(), field.end());
+    }
+    box->SetData(myData);
+    return box;
+}
+
 Ptr<OpenGymDataContainer>
 OpenGymDataContainer::CreateFromDataContainerPbMsg(ns3_ai_gym::DataContainer& dataContainerPbMsg)
+{
+    return CreateFromDataContainerPbMsg(dataContainerPbMsg, nullptr, 0);
+}
+
+Ptr<OpenGymDataContainer>
+OpenGymDataContainer::CreateFromDataContainerPbMsg(ns3_ai_gym::DataContainer& dataContainerPbMsg,
+                                                   const uint8_t* raw,
+                                                   uint64_t rawSize)
 {
     Ptr<OpenGymDataContainer> actDataContainer;
 
@@ -81,46 +462,31 @@ OpenGymDataContainer::CreateFromDataContainerPbMsg(ns3_ai_gym::DataContainer& da
 
         if (boxContainerPbMsg.dtype() == ns3_ai_gym::INT)
         {
-            Ptr<OpenGymBoxContainer<int32_t>> box = CreateObject<OpenGymBoxContainer<int32_t>>();
-            std::vector<int32_t> myData;
-            myData.assign(boxContainerPbMsg.intdata().begin(), boxContainerPbMsg.intdata().end());
-            box->SetData(myData);
-            actDataContainer = box;
+            actDataContainer = CreateBoxContainer<int32_t>(boxContainerPbMsg,
+                                                           boxContainerPbMsg.intdata(),
+                                                           raw,
+                                                           rawSize);
         }
         else if (boxContainerPbMsg.dtype() == ns3_ai_gym::UINT)
         {
-            Ptr<OpenGymBoxContainer<uint32_t>> box = CreateObject<OpenGymBoxContainer<uint32_t>>();
-            std::vector<uint32_t> myData;
-            myData.assign(boxContainerPbMsg.uintdata().begin(), boxContainerPbMsg.uintdata().end());
-            box->SetData(myData);
-            actDataContainer = box;
-        }
-        else if (boxContainerPbMsg.dtype() == ns3_ai_gym::FLOAT)
-        {
-            Ptr<OpenGymBoxContainer<float>> box = CreateObject<OpenGymBoxContainer<float>>();
-            std::vector<float> myData;
-            myData.assign(boxContainerPbMsg.floatdata().begin(),
-                          boxContainerPbMsg.floatdata().end());
-            box->SetData(myData);
-            actDataContainer = box;
+            actDataContainer = CreateBoxContainer<uint32_t>(boxContainerPbMsg,
+                                                            boxContainerPbMsg.uintdata(),
+                                                            raw,
+                                                            rawSize);
         }
         else if (boxContainerPbMsg.dtype() == ns3_ai_gym::DOUBLE)
         {
-            Ptr<OpenGymBoxContainer<double>> box = CreateObject<OpenGymBoxContainer<double>>();
-            std::vector<double> myData;
-            myData.assign(boxContainerPbMsg.doubledata().begin(),
-                          boxContainerPbMsg.doubledata().end());
-            box->SetData(myData);
-            actDataContainer = box;
+            actDataContainer = CreateBoxContainer<double>(boxContainerPbMsg,
+                                                          boxContainerPbMsg.doubledata(),
+                                                          raw,
+                                                          rawSize);
         }
         else
         {
-            Ptr<OpenGymBoxContainer<float>> box = CreateObject<OpenGymBoxContainer<float>>();
-            std::vector<float> myData;
-            myData.assign(boxContainerPbMsg.floatdata().begin(),
-                          boxContainerPbMsg.floatdata().end());
-            box->SetData(myData);
-            actDataContainer = box;
+            actDataContainer = CreateBoxContainer<float>(boxContainerPbMsg,
+                                                         boxContainerPbMsg.floatdata(),
+                                                         raw,
+                                                         rawSize);
         }
     }
     else if (dataContainerPbMsg.type() == ns3_ai_gym::Tuple)
@@ -137,7 +503,7 @@ OpenGymDataContainer::CreateFromDataContainerPbMsg(ns3_ai_gym::DataContainer& da
         for (it = elements.begin(); it != elements.end(); ++it)
         {
             Ptr<OpenGymDataContainer> subData =
-                OpenGymDataContainer::CreateFromDataContainerPbMsg(*it);
+                OpenGymDataContainer::CreateFromDataContainerPbMsg(*it, raw, rawSize);
             tupleData->Add(subData);
         }
 
@@ -157,7 +523,7 @@ OpenGymDataContainer::CreateFromDataContainerPbMsg(ns3_ai_gym::DataContainer& da
         for (it = elements.begin(); it != elements.end(); ++it)
         {
             Ptr<OpenGymDataContainer> subSpace =
-                OpenGymDataContainer::CreateFromDataContainerPbMsg(*it);
+                OpenGymDataContainer::CreateFromDataContainerPbMsg(*it, raw, rawSize);
             dictData->Add((*it).name(), subSpace);
         }
 
@@ -208,15 +574,72 @@ OpenGymDiscreteContainer::DoInitialize()
 ns3_ai_gym::DataContainer
 OpenGymDiscreteContainer::GetDataContainerPbMsg()
 {
-    ns3_ai_gym::DataContainer dataContainerPbMsg;
     ns3_ai_gym::DiscreteDataContainer discreteContainerPbMsg;
     discreteContainerPbMsg.set_data(GetValue());
 
+    ns3_ai_gym::DataContainer dataContainerPbMsg;
     dataContainerPbMsg.set_type(ns3_ai_gym::Discrete);
     dataContainerPbMsg.mutable_data()->PackFrom(discreteContainerPbMsg);
     return dataContainerPbMsg;
 }
 
+std::size_t
+OpenGymDiscreteContainer::GetDataContainerPbSize(const std::string& name,
+                                                 OpenGymDataContainerPbLayout* layout)
+{
+    OpenGymDataContainerPbLayout::Entry& entry = layout->GetEntry(layout->AddEntry());
+    if (m_value)
+    {
+        entry.valueSize = 1 + WireFormatLite::Int32Size(static_cast<int32_t>(m_value));
+    }
+    entry.size = ComputeDataContainerPbSize(ns3_ai_gym::Discrete, entry.valueSize, name);
+    return entry.size;
+}
+
+void
+OpenGymDiscreteContainer::WriteDataContainerPb(CodedOutputStream* out,
+                                               const std::string& name,
+                                               OpenGymDataContainerPbLayout* layout) const
+{
+    WriteDataContainerPbBegin(out, ns3_ai_gym::Discrete, layout->NextEntry().valueSize);
+    if (m_value)
+    {
+        WireFormatLite::WriteInt32(ns3_ai_gym::DiscreteDataContainer::kDataFieldNumber,
+                                   static_cast<int32_t>(m_value),
+                                   out);
+    }
+    WriteDataContainerPbEnd(out, name);
+}
+
+bool
+OpenGymDiscreteContainer::ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                                              const uint8_t* data,
+                                              std::size_t size,
+                                              const uint8_t* raw,
+                                              uint64_t rawSize)
+{
+    if (GetReferenceCount() > 1 || type != ns3_ai_gym::Discrete)
+    {
+        return false;
+    }
+    uint32_t value = 0;
+    CodedInputStream in(data, size);
+    uint32_t tag;
+    while ((tag = in.ReadTag()) != 0)
+    {
+        bool ok = WireFormatLite::GetTagFieldNumber(tag) ==
+                          ns3_ai_gym::DiscreteDataContainer::kDataFieldNumber
+                      ? in.ReadVarint32(&value)
+                      : WireFormatLite::SkipField(&in, tag);
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    SetValue(value);
+    return true;
+}
+
 bool
 OpenGymDiscreteContainer::SetValue(uint32_t value)
 {
@@ -275,20 +698,84 @@ OpenGymTupleContainer::GetDataContainerPbMsg()
     dataContainerPbMsg.set_type(ns3_ai_gym::Tuple);
 
     ns3_ai_gym::TupleDataContainer tupleContainerPbMsg;
-
-    std::vector<Ptr<OpenGymDataContainer>>::iterator it;
-    for (it = m_tuple.begin(); it != m_tuple.end(); ++it)
+    for (const Ptr<OpenGymDataContainer>& subSpace : m_tuple)
     {
-        Ptr<OpenGymDataContainer> subSpace = *it;
-        ns3_ai_gym::DataContainer subDataContainer = subSpace->GetDataContainerPbMsg();
-
-        tupleContainerPbMsg.add_element()->CopyFrom(subDataContainer);
+        *tupleContainerPbMsg.add_element() = subSpace->GetDataContainerPbMsg();
     }
 
     dataContainerPbMsg.mutable_data()->PackFrom(tupleContainerPbMsg);
     return dataContainerPbMsg;
 }
 
+std::size_t
+OpenGymTupleContainer::GetDataContainerPbSize(const std::string& name,
+                                              OpenGymDataContainerPbLayout* layout)
+{
+    // the elements append their entries after this one
+    std::size_t index = layout->AddEntry();
+    std::size_t valueSize = 0;
+    for (const Ptr<OpenGymDataContainer>& subSpace : m_tuple)
+    {
+        std::size_t subSize = subSpace->GetDataContainerPbSize(std::string(), layout);
+        valueSize += 1 + CodedOutputStream::VarintSize64(subSize) + subSize;
+    }
+    OpenGymDataContainerPbLayout::Entry& entry = layout->GetEntry(index);
+    entry.valueSize = valueSize;
+    entry.size = ComputeDataContainerPbSize(ns3_ai_gym::Tuple, valueSize, name);
+    return entry.size;
+}
+
+void
+OpenGymTupleContainer::WriteDataContainerPb(CodedOutputStream* out,
+                                            const std::string& name,
+                                            OpenGymDataContainerPbLayout* layout) const
+{
+    WriteDataContainerPbBegin(out, ns3_ai_gym::Tuple, layout->NextEntry().valueSize);
+    for (const Ptr<OpenGymDataContainer>& subSpace : m_tuple)
+    {
+        WireFormatLite::WriteTag(ns3_ai_gym::TupleDataContainer::kElementFieldNumber,
+                                 WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                                 out);
+        out->WriteVarint64(layout->PeekEntry().size);
+        subSpace->WriteDataContainerPb(out, std::string(), layout);
+    }
+    WriteDataContainerPbEnd(out, name);
+}
+
+bool
+OpenGymTupleContainer::ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                                           const uint8_t* data,
+                                           std::size_t size,
+                                           const uint8_t* raw,
+                                           uint64_t rawSize)
+{
+    std::size_t count;
+    if (GetReferenceCount() > 1 || type != ns3_ai_gym::Tuple ||
+        !CountPbElements(data, size, &count) || count != m_tuple.size())
+    {
+        return false;
+    }
+    CodedInputStream in(data, size);
+    std::size_t i = 0;
+    uint32_t tag;
+    while ((tag = in.ReadTag()) != 0)
+    {
+        if (WireFormatLite::GetTagFieldNumber(tag) !=
+            ns3_ai_gym::TupleDataContainer::kElementFieldNumber)
+        {
+            WireFormatLite::SkipField(&in, tag);
+            continue;
+        }
+        const uint8_t* element;
+        std::size_t elementSize;
+        ReadPbBytes(&in, data, &element, &elementSize);
+        // elements that cannot be decoded in place are replaced
+        m_tuple[i] = CreateFromDataContainerPb(element, elementSize, raw, rawSize, m_tuple[i]);
+        ++i;
+    }
+    return true;
+}
+
 bool
 OpenGymTupleContainer::Add(Ptr<OpenGymDataContainer> space)
 {
@@ -371,23 +858,95 @@ OpenGymDictContainer::GetDataContainerPbMsg()
     dataContainerPbMsg.set_type(ns3_ai_gym::Dict);
 
     ns3_ai_gym::DictDataContainer dictContainerPbMsg;
-
-    std::map<std::string, Ptr<OpenGymDataContainer>>::iterator it;
-    for (it = m_dict.begin(); it != m_dict.end(); ++it)
+    for (const auto& item : m_dict)
     {
-        std::string name = it->first;
-        Ptr<OpenGymDataContainer> subSpace = it->second;
-
-        ns3_ai_gym::DataContainer subDataContainer = subSpace->GetDataContainerPbMsg();
-        subDataContainer.set_name(name);
-
-        dictContainerPbMsg.add_element()->CopyFrom(subDataContainer);
+        ns3_ai_gym::DataContainer* subDataContainer = dictContainerPbMsg.add_element();
+        *subDataContainer = item.second->GetDataContainerPbMsg();
+        subDataContainer->set_name(item.first);
     }
 
     dataContainerPbMsg.mutable_data()->PackFrom(dictContainerPbMsg);
     return dataContainerPbMsg;
 }
 
+std::size_t
+OpenGymDictContainer::GetDataContainerPbSize(const std::string& name,
+                                             OpenGymDataContainerPbLayout* layout)
+{
+    // the elements append their entries after this one
+    std::size_t index = layout->AddEntry();
+    std::size_t valueSize = 0;
+    for (const auto& item : m_dict)
+    {
+        std::size_t subSize = item.second->GetDataContainerPbSize(item.first, layout);
+        valueSize += 1 + CodedOutputStream::VarintSize64(subSize) + subSize;
+    }
+    OpenGymDataContainerPbLayout::Entry& entry = layout->GetEntry(index);
+    entry.valueSize = valueSize;
+    entry.size = ComputeDataContainerPbSize(ns3_ai_gym::Dict, valueSize, name);
+    return entry.size;
+}
+
+void
+OpenGymDictContainer::WriteDataContainerPb(CodedOutputStream* out,
+                                           const std::string& name,
+                                           OpenGymDataContainerPbLayout* layout) const
+{
+    WriteDataContainerPbBegin(out, ns3_ai_gym::Dict, layout->NextEntry().valueSize);
+    for (const auto& item : m_dict)
+    {
+        WireFormatLite::WriteTag(ns3_ai_gym::DictDataContainer::kElementFieldNumber,
+                                 WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                                 out);
+        out->WriteVarint64(layout->PeekEntry().size);
+        item.second->WriteDataContainerPb(out, item.first, layout);
+    }
+    WriteDataContainerPbEnd(out, name);
+}
+
+bool
+OpenGymDictContainer::ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                                          const uint8_t* data,
+                                          std::size_t size,
+                                          const uint8_t* raw,
+                                          uint64_t rawSize)
+{
+    std::size_t count;
+    if (GetReferenceCount() > 1 || type != ns3_ai_gym::Dict ||
+        !CountPbElements(data, size, &count) || count != m_dict.size())
+    {
+        return false;
+    }
+    CodedInputStream in(data, size);
+    uint32_t tag;
+    while ((tag = in.ReadTag()) != 0)
+    {
+        if (WireFormatLite::GetTagFieldNumber(tag) !=
+            ns3_ai_gym::DictDataContainer::kElementFieldNumber)
+        {
+            WireFormatLite::SkipField(&in, tag);
+            continue;
+        }
+        const uint8_t* element;
+        std::size_t elementSize;
+        DataContainerPbFields fields;
+        ReadPbBytes(&in, data, &element, &elementSize);
+        if (!ParseDataContainerPb(element, elementSize, &fields))
+        {
+            return false;
+        }
+        auto it = m_dict.find(std::string(reinterpret_cast<const char*>(fields.name),
+                                          fields.nameSize));
+        if (it == m_dict.end())
+        {
+            return false;
+        }
+        // elements that cannot be decoded in place are replaced
+        it->second = CreateFromDataContainerPb(element, elementSize, raw, rawSize, it->second);
+    }
+    return true;
+}
+
 bool
 OpenGymDictContainer::Add(std::string key, Ptr<OpenGymDataContainer> data)
 {
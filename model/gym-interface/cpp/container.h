@@ -22,14 +22,109 @@
 #ifndef OPENGYM_CONTAINER_H
 #define OPENGYM_CONTAINER_H
 
+#include "../ns3-ai-gym-msg.h"
 #include "messages.pb.h"
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 #include <ns3/object.h>
 #include <ns3/type-name.h>
 
+#include <cstring>
+#include <type_traits>
+
 namespace ns3
 {
 
+/**
+ * Encoding of the DataContainer message of a container tree. The size pass
+ * (OpenGymDataContainer::GetDataContainerPbSize) appends an entry per
+ * container, and the write pass (WriteDataContainerPb) reads them back in the
+ * same order, so the containers keep no encoding state. Kept from message to
+ * message, so that steady-state steps allocate nothing.
+ */
+class OpenGymDataContainerPbLayout
+{
+  public:
+    /**
+     * Encoding of a container, as computed by the size pass
+     */
+    struct Entry
+    {
+        std::size_t size{0};      //!< bytes of the DataContainer message
+        std::size_t valueSize{0}; //!< bytes of the Any value among them
+        std::size_t shapeSize{0}; //!< Box: bytes of the packed shape
+        std::size_t dataSize{0};  //!< Box: bytes of the packed items
+        bool raw{false};          //!< Box: whether the data is in the raw area
+        uint64_t rawOffset{0};    //!< Box: offset of the data in the raw area
+    };
+
+    OpenGymDataContainerPbLayout();
+
+    /**
+     * Starts the size pass of a new message
+     *
+     * \param raw whether the data of Box containers may be laid out in the raw
+     *        area of the Gym message instead of the protobuf message
+     */
+    void Clear(bool raw);
+    /**
+     * Whether the data of Box containers may be laid out in the raw area
+     */
+    bool IsRaw() const;
+    /**
+     * Lays out bytes in the raw area, aligned to NS3_AI_GYM_RAW_ALIGN
+     *
+     * eturn their offset
+     */
+    uint64_t AddRaw(uint64_t bytes);
+    /**
+     * Gets the bytes of the raw area laid out so far
+     */
+    uint64_t GetRawSize() const;
+    /**
+     * Appends the entry of the next container of the size pass
+     *
+     * eturn its index, valid while more entries are appended
+     */
+    std::size_t AddEntry();
+    Entry& GetEntry(std::size_t index);
+    /**
+     * Appends the message of a container encoded from GetDataContainerPbMsg
+     */
+    ns3_ai_gym::DataContainer* AddMsg();
+
+    /**
+     * Starts the write pass, after the size pass
+     *
+     * \param raw the raw area of GetRawSize bytes, or nullptr if it is empty
+     */
+    void BeginWrite(uint8_t* raw);
+    /**
+     * Gets the entry of the next container of the write pass
+     */
+    const Entry& NextEntry();
+    /**
+     * Gets the entry NextEntry returns next, e.g. of the element of a Tuple
+     */
+    const Entry& PeekEntry() const;
+    /**
+     * Gets the message appended by AddMsg for the next such container
+     */
+    const ns3_ai_gym::DataContainer& NextMsg();
+    uint8_t* GetRawArea() const;
+
+  private:
+    std::vector<Entry> m_entries;
+    std::vector<ns3_ai_gym::DataContainer> m_msgs; //!< kept for reuse beyond m_msgCount
+    std::size_t m_msgCount;
+    bool m_raw;
+    uint64_t m_rawSize;
+    uint8_t* m_rawArea;
+    std::size_t m_nextEntry; //!< position of the write pass
+    std::size_t m_nextMsg;   //!< position of the write pass among the messages
+};
+
 class OpenGymDataContainer : public Object
 {
   public:
@@ -42,6 +137,71 @@ class OpenGymDataContainer : public Object
     static Ptr<OpenGymDataContainer> CreateFromDataContainerPbMsg(
         ns3_ai_gym::DataContainer& dataContainer);
 
+    /**
+     * Creates a container from a protobuf message whose Box containers may
+     * have their data in the raw area of the message
+     *
+     * \param raw the raw area
+     * \param rawSize its bytes
+     */
+    static Ptr<OpenGymDataContainer> CreateFromDataContainerPbMsg(
+        ns3_ai_gym::DataContainer& dataContainer,
+        const uint8_t* raw,
+        uint64_t rawSize);
+
+    /**
+     * Computes the bytes of the DataContainer message of the container as
+     * WriteDataContainerPb encodes it, appending its encoding to the layout.
+     * If the layout is raw, the data of Box containers is left out of the
+     * message and laid out in the raw area of the Gym message instead.
+     * Containers without their own implementation keep the message of
+     * GetDataContainerPbMsg in the layout.
+     *
+     * \param name the name of the container in its Dict, or empty
+     * \return the bytes of the message
+     */
+    virtual std::size_t GetDataContainerPbSize(const std::string& name,
+                                               OpenGymDataContainerPbLayout* layout);
+
+    /**
+     * Encodes the DataContainer message of the container straight into out,
+     * and its raw data into the raw area, following the layout computed by
+     * GetDataContainerPbSize with the same name
+     */
+    virtual void WriteDataContainerPb(google::protobuf::io::CodedOutputStream* out,
+                                      const std::string& name,
+                                      OpenGymDataContainerPbLayout* layout) const;
+
+    /**
+     * Decodes the data of the container in place from an encoded message of
+     * the same structure, so that the containers of an action are reused from
+     * step to step. A container referenced from elsewhere is left alone.
+     *
+     * \param type the type of the DataContainer message
+     * \param data the encoded message in its Any, e.g. a BoxDataContainer
+     * \param size its bytes
+     * \return false if the message has another structure or the container is
+     *         shared, in which case some of its elements may be decoded
+     */
+    virtual bool ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                                     const uint8_t* data,
+                                     std::size_t size,
+                                     const uint8_t* raw,
+                                     uint64_t rawSize);
+
+    /**
+     * Decodes an encoded DataContainer message into reuse if it has the same
+     * structure (see ReadDataContainerPb), else into new containers
+     *
+     * \param reuse the containers of the previous message, or nullptr
+     */
+    static Ptr<OpenGymDataContainer> CreateFromDataContainerPb(
+        const uint8_t* data,
+        std::size_t size,
+        const uint8_t* raw,
+        uint64_t rawSize,
+        const Ptr<OpenGymDataContainer>& reuse);
+
     virtual void Print(std::ostream& where) const = 0;
 
     friend std::ostream& operator<<(std::ostream& os, const Ptr<OpenGymDataContainer> container)
@@ -54,6 +214,26 @@ class OpenGymDataContainer : public Object
     // Inherited
     void DoInitialize() override;
     void DoDispose() override;
+
+    /**
+     * Gets the bytes of a DataContainer message whose Any holds valueSize
+     * bytes of the message of the type
+     */
+    static std::size_t ComputeDataContainerPbSize(ns3_ai_gym::SpaceType type,
+                                                  std::size_t valueSize,
+                                                  const std::string& name);
+    /**
+     * Encodes a DataContainer message up to the start of its Any value, which
+     * the caller encodes next
+     */
+    static void WriteDataContainerPbBegin(google::protobuf::io::CodedOutputStream* out,
+                                          ns3_ai_gym::SpaceType type,
+                                          std::size_t valueSize);
+    /**
+     * Encodes the rest of a DataContainer message after its Any value
+     */
+    static void WriteDataContainerPbEnd(google::protobuf::io::CodedOutputStream* out,
+                                        const std::string& name);
 };
 
 class OpenGymDiscreteContainer : public OpenGymDataContainer
@@ -66,6 +246,16 @@ class OpenGymDiscreteContainer : public OpenGymDataContainer
     static TypeId GetTypeId();
 
     ns3_ai_gym::DataContainer GetDataContainerPbMsg() override;
+    std::size_t GetDataContainerPbSize(const std::string& name,
+                                       OpenGymDataContainerPbLayout* layout) override;
+    void WriteDataContainerPb(google::protobuf::io::CodedOutputStream* out,
+                              const std::string& name,
+                              OpenGymDataContainerPbLayout* layout) const override;
+    bool ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                             const uint8_t* data,
+                             std::size_t size,
+                             const uint8_t* raw,
+                             uint64_t rawSize) override;
 
     void Print(std::ostream& where) const override;
 
@@ -98,6 +288,16 @@ class OpenGymBoxContainer : public OpenGymDataContainer
     static TypeId GetTypeId();
 
     ns3_ai_gym::DataContainer GetDataContainerPbMsg() override;
+    std::size_t GetDataContainerPbSize(const std::string& name,
+                                       OpenGymDataContainerPbLayout* layout) override;
+    void WriteDataContainerPb(google::protobuf::io::CodedOutputStream* out,
+                              const std::string& name,
+                              OpenGymDataContainerPbLayout* layout) const override;
+    bool ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                             const uint8_t* data,
+                             std::size_t size,
+                             const uint8_t* raw,
+                             uint64_t rawSize) override;
 
     void Print(std::ostream& where) const override;
 
@@ -122,6 +322,27 @@ class OpenGymBoxContainer : public OpenGymDataContainer
 
   private:
     void SetDtype();
+    /**
+     * Whether the items are those of the dtype, so that they can be sent raw
+     */
+    bool IsRaw() const;
+    /**
+     * Gets the number of the repeated field holding the items of the dtype
+     */
+    uint32_t GetPbDataField() const;
+    /**
+     * Decodes a repeated field, packed or not, appending its items
+     *
+     * \param wireType the wire type of the field
+     * \param itemType the wire type of an item
+     * \param decode converts the bits of an item into an item
+     */
+    template <typename Item, typename Decode>
+    static bool ReadPbItems(google::protobuf::io::CodedInputStream* in,
+                            google::protobuf::internal::WireFormatLite::WireType wireType,
+                            google::protobuf::internal::WireFormatLite::WireType itemType,
+                            std::vector<Item>& items,
+                            Decode decode);
     std::vector<uint32_t> m_shape;
     ns3_ai_gym::Dtype m_dtype;
     std::vector<T> m_data;
@@ -196,45 +417,385 @@ OpenGymBoxContainer<T>::DoInitialize()
 {
 }
 
+template <typename T>
+bool
+OpenGymBoxContainer<T>::IsRaw() const
+{
+    if (m_dtype == ns3_ai_gym::INT || m_dtype == ns3_ai_gym::UINT)
+    {
+        return std::is_integral<T>::value && !std::is_same<T, bool>::value;
+    }
+    return (m_dtype == ns3_ai_gym::FLOAT && std::is_same<T, float>::value) ||
+           (m_dtype == ns3_ai_gym::DOUBLE && std::is_same<T, double>::value);
+}
+
 template <typename T>
 ns3_ai_gym::DataContainer
 OpenGymBoxContainer<T>::GetDataContainerPbMsg()
 {
-    ns3_ai_gym::DataContainer dataContainerPbMsg;
     ns3_ai_gym::BoxDataContainer boxContainerPbMsg;
-
-    std::vector<uint32_t> shape = GetShape();
-    *boxContainerPbMsg.mutable_shape() = {shape.begin(), shape.end()};
-
+    boxContainerPbMsg.mutable_shape()->Add(m_shape.begin(), m_shape.end());
     boxContainerPbMsg.set_dtype(m_dtype);
-    std::vector<T> data = GetData();
 
     if (m_dtype == ns3_ai_gym::INT)
     {
-        *boxContainerPbMsg.mutable_intdata() = {data.begin(), data.end()};
+        boxContainerPbMsg.mutable_intdata()->Add(m_data.begin(), m_data.end());
     }
     else if (m_dtype == ns3_ai_gym::UINT)
     {
-        *boxContainerPbMsg.mutable_uintdata() = {data.begin(), data.end()};
-    }
-    else if (m_dtype == ns3_ai_gym::FLOAT)
-    {
-        *boxContainerPbMsg.mutable_floatdata() = {data.begin(), data.end()};
+        boxContainerPbMsg.mutable_uintdata()->Add(m_data.begin(), m_data.end());
     }
     else if (m_dtype == ns3_ai_gym::DOUBLE)
     {
-        *boxContainerPbMsg.mutable_doubledata() = {data.begin(), data.end()};
+        boxContainerPbMsg.mutable_doubledata()->Add(m_data.begin(), m_data.end());
     }
     else
     {
-        *boxContainerPbMsg.mutable_floatdata() = {data.begin(), data.end()};
+        boxContainerPbMsg.mutable_floatdata()->Add(m_data.begin(), m_data.end());
     }
 
+    ns3_ai_gym::DataContainer dataContainerPbMsg;
     dataContainerPbMsg.set_type(ns3_ai_gym::Box);
     dataContainerPbMsg.mutable_data()->PackFrom(boxContainerPbMsg);
     return dataContainerPbMsg;
 }
 
+template <typename T>
+uint32_t
+OpenGymBoxContainer<T>::GetPbDataField() const
+{
+    if (m_dtype == ns3_ai_gym::INT)
+    {
+        return ns3_ai_gym::BoxDataContainer::kIntDataFieldNumber;
+    }
+    else if (m_dtype == ns3_ai_gym::UINT)
+    {
+        return ns3_ai_gym::BoxDataContainer::kUintDataFieldNumber;
+    }
+    else if (m_dtype == ns3_ai_gym::DOUBLE)
+    {
+        return ns3_ai_gym::BoxDataContainer::kDoubleDataFieldNumber;
+    }
+    return ns3_ai_gym::BoxDataContainer::kFloatDataFieldNumber;
+}
+
+template <typename T>
+std::size_t
+OpenGymBoxContainer<T>::GetDataContainerPbSize(const std::string& name,
+                                               OpenGymDataContainerPbLayout* layout)
+{
+    using google::protobuf::io::CodedOutputStream;
+    using google::protobuf::internal::WireFormatLite;
+
+    OpenGymDataContainerPbLayout::Entry& entry = layout->GetEntry(layout->AddEntry());
+    std::size_t valueSize = 1 + CodedOutputStream::VarintSize32(m_dtype);
+    for (uint32_t dim : m_shape)
+    {
+        entry.shapeSize += CodedOutputStream::VarintSize32(dim);
+    }
+    if (entry.shapeSize)
+    {
+        valueSize += 1 + CodedOutputStream::VarintSize64(entry.shapeSize) + entry.shapeSize;
+    }
+
+    entry.raw = layout->IsRaw() && IsRaw();
+    if (entry.raw)
+    {
+        entry.rawOffset = layout->AddRaw(m_data.size() * sizeof(T));
+        // raw and itemSize
+        valueSize += 2 + 1 + CodedOutputStream::VarintSize32(sizeof(T));
+        if (entry.rawOffset)
+        {
+            valueSize += 1 + CodedOutputStream::VarintSize64(entry.rawOffset);
+        }
+        if (!m_data.empty())
+        {
+            valueSize += 1 + CodedOutputStream::VarintSize64(m_data.size());
+        }
+    }
+    else
+    {
+        if (m_dtype == ns3_ai_gym::INT)
+        {
+            for (const T& item : m_data)
+            {
+                entry.dataSize += WireFormatLite::Int32Size(static_cast<int32_t>(item));
+            }
+        }
+        else if (m_dtype == ns3_ai_gym::UINT)
+        {
+            for (const T& item : m_data)
+            {
+                entry.dataSize += WireFormatLite::UInt32Size(static_cast<uint32_t>(item));
+            }
+        }
+        else
+        {
+            entry.dataSize = m_data.size() * (m_dtype == ns3_ai_gym::DOUBLE ? 8 : 4);
+        }
+        if (entry.dataSize)
+        {
+            valueSize += 1 + CodedOutputStream::VarintSize64(entry.dataSize) + entry.dataSize;
+        }
+    }
+
+    entry.valueSize = valueSize;
+    entry.size = ComputeDataContainerPbSize(ns3_ai_gym::Box, valueSize, name);
+    return entry.size;
+}
+
+template <typename T>
+void
+OpenGymBoxContainer<T>::WriteDataContainerPb(google::protobuf::io::CodedOutputStream* out,
+                                             const std::string& name,
+                                             OpenGymDataContainerPbLayout* layout) const
+{
+    using google::protobuf::internal::WireFormatLite;
+
+    const OpenGymDataContainerPbLayout::Entry& entry = layout->NextEntry();
+    WriteDataContainerPbBegin(out, ns3_ai_gym::Box, entry.valueSize);
+    WireFormatLite::WriteEnum(ns3_ai_gym::BoxDataContainer::kDtypeFieldNumber, m_dtype, out);
+    if (entry.shapeSize)
+    {
+        WireFormatLite::WriteTag(ns3_ai_gym::BoxDataContainer::kShapeFieldNumber,
+                                 WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                                 out);
+        out->WriteVarint64(entry.shapeSize);
+        for (uint32_t dim : m_shape)
+        {
+            out->WriteVarint32(dim);
+        }
+    }
+
+    if (entry.raw)
+    {
+        WireFormatLite::WriteBool(ns3_ai_gym::BoxDataContainer::kRawFieldNumber, true, out);
+        WireFormatLite::WriteUInt32(ns3_ai_gym::BoxDataContainer::kItemSizeFieldNumber,
+                                    sizeof(T),
+                                    out);
+        if (entry.rawOffset)
+        {
+            WireFormatLite::WriteUInt64(ns3_ai_gym::BoxDataContainer::kRawOffsetFieldNumber,
+                                        entry.rawOffset,
+                                        out);
+        }
+        if (!m_data.empty())
+        {
+            WireFormatLite::WriteUInt64(ns3_ai_gym::BoxDataContainer::kCountFieldNumber,
+                                        m_data.size(),
+                                        out);
+            // std::vector<bool> packs its items and is never sent raw
+            if constexpr (!std::is_same<T, bool>::value)
+            {
+                std::memcpy(layout->GetRawArea() + entry.rawOffset,
+                            m_data.data(),
+                            m_data.size() * sizeof(T));
+            }
+        }
+    }
+    else if (entry.dataSize)
+    {
+        WireFormatLite::WriteTag(GetPbDataField(), WireFormatLite::WIRETYPE_LENGTH_DELIMITED, out);
+        out->WriteVarint64(entry.dataSize);
+        for (const T& item : m_data)
+        {
+            if (m_dtype == ns3_ai_gym::INT)
+            {
+                out->WriteVarint32SignExtended(static_cast<int32_t>(item));
+            }
+            else if (m_dtype == ns3_ai_gym::UINT)
+            {
+                out->WriteVarint32(static_cast<uint32_t>(item));
+            }
+            else if (m_dtype == ns3_ai_gym::DOUBLE)
+            {
+                out->WriteLittleEndian64(WireFormatLite::EncodeDouble(static_cast<double>(item)));
+            }
+            else
+            {
+                out->WriteLittleEndian32(WireFormatLite::EncodeFloat(static_cast<float>(item)));
+            }
+        }
+    }
+    WriteDataContainerPbEnd(out, name);
+}
+
+template <typename T>
+template <typename Item, typename Decode>
+bool
+OpenGymBoxContainer<T>::ReadPbItems(google::protobuf::io::CodedInputStream* in,
+                                    google::protobuf::internal::WireFormatLite::WireType wireType,
+                                    google::protobuf::internal::WireFormatLite::WireType itemType,
+                                    std::vector<Item>& items,
+                                    Decode decode)
+{
+    using google::protobuf::internal::WireFormatLite;
+
+    // packed items up to the limit, or a single unpacked item
+    google::protobuf::io::CodedInputStream::Limit limit = -1;
+    if (wireType == WireFormatLite::WIRETYPE_LENGTH_DELIMITED)
+    {
+        uint32_t length;
+        if (!in->ReadVarint32(&length))
+        {
+            return false;
+        }
+        limit = in->PushLimit(length);
+    }
+    else if (wireType != itemType)
+    {
+        return false;
+    }
+    do
+    {
+        uint64_t bits;
+        uint32_t bits32;
+        if (itemType == WireFormatLite::WIRETYPE_VARINT)
+        {
+            if (!in->ReadVarint64(&bits))
+            {
+                return false;
+            }
+        }
+        else if (itemType == WireFormatLite::WIRETYPE_FIXED32)
+        {
+            if (!in->ReadLittleEndian32(&bits32))
+            {
+                return false;
+            }
+            bits = bits32;
+        }
+        else if (!in->ReadLittleEndian64(&bits))
+        {
+            return false;
+        }
+        items.push_back(decode(bits));
+    } while (limit != -1 && in->BytesUntilLimit() > 0);
+    if (limit != -1)
+    {
+        in->PopLimit(limit);
+    }
+    return true;
+}
+
+template <typename T>
+bool
+OpenGymBoxContainer<T>::ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                                            const uint8_t* data,
+                                            std::size_t size,
+                                            const uint8_t* raw,
+                                            uint64_t rawSize)
+{
+    using google::protobuf::internal::WireFormatLite;
+
+    if (GetReferenceCount() > 1 || type != ns3_ai_gym::Box)
+    {
+        return false;
+    }
+    uint32_t dataField = GetPbDataField();
+    uint32_t dtype = ns3_ai_gym::NoDType;
+    uint32_t isRaw = 0;
+    uint32_t itemSize = 0;
+    uint64_t offset = 0;
+    uint64_t count = 0;
+    m_shape.clear();
+    m_data.clear();
+
+    google::protobuf::io::CodedInputStream in(data, size);
+    uint32_t tag;
+    while ((tag = in.ReadTag()) != 0)
+    {
+        uint32_t field = WireFormatLite::GetTagFieldNumber(tag);
+        WireFormatLite::WireType wireType = WireFormatLite::GetTagWireType(tag);
+        bool ok;
+        if (field == ns3_ai_gym::BoxDataContainer::kDtypeFieldNumber)
+        {
+            ok = in.ReadVarint32(&dtype);
+        }
+        else if (field == ns3_ai_gym::BoxDataContainer::kShapeFieldNumber)
+        {
+            ok = ReadPbItems(&in,
+                             wireType,
+                             WireFormatLite::WIRETYPE_VARINT,
+                             m_shape,
+                             [](uint64_t bits) { return static_cast<uint32_t>(bits); });
+        }
+        else if (field == dataField && m_dtype == ns3_ai_gym::INT)
+        {
+            ok = ReadPbItems(&in, wireType, WireFormatLite::WIRETYPE_VARINT, m_data, [](uint64_t bits) {
+                return static_cast<T>(static_cast<int32_t>(bits));
+            });
+        }
+        else if (field == dataField && m_dtype == ns3_ai_gym::UINT)
+        {
+            ok = ReadPbItems(&in, wireType, WireFormatLite::WIRETYPE_VARINT, m_data, [](uint64_t bits) {
+                return static_cast<T>(static_cast<uint32_t>(bits));
+            });
+        }
+        else if (field == dataField && m_dtype == ns3_ai_gym::DOUBLE)
+        {
+            ok = ReadPbItems(&in, wireType, WireFormatLite::WIRETYPE_FIXED64, m_data, [](uint64_t bits) {
+                return static_cast<T>(WireFormatLite::DecodeDouble(bits));
+            });
+        }
+        else if (field == dataField)
+        {
+            ok = ReadPbItems(&in, wireType, WireFormatLite::WIRETYPE_FIXED32, m_data, [](uint64_t bits) {
+                return static_cast<T>(WireFormatLite::DecodeFloat(static_cast<uint32_t>(bits)));
+            });
+        }
+        else if (field >= ns3_ai_gym::BoxDataContainer::kIntDataFieldNumber &&
+                 field <= ns3_ai_gym::BoxDataContainer::kDoubleDataFieldNumber)
+        {
+            // items of another dtype
+            ok = false;
+        }
+        else if (field == ns3_ai_gym::BoxDataContainer::kRawFieldNumber)
+        {
+            ok = in.ReadVarint32(&isRaw);
+        }
+        else if (field == ns3_ai_gym::BoxDataContainer::kItemSizeFieldNumber)
+        {
+            ok = in.ReadVarint32(&itemSize);
+        }
+        else if (field == ns3_ai_gym::BoxDataContainer::kRawOffsetFieldNumber)
+        {
+            ok = in.ReadVarint64(&offset);
+        }
+        else if (field == ns3_ai_gym::BoxDataContainer::kCountFieldNumber)
+        {
+            ok = in.ReadVarint64(&count);
+        }
+        else
+        {
+            ok = WireFormatLite::SkipField(&in, tag);
+        }
+        if (!ok)
+        {
+            return false;
+        }
+    }
+    if (dtype != static_cast<uint32_t>(m_dtype))
+    {
+        return false;
+    }
+
+    if (isRaw)
+    {
+        if (!IsRaw() || itemSize != sizeof(T) || offset > rawSize ||
+            count > (rawSize - offset) / sizeof(T))
+        {
+            return false;
+        }
+        if constexpr (!std::is_same<T, bool>::value)
+        {
+            m_data.resize(count);
+            std::memcpy(m_data.data(), raw + offset, count * sizeof(T));
+        }
+    }
+    return true;
+}
+
 template <typename T>
 bool
 OpenGymBoxContainer<T>::AddValue(T value)
@@ -304,6 +865,16 @@ class OpenGymTupleContainer : public OpenGymDataContainer
     static TypeId GetTypeId();
 
     ns3_ai_gym::DataContainer GetDataContainerPbMsg() override;
+    std::size_t GetDataContainerPbSize(const std::string& name,
+                                       OpenGymDataContainerPbLayout* layout) override;
+    void WriteDataContainerPb(google::protobuf::io::CodedOutputStream* out,
+                              const std::string& name,
+                              OpenGymDataContainerPbLayout* layout) const override;
+    bool ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                             const uint8_t* data,
+                             std::size_t size,
+                             const uint8_t* raw,
+                             uint64_t rawSize) override;
 
     void Print(std::ostream& where) const override;
 
@@ -333,6 +904,16 @@ class OpenGymDictContainer : public OpenGymDataContainer
     static TypeId GetTypeId();
 
     ns3_ai_gym::DataContainer GetDataContainerPbMsg() override;
+    std::size_t GetDataContainerPbSize(const std::string& name,
+                                       OpenGymDataContainerPbLayout* layout) override;
+    void WriteDataContainerPb(google::protobuf::io::CodedOutputStream* out,
+                              const std::string& name,
+                              OpenGymDataContainerPbLayout* layout) const override;
+    bool ReadDataContainerPb(ns3_ai_gym::SpaceType type,
+                             const uint8_t* data,
+                             std::size_t size,
+                             const uint8_t* raw,
+                             uint64_t rawSize) override;
 
     void Print(std::ostream& where) const override;
 
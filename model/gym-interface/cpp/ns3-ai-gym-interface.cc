@@ -31,6 +31,10 @@
 #include "ns3-ai-gym-env.h"
 #include "spaces.h"
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
+#include <ns3/abort.h>
 #include <ns3/config.h>
 #include <ns3/log.h>
 #include <ns3/simulator.h>
@@ -41,6 +45,173 @@ namespace ns3
 NS_LOG_COMPONENT_DEFINE("OpenGymInterface");
 NS_OBJECT_ENSURE_REGISTERED(OpenGymInterface);
 
+typedef Ns3AiMsgInterfaceImpl<Ns3AiGymByte, Ns3AiGymByte> GymMsgInterface;
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::io::CodedOutputStream;
+using google::protobuf::internal::WireFormatLite;
+
+/**
+ * Upper bound of the bytes of a serialized DataContainer of a space, used to
+ * reserve the observation message at Init
+ */
+static std::size_t
+MaxDataBytes(const ns3_ai_gym::SpaceDescription& spaceDesc)
+{
+    // type, name, Any type URL and length prefixes
+    std::size_t bytes = 128 + spaceDesc.name().size();
+    if (spaceDesc.type() == ns3_ai_gym::Box)
+    {
+        ns3_ai_gym::BoxSpace box;
+        spaceDesc.space().UnpackTo(&box);
+        std::size_t count = 1;
+        for (uint32_t dim : box.shape())
+        {
+            count *= dim;
+        }
+        // packed repeated fields: negative int32 varints take 10 bytes
+        std::size_t item = box.dtype() == ns3_ai_gym::INT      ? 10
+                           : box.dtype() == ns3_ai_gym::UINT   ? 5
+                           : box.dtype() == ns3_ai_gym::DOUBLE ? 8
+                                                               : 4;
+        bytes += count * item + box.shape_size() * 5;
+    }
+    else if (spaceDesc.type() == ns3_ai_gym::Tuple)
+    {
+        ns3_ai_gym::TupleSpace tuple;
+        spaceDesc.space().UnpackTo(&tuple);
+        for (const auto& element : tuple.element())
+        {
+            bytes += MaxDataBytes(element);
+        }
+    }
+    else if (spaceDesc.type() == ns3_ai_gym::Dict)
+    {
+        ns3_ai_gym::DictSpace dict;
+        spaceDesc.space().UnpackTo(&dict);
+        for (const auto& element : dict.element())
+        {
+            bytes += MaxDataBytes(element);
+        }
+    }
+    return bytes;
+}
+
+/**
+ * Makes room for a Gym message of size bytes, reallocating it in the segment
+ * when it grows
+ */
+template <typename MsgVector>
+static void
+ReserveMsg(MsgVector* msg, std::size_t size)
+{
+    try
+    {
+        msg->reserve(size);
+    }
+    catch (const boost::interprocess::bad_alloc&)
+    {
+        NS_FATAL_ERROR("A Gym message of " << size << " bytes does not fit in the shared "
+                                              "memory segment, increase shmSize of Ns3Env");
+    }
+}
+
+/**
+ * Resizes a Gym message to size bytes
+ *
+ * \return the bytes of the message
+ */
+template <typename MsgVector>
+static uint8_t*
+ResizeMsg(MsgVector* msg, std::size_t size)
+{
+    ReserveMsg(msg, size);
+    msg->resize(size);
+    return msg->data();
+}
+
+/**
+ * Lays out a Gym message: the header, room for pbSize bytes of protobuf
+ * message and for rawSize bytes of raw data
+ *
+ * \param raw set to the raw area
+ * \return the room for the protobuf message
+ */
+template <typename MsgVector>
+static uint8_t*
+BeginMsg(MsgVector* msg, std::size_t pbSize, uint64_t rawSize, uint8_t** raw)
+{
+    std::size_t rawOffset = sizeof(Ns3AiGymMsgHeader) + pbSize;
+    if (rawSize)
+    {
+        rawOffset = (rawOffset + NS3_AI_GYM_RAW_ALIGN - 1) & ~std::size_t(NS3_AI_GYM_RAW_ALIGN - 1);
+    }
+    uint8_t* data = ResizeMsg(msg, rawOffset + rawSize);
+    Ns3AiGymMsgHeader* header = reinterpret_cast<Ns3AiGymMsgHeader*>(data);
+    header->m_pbSize = pbSize;
+    header->m_rawOffset = rawOffset;
+    *raw = data + rawOffset;
+    return data + sizeof(Ns3AiGymMsgHeader);
+}
+
+/**
+ * Writes a Gym message: the header, the protobuf message and room for
+ * rawSize bytes of raw data
+ *
+ * \return the raw area
+ */
+template <typename MsgVector>
+static uint8_t*
+WriteMsg(MsgVector* msg, const google::protobuf::MessageLite& pbMsg, uint64_t rawSize)
+{
+    std::size_t pbSize = pbMsg.ByteSizeLong();
+    uint8_t* raw;
+    uint8_t* data = BeginMsg(msg, pbSize, rawSize, &raw);
+    pbMsg.SerializeToArray(data, pbSize);
+    return raw;
+}
+
+/**
+ * Finds the parts of a Gym message
+ *
+ * \param pb set to the encoded protobuf message
+ * \param pbSize set to its bytes
+ * \param rawSize set to the bytes of the raw area
+ * \return the raw area
+ */
+template <typename MsgVector>
+static const uint8_t*
+GetMsgParts(const MsgVector* msg, const uint8_t** pb, std::size_t* pbSize, uint64_t* rawSize)
+{
+    const uint8_t* data = msg->data();
+    const Ns3AiGymMsgHeader* header = reinterpret_cast<const Ns3AiGymMsgHeader*>(data);
+    NS_ABORT_MSG_IF(msg->size() < sizeof(Ns3AiGymMsgHeader) ||
+                        header->m_pbSize > msg->size() - sizeof(Ns3AiGymMsgHeader) ||
+                        header->m_rawOffset > msg->size(),
+                    "Invalid Gym message");
+    *pb = data + sizeof(Ns3AiGymMsgHeader);
+    *pbSize = header->m_pbSize;
+    *rawSize = msg->size() - header->m_rawOffset;
+    return data + header->m_rawOffset;
+}
+
+/**
+ * Parses a Gym message
+ *
+ * \param rawSize set to the bytes of the raw area
+ * \return the raw area
+ */
+template <typename MsgVector>
+static const uint8_t*
+ParseMsg(const MsgVector* msg, google::protobuf::MessageLite& pbMsg, uint64_t& rawSize)
+{
+    const uint8_t* pb;
+    std::size_t pbSize;
+    const uint8_t* raw = GetMsgParts(msg, &pb, &pbSize, &rawSize);
+    pbMsg.ParseFromArray(pb, pbSize);
+    return raw;
+}
+
 Ptr<OpenGymInterface>
 OpenGymInterface::Get()
 {
@@ -51,11 +222,13 @@ OpenGymInterface::Get()
 OpenGymInterface::OpenGymInterface()
     : m_simEnd(false),
       m_stopEnvRequested(false),
-      m_initSimMsgSent(false)
+      m_initSimMsgSent(false),
+      m_rawBox(false),
+      m_obsLayout(std::make_unique<OpenGymDataContainerPbLayout>())
 {
     auto interface = Ns3AiMsgInterface::Get();
     interface->SetIsMemoryCreator(false);
-    interface->SetUseVector(false);
+    interface->SetUseVector(true);
     interface->SetHandleFinish(false);
 }
 
@@ -101,23 +274,26 @@ OpenGymInterface::Init()
     }
 
     // get the interface
-    Ns3AiMsgInterfaceImpl<Ns3AiGymMsg, Ns3AiGymMsg>* msgInterface =
-        Ns3AiMsgInterface::Get()->GetInterface<Ns3AiGymMsg, Ns3AiGymMsg>();
+    GymMsgInterface* msgInterface =
+        Ns3AiMsgInterface::Get()->GetInterface<Ns3AiGymByte, Ns3AiGymByte>();
 
     // send init msg to python
     msgInterface->CppSendBegin();
-    msgInterface->GetCpp2PyStruct()->size = simInitMsg.ByteSizeLong();
-    assert(msgInterface->GetCpp2PyStruct()->size <= MSG_BUFFER_SIZE);
-    simInitMsg.SerializeToArray(msgInterface->GetCpp2PyStruct()->buffer,
-                                msgInterface->GetCpp2PyStruct()->size);
+    GymMsgInterface::Cpp2PyMsgVector* request = msgInterface->GetCpp2PyVector();
+    // room for the largest observation, so that a segment too small for it
+    // fails here rather than during the simulation
+    ReserveMsg(request, obsSpace ? MaxDataBytes(simInitMsg.obsspace()) : 0);
+    WriteMsg(request, simInitMsg, 0);
     msgInterface->CppSendEnd();
 
     // receive init ack msg from python
     ns3_ai_gym::SimInitAck simInitAck;
+    uint64_t rawSize;
     msgInterface->CppRecvBegin();
-    simInitAck.ParseFromArray(msgInterface->GetPy2CppStruct()->buffer,
-                              msgInterface->GetPy2CppStruct()->size);
+    ParseMsg(msgInterface->GetPy2CppVector(), simInitAck, rawSize);
     msgInterface->CppRecvEnd();
+    // Python side reads Box observations as raw data
+    m_rawBox = simInitAck.rawbox();
 
     bool done = simInitAck.done();
     NS_LOG_DEBUG("Sim Init Ack: " << done);
@@ -148,52 +324,127 @@ OpenGymInterface::NotifyCurrentState()
     float reward = GetReward();
     bool isGameOver = IsGameOver();
     std::string extraInfo = GetExtraInfo();
-    ns3_ai_gym::EnvStateMsg envStateMsg;
-    // observation
-    ns3_ai_gym::DataContainer obsDataContainerPbMsg;
+
+    // size the env state msg, laying out the raw data of the observation
+    m_obsLayout->Clear(m_rawBox);
+    std::size_t obsSize = 0;
+    std::size_t pbSize = 0;
     if (obsDataContainer)
     {
-        obsDataContainerPbMsg = obsDataContainer->GetDataContainerPbMsg();
-        envStateMsg.mutable_obsdata()->CopyFrom(obsDataContainerPbMsg);
+        obsSize = obsDataContainer->GetDataContainerPbSize(std::string(), m_obsLayout.get());
+        pbSize += 1 + CodedOutputStream::VarintSize64(obsSize) + obsSize;
+    }
+    uint64_t rawSize = m_obsLayout->GetRawSize();
+    uint32_t rewardBits = WireFormatLite::EncodeFloat(reward);
+    if (rewardBits)
+    {
+        pbSize += 1 + WireFormatLite::kFloatSize;
     }
-    // reward
-    envStateMsg.set_reward(reward);
-    // game over
-    envStateMsg.set_isgameover(false);
+    ns3_ai_gym::EnvStateMsg::Reason reason = ns3_ai_gym::EnvStateMsg::SimulationEnd;
     if (isGameOver)
     {
-        envStateMsg.set_isgameover(true);
-        if (m_simEnd)
-        {
-            envStateMsg.set_reason(ns3_ai_gym::EnvStateMsg::SimulationEnd);
-        }
-        else
+        pbSize += 1 + WireFormatLite::kBoolSize;
+        if (!m_simEnd)
         {
-            envStateMsg.set_reason(ns3_ai_gym::EnvStateMsg::GameOver);
+            reason = ns3_ai_gym::EnvStateMsg::GameOver;
+            pbSize += 1 + CodedOutputStream::VarintSize32(reason);
         }
     }
-    // extra info
-    envStateMsg.set_info(extraInfo);
+    if (!extraInfo.empty())
+    {
+        pbSize += 1 + CodedOutputStream::VarintSize64(extraInfo.size()) + extraInfo.size();
+    }
 
     // get the interface
-    Ns3AiMsgInterfaceImpl<Ns3AiGymMsg, Ns3AiGymMsg>* msgInterface =
-        Ns3AiMsgInterface::Get()->GetInterface<Ns3AiGymMsg, Ns3AiGymMsg>();
+    GymMsgInterface* msgInterface =
+        Ns3AiMsgInterface::Get()->GetInterface<Ns3AiGymByte, Ns3AiGymByte>();
 
-    // send env state msg to python
+    // send env state msg to python, encoded straight into the message in one
+    // pass over the observation
     msgInterface->CppSendBegin();
-    msgInterface->GetCpp2PyStruct()->size = envStateMsg.ByteSizeLong();
-    assert(msgInterface->GetCpp2PyStruct()->size <= MSG_BUFFER_SIZE);
-    envStateMsg.SerializeToArray(msgInterface->GetCpp2PyStruct()->buffer,
-                                 msgInterface->GetCpp2PyStruct()->size);
-
+    uint8_t* raw;
+    uint8_t* pb = BeginMsg(msgInterface->GetCpp2PyVector(), pbSize, rawSize, &raw);
+    m_obsLayout->BeginWrite(raw);
+    {
+        google::protobuf::io::ArrayOutputStream stream(pb, pbSize);
+        CodedOutputStream out(&stream);
+        if (obsDataContainer)
+        {
+            WireFormatLite::WriteTag(ns3_ai_gym::EnvStateMsg::kObsDataFieldNumber,
+                                     WireFormatLite::WIRETYPE_LENGTH_DELIMITED,
+                                     &out);
+            out.WriteVarint64(obsSize);
+            obsDataContainer->WriteDataContainerPb(&out, std::string(), m_obsLayout.get());
+        }
+        if (rewardBits)
+        {
+            WireFormatLite::WriteFloat(ns3_ai_gym::EnvStateMsg::kRewardFieldNumber, reward, &out);
+        }
+        if (isGameOver)
+        {
+            WireFormatLite::WriteBool(ns3_ai_gym::EnvStateMsg::kIsGameOverFieldNumber, true, &out);
+            if (reason)
+            {
+                WireFormatLite::WriteEnum(ns3_ai_gym::EnvStateMsg::kReasonFieldNumber, reason, &out);
+            }
+        }
+        if (!extraInfo.empty())
+        {
+            WireFormatLite::WriteString(ns3_ai_gym::EnvStateMsg::kInfoFieldNumber, extraInfo, &out);
+        }
+        out.Trim();
+        NS_ABORT_MSG_IF(out.HadError() || static_cast<std::size_t>(out.ByteCount()) != pbSize,
+                        "Env state msg does not match its size");
+    }
     msgInterface->CppSendEnd();
 
     // receive act msg from python
-    ns3_ai_gym::EnvActMsg envActMsg;
     msgInterface->CppRecvBegin();
-
-    envActMsg.ParseFromArray(msgInterface->GetPy2CppStruct()->buffer,
-                             msgInterface->GetPy2CppStruct()->size);
+    const uint8_t* actPb;
+    std::size_t actPbSize;
+    const uint8_t* actRaw =
+        GetMsgParts(msgInterface->GetPy2CppVector(), &actPb, &actPbSize, &rawSize);
+    const uint8_t* act = nullptr;
+    std::size_t actSize = 0;
+    bool stopSim = false;
+    {
+        // the fields of the EnvActMsg, without decoding the action
+        CodedInputStream in(actPb, actPbSize);
+        uint32_t tag;
+        bool ok = true;
+        while (ok && (tag = in.ReadTag()) != 0)
+        {
+            uint32_t field = WireFormatLite::GetTagFieldNumber(tag);
+            uint32_t length;
+            uint32_t value;
+            if (field == ns3_ai_gym::EnvActMsg::kActDataFieldNumber)
+            {
+                ok = in.ReadVarint32(&length);
+                act = actPb + in.CurrentPosition();
+                actSize = length;
+                ok = ok && in.Skip(length);
+            }
+            else if (field == ns3_ai_gym::EnvActMsg::kStopSimReqFieldNumber)
+            {
+                ok = in.ReadVarint32(&value);
+                stopSim = value != 0;
+            }
+            else
+            {
+                ok = WireFormatLite::SkipField(&in, tag);
+            }
+        }
+        NS_ABORT_MSG_IF(!ok, "Invalid env act msg");
+    }
+    // decode the action out of the message, raw data included, before releasing it:
+    // into the containers of the last action if it has the same structure and is not
+    // held elsewhere, else into new ones
+    m_actDataContainer = OpenGymDataContainer::CreateFromDataContainerPb(act,
+                                                                         actSize,
+                                                                         actRaw,
+                                                                         rawSize,
+                                                                         m_actDataContainer);
+    Ptr<OpenGymDataContainer> actDataContainer = m_actDataContainer;
     msgInterface->CppRecvEnd();
 
     if (m_simEnd)
@@ -202,7 +453,6 @@ OpenGymInterface::NotifyCurrentState()
         return;
     }
 
-    bool stopSim = envActMsg.stopsimreq();
     if (stopSim)
     {
         NS_LOG_DEBUG("---Stop requested: " << stopSim);
@@ -213,9 +463,6 @@ OpenGymInterface::NotifyCurrentState()
     }
 
     // first step after reset is called without actions, just to get current state
-    ns3_ai_gym::DataContainer actDataContainerPbMsg = envActMsg.actdata();
-    Ptr<OpenGymDataContainer> actDataContainer =
-        OpenGymDataContainer::CreateFromDataContainerPbMsg(actDataContainerPbMsg);
     ExecuteActions(actDataContainer);
 }
 
@@ -374,6 +621,7 @@ void
 OpenGymInterface::DoDispose()
 {
     NS_LOG_FUNCTION(this);
+    m_actDataContainer = nullptr;
 }
 
 void
@@ -30,11 +30,14 @@
 #include <ns3/ptr.h>
 #include <ns3/type-id.h>
 
+#include <memory>
+
 namespace ns3
 {
 
 class OpenGymSpace;
 class OpenGymDataContainer;
+class OpenGymDataContainerPbLayout;
 class OpenGymEnv;
 
 class OpenGymInterface : public Object
@@ -80,6 +83,11 @@ class OpenGymInterface : public Object
     bool m_simEnd;
     bool m_stopEnvRequested;
     bool m_initSimMsgSent;
+    bool m_rawBox; //!< whether Box observations are sent as raw data
+    // encoding of the observation, reused from step to step
+    std::unique_ptr<OpenGymDataContainerPbLayout> m_obsLayout;
+    // containers of the last action, decoded in place by the next one
+    Ptr<OpenGymDataContainer> m_actDataContainer;
 
     Callback<Ptr<OpenGymSpace>> m_actionSpaceCb;
     Callback<Ptr<OpenGymSpace>> m_observationSpaceCb;
@@ -22,12 +22,33 @@
 
 #include <stdint.h>
 
-#define MSG_BUFFER_SIZE 1024
+/**
+ * Gym messages use the vector-based message interface, with vectors of bytes
+ * holding a serialized protobuf message. The sender resizes the vector to its
+ * message, which reallocates it in the shared memory segment when it grows,
+ * so a message of any size fits as long as the segment has room for it (see
+ * shmSize of Ns3Env). C++ side reserves room for the largest observation of
+ * the observation space at Init.
+ */
+typedef uint8_t Ns3AiGymByte;
+
+/**
+ * Alignment of the raw area of a Gym message and of the raw data of each Box
+ * in it, so that both sides can use the data in place
+ */
+#define NS3_AI_GYM_RAW_ALIGN 16
 
-struct Ns3AiGymMsg
+/**
+ * Header at the start of every Gym message. The serialized protobuf message
+ * follows it, then from m_rawOffset the raw area, holding the data of the Box
+ * containers sent raw (see OpenGymDataContainer::GetDataContainerPbSize).
+ */
+struct Ns3AiGymMsgHeader
 {
-    uint8_t buffer[MSG_BUFFER_SIZE];
-    uint32_t size;
+    // bytes of the protobuf message
+    uint32_t m_pbSize;
+    // offset of the raw area from the start of the message
+    uint32_t m_rawOffset;
 };
 
 #endif // NS3_NS3_AI_GYM_MSG_H
@@ -17,46 +17,42 @@
  * Author:  Muyuan Shen <muyuan_shen@hust.edu.cn>
  */
 
+#include "ns3-ai-msg-binding.h"
+
 #include <ns3/ai-module.h>
 
 #include <pybind11/pybind11.h>
 
 namespace py = pybind11;
 
+typedef ns3::Ns3AiMsgInterfaceImpl<Ns3AiGymByte, Ns3AiGymByte> GymMsgInterface;
+// both directions are vectors of bytes, of the same type
+typedef GymMsgInterface::Cpp2PyMsgVector GymMsgVector;
+
+PYBIND11_MAKE_OPAQUE(GymMsgVector);
+
 PYBIND11_MODULE(ns3ai_gym_msg_py, m)
 {
-    m.attr("msg_buffer_size") = MSG_BUFFER_SIZE;
-
-    py::class_<Ns3AiGymMsg>(m, "Ns3AiGymMsg")
-        .def(py::init<>())
-        .def_readwrite("size", &Ns3AiGymMsg::size)
-        .def("get_buffer",
-             [](Ns3AiGymMsg& msg) {
-                 // Get memoryview of the buffer
-                 return py::memoryview::from_memory((void*)msg.buffer, msg.size);
-             })
-        .def("get_buffer_full", [](Ns3AiGymMsg& msg) {
-            // Get memoryview of the buffer
-            return py::memoryview::from_memory((void*)msg.buffer, MSG_BUFFER_SIZE);
-        });
-
-    py::class_<ns3::Ns3AiMsgInterfaceImpl<Ns3AiGymMsg, Ns3AiGymMsg>>(m, "Ns3AiMsgInterfaceImpl")
-        .def(py::init<bool,
-                      bool,
-                      bool,
-                      uint32_t,
-                      const char*,
-                      const char*,
-                      const char*,
-                      const char*>())
-        .def("PyRecvBegin", &ns3::Ns3AiMsgInterfaceImpl<Ns3AiGymMsg, Ns3AiGymMsg>::PyRecvBegin)
-        .def("PyRecvEnd", &ns3::Ns3AiMsgInterfaceImpl<Ns3AiGymMsg, Ns3AiGymMsg>::PyRecvEnd)
-        .def("PySendBegin", &ns3::Ns3AiMsgInterfaceImpl<Ns3AiGymMsg, Ns3AiGymMsg>::PySendBegin)
-        .def("PySendEnd", &ns3::Ns3AiMsgInterfaceImpl<Ns3AiGymMsg, Ns3AiGymMsg>::PySendEnd)
-        .def("GetCpp2PyStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<Ns3AiGymMsg, Ns3AiGymMsg>::GetCpp2PyStruct,
-             py::return_value_policy::reference)
-        .def("GetPy2CppStruct",
-             &ns3::Ns3AiMsgInterfaceImpl<Ns3AiGymMsg, Ns3AiGymMsg>::GetPy2CppStruct,
-             py::return_value_policy::reference);
+    // a message, read or written through a memoryview of its bytes
+    py::class_<GymMsgVector>(m, "Ns3AiGymBuffer", py::buffer_protocol())
+        .def_buffer([](GymMsgVector& vec) {
+            return py::buffer_info(vec.data(),
+                                   sizeof(Ns3AiGymByte),
+                                   py::format_descriptor<Ns3AiGymByte>::format(),
+                                   1,
+                                   {vec.size()},
+                                   {sizeof(Ns3AiGymByte)});
+        })
+        .def("resize",
+             static_cast<void (GymMsgVector::*)(GymMsgVector::size_type)>(&GymMsgVector::resize))
+        .def("reserve", &GymMsgVector::reserve)
+        .def("capacity", &GymMsgVector::capacity)
+        .def("__len__", &GymMsgVector::size);
+
+    ns3::Ns3AiPyDefStats(m);
+    // subscribers read the observations as bytes, see GetBytes
+    ns3::Ns3AiPyDefSubscriber<Ns3AiGymByte>(m);
+
+    auto msgInterface = ns3::Ns3AiPyDefInterface<Ns3AiGymByte, Ns3AiGymByte>(m);
+    ns3::Ns3AiPyDefVectors(msgInterface);
 }
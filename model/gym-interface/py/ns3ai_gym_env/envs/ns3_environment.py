@@ -1,3 +1,4 @@
+import struct
 import numpy as np
 import gymnasium as gym
 from gymnasium import spaces
@@ -5,9 +6,62 @@ import messages_pb2 as pb
 import ns3ai_gym_msg_py as py_binding
 from ns3ai_utils import Experiment
 
+# messages are reallocated in the shared memory segment as they grow, so the
+# segment bounds the largest observation and action. Pages of the segment
+# are only allocated when used.
+GYM_SEGMENT_SIZE = 16 << 20
+# each broadcast slot holds a whole message, see Ns3Env
+GYM_BROADCAST_LENGTH = 64 << 10
+
+# every message starts with the bytes of its protobuf message and the offset
+# of its raw area, see Ns3AiGymMsgHeader
+GYM_HEADER = struct.Struct('=II')
+GYM_RAW_ALIGN = 16
+
+# NumPy dtypes of the Box dtypes, for raw data
+RAW_DTYPES = {pb.INT: 'i', pb.UINT: 'u', pb.FLOAT: 'f', pb.DOUBLE: 'f'}
+# item types of raw actions, those of the repeated fields
+ACTION_DTYPES = {pb.INT: np.int32, pb.UINT: np.uint32, pb.FLOAT: np.float32,
+                 pb.DOUBLE: np.float64}
+
+
+def _align_raw(offset):
+    return (offset + GYM_RAW_ALIGN - 1) & ~(GYM_RAW_ALIGN - 1)
+
 
 class Ns3Env(gym.Env):
-    _created = False
+    # parses a message from C++ side, between PyRecvBegin and PyRecvEnd, and
+    # returns its raw area
+    def _parse_msg(self, msg):
+        view = memoryview(self.msgInterface.GetCpp2PyVector())
+        pbSize, rawOffset = GYM_HEADER.unpack_from(view)
+        msg.ParseFromString(view[GYM_HEADER.size:GYM_HEADER.size + pbSize])
+        return view[rawOffset:]
+
+    def _recv_msg(self, msg):
+        self.msgInterface.PyRecvBegin()
+        self._parse_msg(msg)
+        self.msgInterface.PyRecvEnd()
+
+    # sends a message to C++ side, with the arrays of raw Box actions laid out
+    # by _pack_data as (offset, array) in its raw area
+    def _send_msg(self, msg, rawArrays=()):
+        data = msg.SerializeToString()
+        rawOffset = GYM_HEADER.size + len(data)
+        rawSize = 0
+        if rawArrays:
+            rawOffset = _align_raw(rawOffset)
+            rawSize = rawArrays[-1][0] + rawArrays[-1][1].nbytes
+        self.msgInterface.PySendBegin()
+        buffer = self.msgInterface.GetPy2CppVector()
+        buffer.resize(rawOffset + rawSize)
+        view = memoryview(buffer)
+        GYM_HEADER.pack_into(view, 0, len(data), rawOffset)
+        view[GYM_HEADER.size:GYM_HEADER.size + len(data)] = data
+        for offset, array in rawArrays:
+            np.frombuffer(view, dtype=array.dtype, count=array.size,
+                          offset=rawOffset + offset)[:] = array
+        self.msgInterface.PySendEnd()
 
     def _create_space(self, spaceDesc):
         space = None
@@ -60,7 +114,7 @@ class Ns3Env(gym.Env):
 
         return space
 
-    def _create_data(self, dataContainerPb):
+    def _create_data(self, dataContainerPb, raw=None):
         if dataContainerPb.type == pb.Discrete:
             discreteContainerPb = pb.DiscreteDataContainer()
             dataContainerPb.data.Unpack(discreteContainerPb)
@@ -72,6 +126,13 @@ class Ns3Env(gym.Env):
             dataContainerPb.data.Unpack(boxContainerPb)
             # print(boxContainerPb.shape, boxContainerPb.dtype, boxContainerPb.uintData)
 
+            if boxContainerPb.raw:
+                # one copy out of the message, which C++ side reuses
+                dtype = np.dtype('{}{}'.format(RAW_DTYPES[boxContainerPb.dtype],
+                                               boxContainerPb.itemSize))
+                return np.frombuffer(raw, dtype=dtype, count=boxContainerPb.count,
+                                     offset=boxContainerPb.rawOffset).copy()
+
             if boxContainerPb.dtype == pb.INT:
                 data = boxContainerPb.intData
             elif boxContainerPb.dtype == pb.UINT:
@@ -91,7 +152,7 @@ class Ns3Env(gym.Env):
 
             myDataList = []
             for pbSubData in tupleDataPb.element:
-                subData = self._create_data(pbSubData)
+                subData = self._create_data(pbSubData, raw)
                 myDataList.append(subData)
 
             data = tuple(myDataList)
@@ -103,7 +164,7 @@ class Ns3Env(gym.Env):
 
             myDataDict = {}
             for pbSubData in dictDataPb.element:
-                subData = self._create_data(pbSubData)
+                subData = self._create_data(pbSubData, raw)
                 myDataDict[pbSubData.name] = subData
 
             data = myDataDict
@@ -111,10 +172,7 @@ class Ns3Env(gym.Env):
 
     def initialize_env(self):
         simInitMsg = pb.SimInitMsg()
-        self.msgInterface.PyRecvBegin()
-        request = self.msgInterface.GetCpp2PyStruct().get_buffer()
-        simInitMsg.ParseFromString(request)
-        self.msgInterface.PyRecvEnd()
+        self._recv_msg(simInitMsg)
 
         self.action_space = self._create_space(simInitMsg.actSpace)
         self.observation_space = self._create_space(simInitMsg.obsSpace)
@@ -122,25 +180,14 @@ class Ns3Env(gym.Env):
         reply = pb.SimInitAck()
         reply.done = True
         reply.stopSimReq = False
-        reply_str = reply.SerializeToString()
-        assert len(reply_str) <= py_binding.msg_buffer_size
-
-        self.msgInterface.PySendBegin()
-        self.msgInterface.GetPy2CppStruct().size = len(reply_str)
-        self.msgInterface.GetPy2CppStruct().get_buffer_full()[:len(reply_str)] = reply_str
-        self.msgInterface.PySendEnd()
+        reply.rawBox = self.rawBox
+        self._send_msg(reply)
         return True
 
     def send_close_command(self):
         reply = pb.EnvActMsg()
         reply.stopSimReq = True
-
-        replyMsg = reply.SerializeToString()
-        assert len(replyMsg) <= py_binding.msg_buffer_size
-        self.msgInterface.PySendBegin()
-        self.msgInterface.GetPy2CppStruct().size = len(replyMsg)
-        self.msgInterface.GetPy2CppStruct().get_buffer_full()[:len(replyMsg)] = replyMsg
-        self.msgInterface.PySendEnd()
+        self._send_msg(reply)
 
         self.newStateRx = False
         return True
@@ -151,11 +198,11 @@ class Ns3Env(gym.Env):
 
         envStateMsg = pb.EnvStateMsg()
         self.msgInterface.PyRecvBegin()
-        request = self.msgInterface.GetCpp2PyStruct().get_buffer()
-        envStateMsg.ParseFromString(request)
+        raw = self._parse_msg(envStateMsg)
+        self.obsData = self._create_data(envStateMsg.obsData, raw)
+        del raw
         self.msgInterface.PyRecvEnd()
 
-        self.obsData = self._create_data(envStateMsg.obsData)
         self.reward = envStateMsg.reward
         self.gameOver = envStateMsg.isGameOver
         self.gameOverReason = envStateMsg.reason
@@ -181,7 +228,9 @@ class Ns3Env(gym.Env):
     def get_extra_info(self):
         return self.extraInfo
 
-    def _pack_data(self, actions, spaceDesc):
+    # packs actions into a container. With rawArrays, Box actions are laid
+    # out in the raw area: their (offset, array) are appended to it.
+    def _pack_data(self, actions, spaceDesc, rawArrays=None):
         dataContainer = pb.DataContainer()
 
         spaceType = spaceDesc.__class__
@@ -200,23 +249,37 @@ class Ns3Env(gym.Env):
 
             if spaceDesc.dtype in ['int', 'int8', 'int16', 'int32', 'int64']:
                 boxContainerPb.dtype = pb.INT
-                boxContainerPb.intData.extend(actions)
+                data = boxContainerPb.intData
 
             elif spaceDesc.dtype in ['uint', 'uint8', 'uint16', 'uint32', 'uint64']:
                 boxContainerPb.dtype = pb.UINT
-                boxContainerPb.uintData.extend(actions)
+                data = boxContainerPb.uintData
 
             elif spaceDesc.dtype in ['float', 'float32', 'float64']:
                 boxContainerPb.dtype = pb.FLOAT
-                boxContainerPb.floatData.extend(actions)
+                data = boxContainerPb.floatData
 
             elif spaceDesc.dtype in ['double']:
                 boxContainerPb.dtype = pb.DOUBLE
-                boxContainerPb.doubleData.extend(actions)
+                data = boxContainerPb.doubleData
 
             else:
                 boxContainerPb.dtype = pb.FLOAT
-                boxContainerPb.floatData.extend(actions)
+                data = boxContainerPb.floatData
+
+            if rawArrays is None:
+                data.extend(actions)
+            else:
+                array = np.ascontiguousarray(actions,
+                                             dtype=ACTION_DTYPES[boxContainerPb.dtype]).ravel()
+                offset = 0
+                if rawArrays:
+                    offset = _align_raw(rawArrays[-1][0] + rawArrays[-1][1].nbytes)
+                rawArrays.append((offset, array))
+                boxContainerPb.raw = True
+                boxContainerPb.itemSize = array.itemsize
+                boxContainerPb.rawOffset = offset
+                boxContainerPb.count = array.size
 
             dataContainer.data.Pack(boxContainerPb)
 
@@ -227,7 +290,7 @@ class Ns3Env(gym.Env):
             spaceList = list(self.action_space.spaces)
             subDataList = []
             for subAction, subActSpaceType in zip(actions, spaceList):
-                subData = self._pack_data(subAction, subActSpaceType)
+                subData = self._pack_data(subAction, subActSpaceType, rawArrays)
                 subDataList.append(subData)
 
             tupleDataPb.element.extend(subDataList)
@@ -240,7 +303,7 @@ class Ns3Env(gym.Env):
             subDataList = []
             for sName, subAction in actions.items():
                 subActSpaceType = self.action_space.spaces[sName]
-                subData = self._pack_data(subAction, subActSpaceType)
+                subData = self._pack_data(subAction, subActSpaceType, rawArrays)
                 subData.name = sName
                 subDataList.append(subData)
 
@@ -252,15 +315,10 @@ class Ns3Env(gym.Env):
     def send_actions(self, actions):
         reply = pb.EnvActMsg()
 
-        actionMsg = self._pack_data(actions, self.action_space)
+        rawArrays = [] if self.rawBox else None
+        actionMsg = self._pack_data(actions, self.action_space, rawArrays)
         reply.actData.CopyFrom(actionMsg)
-
-        replyMsg = reply.SerializeToString()
-        assert len(replyMsg) <= py_binding.msg_buffer_size
-        self.msgInterface.PySendBegin()
-        self.msgInterface.GetPy2CppStruct().size = len(replyMsg)
-        self.msgInterface.GetPy2CppStruct().get_buffer_full()[:len(replyMsg)] = replyMsg
-        self.msgInterface.PySendEnd()
+        self._send_msg(reply, rawArrays or ())
         self.newStateRx = False
         return True
 
@@ -271,25 +329,40 @@ class Ns3Env(gym.Env):
         extraInfo = {"info": self.get_extra_info()}
         return obs, reward, done, False, extraInfo
 
-    def __init__(self, targetName, ns3Path, ns3Settings=None, shmSize=4096):
-        if self._created:
-            raise Exception('Error: Ns3Env is singleton')
-        self._created = True
-        self.exp = Experiment(targetName, ns3Path, py_binding, shmSize=shmSize)
+    # \param[in] rawBox : whether Box observations and actions are passed as
+    #                     raw arrays after the protobuf message, instead of
+    #                     in its repeated fields
+    # \param[in] segName : name of the shared memory segment, distinct for
+    #                      environments running at once (see Ns3VectorEnv)
+    # \param[in] broadcastCapacity : number of messages from C++ side kept for
+    #                                subscribers (power of two), None for none
+    # \param[in] broadcastLength : bytes of the largest message broadcast, ns-3
+    #                              aborts on a larger one
+    # \param[in] start : whether to start the simulation, otherwise the spaces
+    #                    are known after start_reset and finish_reset
+    def __init__(self, targetName, ns3Path, ns3Settings=None, shmSize=GYM_SEGMENT_SIZE,
+                 rawBox=True, segName="My Seg", broadcastCapacity=None,
+                 broadcastLength=GYM_BROADCAST_LENGTH, start=True):
+        self.exp = Experiment(targetName, ns3Path, py_binding, shmSize=shmSize,
+                              useVector=True, vectorSize=0, segName=segName,
+                              broadcastCapacity=broadcastCapacity,
+                              broadcastLength=broadcastLength)
         self.ns3Settings = ns3Settings
+        self.rawBox = rawBox
 
         self.newStateRx = False
         self.obsData = None
         self.reward = 0
-        self.gameOver = False
         self.gameOverReason = None
         self.extraInfo = None
 
-        self.msgInterface = self.exp.run(setting=self.ns3Settings, show_output=True)
-        self.initialize_env()
-        # get first observations
-        self.rx_env_state()
-        self.envDirty = False
+        self.msgInterface = None
+        # no simulation yet, start_reset starts the first one
+        self.gameOver = True
+        self.envDirty = True
+        if start:
+            self.start_reset()
+            self.finish_reset()
 
     def step(self, actions):
         self.send_actions(actions)
@@ -298,9 +371,21 @@ class Ns3Env(gym.Env):
         return self.get_state()
 
     def reset(self, seed=None, options=None):
-        if not self.envDirty:
-            obs = self.get_obs()
-            return obs, {}
+        if self.start_reset():
+            self.finish_reset()
+        obs = self.get_obs()
+        return obs, {}
+
+    # ends the episode and starts the next simulation without waiting for
+    # it, so that several environments restart at once (see Ns3VectorEnv).
+    # Returns False if the environment is already at the start of an
+    # episode, otherwise finish_reset must be called next.
+    # \param[in] force : restart even at the start of an episode, e.g., after
+    #                    changing ns3Settings
+    # \param[in] checkEarly : see Experiment.run
+    def start_reset(self, force=False, checkEarly=True):
+        if not self.envDirty and not force:
+            return False
 
         # not using self.exp.kill() here in order for semaphores to reset to initial state
         if not self.gameOver:
@@ -315,15 +400,17 @@ class Ns3Env(gym.Env):
         self.gameOverReason = None
         self.extraInfo = None
 
-        self.msgInterface = self.exp.run(show_output=True)
+        self.msgInterface = self.exp.run(setting=self.ns3Settings, show_output=True,
+                                         checkEarly=checkEarly)
+        return True
+
+    # waits for the simulation started by start_reset and its first observations
+    def finish_reset(self):
         self.initialize_env()
         # get first observations
         self.rx_env_state()
         self.envDirty = False
 
-        obs = self.get_obs()
-        return obs, {}
-
     def render(self, mode='human'):
         return
 
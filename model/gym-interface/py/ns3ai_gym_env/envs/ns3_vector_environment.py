@@ -0,0 +1,158 @@
+import os
+import numpy as np
+from gymnasium.vector import VectorEnv
+from gymnasium.vector.utils import batch_space, concatenate, create_empty_array, iterate
+from .ns3_environment import Ns3Env, GYM_SEGMENT_SIZE
+
+try:
+    from gymnasium.vector import AutoresetMode
+except ImportError:
+    # gymnasium < 1.0 always resets in the same step
+    AutoresetMode = None
+
+
+# K ns-3 simulations of one program behind the gymnasium VectorEnv API. Each
+# sub-environment is an Ns3Env with its own process and shared memory segment.
+# A step sends every action before waiting for any observation, so the
+# simulations run concurrently. A sub-environment whose episode ends is reset
+# in the same step: the observation returned is the first of the new episode,
+# and the last one is in the infos (final_obs, or final_observation before
+# gymnasium 1.0). The simulations that end in a step restart at once, while
+# the observations of the others are read, and are checked for an early end
+# with a single wait.
+#
+# The seed passed to reset seeds the action spaces and restarts every
+# simulation with its own run number, given to ns-3 in the seedKey argument:
+# episode n of sub-environment i runs with seed + i + n * numEnvs, so that no
+# two episodes share one. Without a seed, the simulations keep the arguments
+# of ns3Settings.
+class Ns3VectorEnv(VectorEnv):
+
+    # \param[in] numEnvs : number of simulations
+    # \param[in] segName : prefix of the segment names, followed by the index
+    #                      of the sub-environment (default: one per process)
+    # \param[in] ns3Settings : arguments of every simulation, or a list of
+    #                          those of each one
+    # \param[in] seedKey : argument of the run number, see reset (default:
+    #                      the RngRun global value of ns-3)
+    # other parameters are those of Ns3Env, for every sub-environment
+    def __init__(self, targetName, ns3Path, numEnvs, ns3Settings=None,
+                 shmSize=GYM_SEGMENT_SIZE, rawBox=True, segName=None, seedKey='RngRun'):
+        if segName is None:
+            segName = 'ns3ai_gym_{}'.format(os.getpid())
+        # every Experiment changes to ns3Path
+        ns3Path = os.path.abspath(ns3Path)
+        if not isinstance(ns3Settings, (list, tuple)):
+            ns3Settings = [ns3Settings] * numEnvs
+        self._ns3Settings = list(ns3Settings)
+        self.seedKey = seedKey
+        # run numbers of the next episodes, see reset
+        self._runs = None
+        self.envs = []
+        for i in range(numEnvs):
+            self.envs.append(Ns3Env(targetName, ns3Path, ns3Settings=ns3Settings[i],
+                                    shmSize=shmSize, rawBox=rawBox,
+                                    segName='{}_{}'.format(segName, i), start=False))
+        # start every simulation before waiting for any
+        for env in self.envs:
+            env.start_reset(checkEarly=False)
+        for env in self.envs:
+            env.exp.check_early_ending()
+            env.finish_reset()
+
+        self.num_envs = numEnvs
+        self.single_observation_space = self.envs[0].observation_space
+        self.single_action_space = self.envs[0].action_space
+        self.observation_space = batch_space(self.single_observation_space, numEnvs)
+        self.action_space = batch_space(self.single_action_space, numEnvs)
+        self.is_vector_env = True
+        self.closed = False
+        self.metadata = {'render_modes': []}
+        if AutoresetMode is not None:
+            self.metadata['autoreset_mode'] = AutoresetMode.SAME_STEP
+        self._finalKeys = (('final_obs', 'final_info') if AutoresetMode is not None
+                           else ('final_observation', 'final_info'))
+
+        self._obs = create_empty_array(self.single_observation_space, numEnvs)
+        self._rewards = np.zeros(numEnvs, dtype=np.float64)
+        self._terminations = np.zeros(numEnvs, dtype=np.bool_)
+        self._truncations = np.zeros(numEnvs, dtype=np.bool_)
+
+    # starts the next simulation of sub-environment i, with the next run
+    # number if reset was given a seed. Returns whether it restarted.
+    def _start_reset(self, i, force=False):
+        env = self.envs[i]
+        if self._runs is not None:
+            settings = dict(self._ns3Settings[i] or {})
+            settings[self.seedKey] = self._runs[i]
+            env.ns3Settings = settings
+        if not env.start_reset(force=force, checkEarly=False):
+            return False
+        if self._runs is not None:
+            self._runs[i] += self.num_envs
+        return True
+
+    # waits for the simulation started by _start_reset
+    def _finish_reset(self, i):
+        self.envs[i].exp.check_early_ending()
+        self.envs[i].finish_reset()
+
+    def reset(self, seed=None, options=None):
+        if seed is not None:
+            self.action_space.seed(seed)
+            self.single_action_space.seed(seed)
+            self._runs = [seed + i for i in range(self.num_envs)]
+        # start the simulations of every sub-environment before waiting for any,
+        # all of them with a seed, as the running ones have other run numbers
+        restarted = [self._start_reset(i, force=seed is not None)
+                     for i in range(self.num_envs)]
+        obs = []
+        infos = {}
+        for i, env in enumerate(self.envs):
+            if restarted[i]:
+                self._finish_reset(i)
+            obs.append(env.get_obs())
+            infos = self._add_info(infos, {}, i)
+        self._obs = concatenate(self.single_observation_space, obs, self._obs)
+        return self._obs, infos
+
+    def step_async(self, actions):
+        for env, action in zip(self.envs, iterate(self.action_space, actions)):
+            env.send_actions(action)
+
+    def step_wait(self):
+        stepInfos = []
+        for i, env in enumerate(self.envs):
+            env.rx_env_state()
+            env.envDirty = True
+            envObs, reward, terminated, truncated, info = env.get_state()
+            self._rewards[i] = reward
+            self._terminations[i] = terminated
+            self._truncations[i] = truncated
+            if terminated or truncated:
+                info = {self._finalKeys[0]: envObs, self._finalKeys[1]: info}
+                # the simulation starts while the others are read
+                self._start_reset(i)
+            stepInfos.append(info)
+
+        obs = []
+        infos = {}
+        for i, env in enumerate(self.envs):
+            if self._terminations[i] or self._truncations[i]:
+                self._finish_reset(i)
+            obs.append(env.get_obs())
+            infos = self._add_info(infos, stepInfos[i], i)
+        self._obs = concatenate(self.single_observation_space, obs, self._obs)
+        return (self._obs, np.copy(self._rewards), np.copy(self._terminations),
+                np.copy(self._truncations), infos)
+
+    def step(self, actions):
+        self.step_async(actions)
+        return self.step_wait()
+
+    def close(self, **kwargs):
+        if self.closed:
+            return
+        for env in self.envs:
+            env.close()
+        self.closed = True
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+/*
+ * Helpers for the pybind11 modules of the message interface. This header is
+ * only included by the bindings and is not part of ai-module.h, so ns-3
+ * programs do not depend on pybind11.
+ */
+
+#ifndef NS3_AI_MSG_BINDING_H
+#define NS3_AI_MSG_BINDING_H
+
+#include "ns3-ai-msg-interface.h"
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+#include <type_traits>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \brief A field of a message struct, see NS3_AI_PY_STRUCT
+ */
+template <typename T, typename M>
+struct Ns3AiPyField
+{
+    const char* name;
+    M T::*member;
+};
+
+template <typename T, typename M>
+Ns3AiPyField<T, M>
+MakeNs3AiPyField(const char* name, M T::*member)
+{
+    return {name, member};
+}
+
+/**
+ * Binds the struct T as a Python class with a read-write attribute per field
+ */
+template <typename T, typename... M>
+pybind11::class_<T>
+Ns3AiPyStruct(pybind11::module_& m, const char* name, Ns3AiPyField<T, M>... fields)
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Messages in shared memory must be trivially copyable");
+    pybind11::class_<T> cls(m, name);
+    cls.def(pybind11::init<>());
+    (cls.def_readwrite(fields.name, fields.member), ...);
+    return cls;
+}
+
+/**
+ * Binds Ns3AiHistogram and Ns3AiMsgStats, returned by GetStats. They are
+ * local to the module, so that every module of a program can bind them.
+ */
+inline void
+Ns3AiPyDefStats(pybind11::module_& m)
+{
+    namespace py = pybind11;
+    py::class_<Ns3AiHistogram>(m, "Ns3AiHistogram", py::module_local())
+        .def("GetCount", &Ns3AiHistogram::GetCount)
+        .def("GetMean", &Ns3AiHistogram::GetMean)
+        .def("GetMax", &Ns3AiHistogram::GetMax)
+        .def("GetPercentile", &Ns3AiHistogram::GetPercentile)
+        .def("GetBucket", &Ns3AiHistogram::GetBucket)
+        .def_static("BucketLowerBound", &Ns3AiHistogram::BucketLowerBound)
+        .def("Reset", &Ns3AiHistogram::Reset);
+
+    py::class_<Ns3AiMsgStats>(m, "Ns3AiMsgStats", py::module_local())
+        .def("GetCounter", &Ns3AiMsgStats::GetCounter)
+        .def("GetHistogram", &Ns3AiMsgStats::GetHistogram, py::return_value_policy::reference)
+        .def("Reset", &Ns3AiMsgStats::Reset);
+}
+
+/**
+ * Binds the subscriber of the messages C++ side broadcasts (see
+ * Ns3AiMsgInterfaceImpl::EnableBroadcast). Recv releases the GIL. GetBytes
+ * views the whole message read, e.g. the items of a vector message.
+ */
+template <typename MsgType>
+pybind11::class_<Ns3AiMsgSubscriber<MsgType>>
+Ns3AiPyDefSubscriber(pybind11::module_& m, const char* name = "Ns3AiMsgSubscriber")
+{
+    namespace py = pybind11;
+    using Subscriber = Ns3AiMsgSubscriber<MsgType>;
+    py::class_<Subscriber> cls(m, name);
+    cls.def(py::init<const char*, const char*>())
+        .def("Recv",
+             &Subscriber::Recv,
+             py::arg("timeoutMs"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("GetMsg", &Subscriber::GetMsg, py::return_value_policy::reference)
+        .def("GetLength", &Subscriber::GetLength)
+        .def("GetBytes",
+             [](Subscriber& sub) {
+                 return py::memoryview::from_memory(
+                     static_cast<const void*>(sub.GetMsg()),
+                     static_cast<py::ssize_t>(sub.GetLength() * sizeof(MsgType)));
+             })
+        .def("GetSeq", &Subscriber::GetSeq)
+        .def("GetLost", &Subscriber::GetLost)
+        .def("IsFinished", &Subscriber::IsFinished);
+    return cls;
+}
+
+/**
+ * Binds the Python side of the struct-based interface for the given
+ * messages, as the class name, with every optional feature. The waits
+ * release the GIL. For the vector-based interface, add Ns3AiPyDefVectors.
+ * The statistics must be bound as well, see Ns3AiPyDefStats.
+ */
+template <typename Cpp2PyMsgType, typename Py2CppMsgType>
+pybind11::class_<Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType>>
+Ns3AiPyDefInterface(pybind11::module_& m, const char* name = "Ns3AiMsgInterfaceImpl")
+{
+    namespace py = pybind11;
+    using Impl = Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType>;
+    py::class_<Impl> cls(m, name);
+    cls.def(py::init<bool,
+                     bool,
+                     bool,
+                     uint32_t,
+                     const char*,
+                     const char*,
+                     const char*,
+                     const char*>())
+        .def("PyRecvBegin", &Impl::PyRecvBegin, py::call_guard<py::gil_scoped_release>())
+        .def("PyRecvEnd", &Impl::PyRecvEnd)
+        .def("PySendBegin", &Impl::PySendBegin, py::call_guard<py::gil_scoped_release>())
+        .def("PySendEnd", &Impl::PySendEnd)
+        .def("PyTimedRecvBegin",
+             &Impl::PyTimedRecvBegin,
+             py::arg("timeoutMs"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("PyTimedSendBegin",
+             &Impl::PyTimedSendBegin,
+             py::arg("timeoutMs"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("PyTryRecvBegin", &Impl::PyTryRecvBegin)
+        .def("PyTrySendBegin", &Impl::PyTrySendBegin)
+        .def("PyGetFinished", &Impl::PyGetFinished)
+        .def("GetCpp2PyStruct", &Impl::GetCpp2PyStruct, py::return_value_policy::reference)
+        .def("GetPy2CppStruct", &Impl::GetPy2CppStruct, py::return_value_policy::reference)
+        .def("SetSpinBudget", &Impl::SetSpinBudget)
+        .def("GetSpinBudget", &Impl::GetSpinBudget)
+        .def("EnableStats", &Impl::EnableStats)
+        .def("GetStats", &Impl::GetStats, py::return_value_policy::reference)
+        .def("EnableActionDelay", &Impl::EnableActionDelay)
+        .def("GetActionDelay", &Impl::GetActionDelay)
+        .def("EnableNotify", &Impl::EnableNotify)
+        .def("GetNotifyFd", &Impl::GetNotifyFd)
+        .def("EnableRecord", &Impl::EnableRecord)
+        .def("EnableReplay", &Impl::EnableReplay)
+        .def("EnablePrefault", &Impl::EnablePrefault)
+        .def("GetMemoryFlags", &Impl::GetMemoryFlags)
+        .def("GetHugePageBytes", &Impl::GetHugePageBytes)
+        .def("GetPrefaultFaults", &Impl::GetPrefaultFaults)
+        .def("GetRunFaults", &Impl::GetRunFaults)
+        .def("EnablePost", &Impl::EnablePost)
+        .def("PyDrainBegin",
+             &Impl::PyDrainBegin,
+             py::arg("wait") = false,
+             py::call_guard<py::gil_scoped_release>())
+        .def("PyRecvOrDrainBegin",
+             &Impl::PyRecvOrDrainBegin,
+             py::call_guard<py::gil_scoped_release>())
+        .def("GetPostedStruct", &Impl::GetPostedStruct, py::return_value_policy::reference)
+        .def("PyDrainEnd", &Impl::PyDrainEnd)
+        .def("EnableBroadcast",
+             &Impl::EnableBroadcast,
+             py::arg("capacity"),
+             py::arg("length") = 1)
+        .def("EnableFreeRun",
+             &Impl::EnableFreeRun,
+             py::arg("observationLength") = 1,
+             py::arg("actionLength") = 1)
+        .def("PyWaitObservation",
+             &Impl::PyWaitObservation,
+             py::arg("timeoutMs"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("GetObservation", &Impl::GetObservation, py::return_value_policy::reference)
+        .def("GetObservationTime", &Impl::GetObservationTime)
+        .def("GetAction", &Impl::GetAction, py::return_value_policy::reference)
+        .def("PyPublishAction", &Impl::PyPublishAction);
+    return cls;
+}
+
+/**
+ * Adds the methods of the vector-based interface to a binding of
+ * Ns3AiPyDefInterface. Both vector types must be bound (and declared with
+ * PYBIND11_MAKE_OPAQUE) by the module. In free-running mode, the
+ * observation and the action are viewed as bytes (GetObservationBytes and
+ * GetActionBytes), e.g. for numpy.frombuffer.
+ */
+template <typename Cpp2PyMsgType, typename Py2CppMsgType, typename... Options>
+void
+Ns3AiPyDefVectors(
+    pybind11::class_<Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType>, Options...>& cls)
+{
+    namespace py = pybind11;
+    using Impl = Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType>;
+    cls.def("GetCpp2PyVector", &Impl::GetCpp2PyVector, py::return_value_policy::reference)
+        .def("GetPy2CppVector", &Impl::GetPy2CppVector, py::return_value_policy::reference)
+        .def("ResizeVectors", &Impl::ResizeVectors)
+        .def("EnableBatch", &Impl::EnableBatch)
+        .def("GetBatchCapacity", &Impl::GetBatchCapacity)
+        .def("PyAppend", &Impl::PyAppend, py::return_value_policy::reference)
+        .def("SetPy2CppLength", &Impl::SetPy2CppLength)
+        .def("GetObservationLength", &Impl::GetObservationLength)
+        .def("GetObservationBytes",
+             [](Impl& impl) {
+                 return py::memoryview::from_memory(
+                     static_cast<const void*>(impl.GetObservation()),
+                     static_cast<py::ssize_t>(impl.GetObservationLength() *
+                                              sizeof(Cpp2PyMsgType)));
+             })
+        .def("SetActionLength", &Impl::SetActionLength)
+        .def("GetActionLength", &Impl::GetActionLength)
+        .def("GetActionBytes", [](Impl& impl) {
+            return py::memoryview::from_memory(
+                static_cast<void*>(impl.GetAction()),
+                static_cast<py::ssize_t>(impl.GetActionLength() * sizeof(Py2CppMsgType)));
+        });
+}
+
+/**
+ * NumPy structured array of shape () viewing the message in shared memory,
+ * without copying it. The array keeps owner alive.
+ */
+template <typename T>
+pybind11::array_t<T>
+Ns3AiPyView(T* msg, pybind11::handle owner)
+{
+    return pybind11::array_t<T>(std::vector<pybind11::ssize_t>{}, msg, owner);
+}
+
+/**
+ * Adds GetCpp2PyStructView and GetPy2CppStructView to the binding of a
+ * struct-based interface. Both messages must be registered with
+ * NS3_AI_PY_STRUCT (or PYBIND11_NUMPY_DTYPE).
+ *
+ * The views point to the messages in shared memory, so they can be created
+ * once and reused (unless actions are delayed, see EnableActionDelay), but
+ * they are only consistent while the message is held, i.e. between
+ * PyRecvBegin and PyRecvEnd (or PySendBegin and PySendEnd).
+ */
+template <typename Cpp2PyMsgType, typename Py2CppMsgType, typename... Options>
+void
+Ns3AiPyDefStructViews(
+    pybind11::class_<Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType>, Options...>& cls)
+{
+    using Impl = Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType>;
+    cls.def("GetCpp2PyStructView", [](pybind11::object self) {
+        return Ns3AiPyView(self.cast<Impl&>().GetCpp2PyStruct(), self);
+    });
+    cls.def("GetPy2CppStructView", [](pybind11::object self) {
+        return Ns3AiPyView(self.cast<Impl&>().GetPy2CppStruct(), self);
+    });
+}
+
+/**
+ * Binds the Python side of the ring-buffer interface for the given messages,
+ * as the class name. The waits release the GIL. Indices and counts are checked
+ * against the number of readable messages, so that a stale one raises instead
+ * of reading or releasing a slot C++ side is writing.
+ */
+template <typename Cpp2PyMsgType, typename Py2CppMsgType>
+pybind11::class_<Ns3AiMsgRingImpl<Cpp2PyMsgType, Py2CppMsgType>>
+Ns3AiPyDefRing(pybind11::module_& m, const char* name = "Ns3AiMsgRingImpl")
+{
+    namespace py = pybind11;
+    using Impl = Ns3AiMsgRingImpl<Cpp2PyMsgType, Py2CppMsgType>;
+    py::class_<Impl> cls(m, name);
+    cls.def(py::init<bool, bool, uint32_t, uint32_t, const char*, const char*, const char*>())
+        .def("GetCapacity", &Impl::GetCapacity)
+        .def("SetSpinBudget", &Impl::SetSpinBudget)
+        .def("PyRecvBegin", &Impl::PyRecvBegin, py::call_guard<py::gil_scoped_release>())
+        .def("PyGetAvailable", &Impl::PyGetAvailable)
+        .def(
+            "GetCpp2PyStructAt",
+            [](Impl& self, uint32_t i) {
+                if (i >= self.PyGetAvailable())
+                {
+                    throw py::index_error();
+                }
+                return self.GetCpp2PyStructAt(i);
+            },
+            py::return_value_policy::reference)
+        .def("GetCpp2PySeq",
+             [](const Impl& self, uint32_t i) {
+                 if (i >= self.PyGetAvailable())
+                 {
+                     throw py::index_error();
+                 }
+                 return self.GetCpp2PySeq(i);
+             })
+        .def("PyRecvEnd",
+             [](Impl& self, uint32_t count) {
+                 if (count > self.PyGetAvailable())
+                 {
+                     throw py::value_error("Releasing more messages than readable");
+                 }
+                 self.PyRecvEnd(count);
+             })
+        .def("PySendBegin",
+             &Impl::PySendBegin,
+             py::return_value_policy::reference,
+             py::call_guard<py::gil_scoped_release>())
+        .def("GetPy2CppStruct",
+             &Impl::GetPy2CppStruct,
+             py::return_value_policy::reference)
+        .def("PySendEnd", &Impl::PySendEnd)
+        .def("PyGetFinished", &Impl::PyGetFinished);
+    return cls;
+}
+
+} // namespace ns3
+
+#define NS3_AI_PY_FIELD(Type, Field) ::ns3::MakeNs3AiPyField(#Field, &Type::Field)
+
+/**
+ * Binds the message struct Type as the Python class Name with an attribute
+ * per listed field, and registers it as a NumPy structured dtype with the
+ * same fields. Structs used as fields must be registered first. Evaluates
+ * to the pybind11::class_, so more methods can be chained, e.g.
+ *
+ *   NS3_AI_PY_STRUCT(m, EnvStruct, "PyEnvStruct", env_a, env_b).def("__copy__", ...);
+ */
+#define NS3_AI_PY_STRUCT(module, Type, Name, ...)                                                  \
+    (PYBIND11_NUMPY_DTYPE(Type, __VA_ARGS__),                                                      \
+     ::ns3::Ns3AiPyStruct<Type>(module,                                                            \
+                                Name,                                                              \
+                                PYBIND11_MAP_LIST(NS3_AI_PY_FIELD, Type, __VA_ARGS__)))
+
+#endif // NS3_AI_MSG_BINDING_H
@@ -0,0 +1,533 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_BROADCAST_H
+#define NS3_AI_MSG_BROADCAST_H
+
+#include "ns3-ai-msg-layout.h"
+#include "ns3-ai-semaphore.h"
+
+#include <ns3/abort.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <boost/interprocess/managed_shared_memory.hpp>
+
+namespace ns3
+{
+
+/**
+ * \brief Shared state of a broadcast ring, written by its only writer
+ */
+struct Ns3AiBroadcastSync
+{
+    // number of messages published
+    alignas(NS3_AI_CACHE_LINE_SIZE) volatile uint64_t m_published{0};
+    // changes with every message and at the finish, for readers to wait on
+    volatile uint32_t m_wake{0};
+    volatile uint32_t m_waiters{0};
+    volatile uint32_t m_finished{0};
+    uint32_t m_capacity{0};
+    uint32_t m_maxLength{1}; //!< messages a slot holds, more than one for vectors
+};
+
+/**
+ * \brief A slot of a broadcast ring. The sequence is 2n + 1 while message n
+ * is being written and 2n + 2 once it is written. A slot of a vector-based
+ * channel holds the items of a vector, which follow m_msg.
+ */
+template <typename MsgType>
+struct Ns3AiBroadcastSlot
+{
+    alignas(NS3_AI_CACHE_LINE_SIZE) volatile uint64_t m_seq;
+    uint32_t m_length; //!< number of messages in the slot
+    MsgType m_msg;
+};
+
+/**
+ * \brief Process-local view of a broadcast ring living in a shared memory
+ * segment: one writer, any number of readers.
+ *
+ * Unlike Ns3AiRing, the writer never waits for the readers. Each reader
+ * keeps its own cursor (the number of the next message it reads) in its
+ * view, so readers neither register nor slow each other down. A reader
+ * that falls more than the capacity behind skips the overwritten messages
+ * and counts them as lost; every slot is a sequence lock, so a message
+ * overwritten during the copy is never returned torn.
+ *
+ * Each slot holds up to a maximum length of messages (e.g., the items of
+ * a vector message), 1 for struct-based channels.
+ */
+template <typename MsgType>
+class Ns3AiBroadcast
+{
+  public:
+    typedef Ns3AiBroadcastSlot<MsgType> Slot;
+
+    static_assert(std::is_trivially_copyable<MsgType>::value,
+                  "Broadcast messages are copied byte by byte");
+
+    Ns3AiBroadcast()
+        : m_sync(nullptr),
+          m_slots(nullptr),
+          m_stride(0),
+          m_mask(0),
+          m_cursor(0),
+          m_lost(0)
+    {
+    }
+
+    /**
+     * Bytes of a slot holding up to maxLength messages
+     */
+    static std::size_t Stride(uint32_t maxLength)
+    {
+        return sizeof(Slot) +
+               Ns3AiMsgLayout::AlignUp((maxLength - 1) * sizeof(MsgType), NS3_AI_CACHE_LINE_SIZE);
+    }
+
+    /**
+     * Bytes of the segment taken by a ring of the given capacity
+     */
+    static std::size_t Size(const std::string& name, uint32_t capacity, uint32_t maxLength = 1)
+    {
+        return Ns3AiMsgLayout::ObjectSize<char>(name, capacity * Stride(maxLength)) +
+               Ns3AiMsgLayout::ObjectSize<Ns3AiBroadcastSync>(name + " Sync");
+    }
+
+    /**
+     * Constructs the ring in the segment. The capacity must be a
+     * power of two.
+     *
+     * \param maxLength the number of messages a slot holds
+     */
+    void Create(boost::interprocess::managed_shared_memory& segment,
+                const std::string& name,
+                uint32_t capacity,
+                uint32_t maxLength = 1)
+    {
+        assert(capacity != 0 && (capacity & (capacity - 1)) == 0 && maxLength != 0);
+        m_stride = Stride(maxLength);
+        m_slots = Ns3AiMsgLayout::Construct<char>(segment, name.c_str(), capacity * m_stride);
+        m_sync =
+            Ns3AiMsgLayout::Construct<Ns3AiBroadcastSync>(segment, (name + " Sync").c_str());
+        m_sync->m_capacity = capacity;
+        m_sync->m_maxLength = maxLength;
+        m_mask = capacity - 1;
+    }
+
+    /**
+     * Finds the ring constructed by the other side. A reader starts with
+     * the next message published.
+     *
+     * \return whether the ring exists in the segment
+     */
+    bool Open(boost::interprocess::managed_shared_memory& segment, const std::string& name)
+    {
+        m_slots = Ns3AiMsgLayout::Find<char>(segment, name.c_str());
+        m_sync = Ns3AiMsgLayout::Find<Ns3AiBroadcastSync>(segment, (name + " Sync").c_str());
+        if (!m_slots || !m_sync)
+        {
+            m_sync = nullptr;
+            return false;
+        }
+        m_stride = Stride(m_sync->m_maxLength);
+        m_mask = m_sync->m_capacity - 1;
+        m_cursor = m_sync->m_published;
+        return true;
+    }
+
+    /**
+     * Whether the ring is created or opened
+     */
+    bool IsAttached() const
+    {
+        return m_sync != nullptr;
+    }
+
+    /**
+     * Gets the number of messages a slot holds
+     */
+    uint32_t GetMaxLength() const
+    {
+        return m_sync->m_maxLength;
+    }
+
+    // for the writer:
+
+    /**
+     * Copies length messages (at most the maximum length) into the oldest
+     * slot, never waits
+     */
+    void Publish(const MsgType* msgs, uint32_t length)
+    {
+        assert(length <= m_sync->m_maxLength);
+        uint64_t n = m_sync->m_published;
+        Slot& slot = GetSlot(n);
+        slot.m_seq = 2 * n + 1;
+        __sync_synchronize();
+        slot.m_length = length;
+        std::memcpy(&slot.m_msg, msgs, length * sizeof(MsgType));
+        __sync_synchronize();
+        slot.m_seq = 2 * n + 2;
+        m_sync->m_published = n + 1;
+        Ns3AiSemaphore::store_and_wake(&m_sync->m_wake, m_sync->m_wake + 1, &m_sync->m_waiters);
+    }
+
+    /**
+     * Tells the readers that no message will follow
+     */
+    void SetFinished()
+    {
+        m_sync->m_finished = 1;
+        Ns3AiSemaphore::store_and_wake(&m_sync->m_wake, m_sync->m_wake + 1, &m_sync->m_waiters);
+    }
+
+    // for a reader:
+
+    /**
+     * Copies the messages of the slot at the cursor and advances it,
+     * waiting at most timeout_ns nanoseconds for them to be published
+     *
+     * \param msgs room for the maximum length of messages
+     * \param length set to the number of messages copied
+     * \return whether a slot is copied, false on timeout or when the
+     *         writer has finished and every slot is read
+     */
+    bool Read(MsgType* msgs, uint32_t& length, uint64_t timeout_ns)
+    {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point deadline = Clock::now() + std::chrono::nanoseconds(timeout_ns);
+        while (true)
+        {
+            // read before the count, so that a message published in between
+            // changes it and the futex does not sleep
+            uint32_t wake = Ns3AiSemaphore::atomic_read32(&m_sync->m_wake);
+            uint64_t published = m_sync->m_published;
+            if (m_cursor >= published)
+            {
+                if (m_sync->m_finished)
+                {
+                    return false;
+                }
+                if (!WaitWake(wake, deadline))
+                {
+                    return false;
+                }
+                continue;
+            }
+            if (published - m_cursor > m_mask + 1)
+            {
+                m_lost += published - (m_mask + 1) - m_cursor;
+                m_cursor = published - (m_mask + 1);
+            }
+            const Slot& slot = GetSlot(m_cursor);
+            uint64_t seq = slot.m_seq;
+            if (seq != 2 * m_cursor + 2)
+            {
+                // overwritten since the count was read
+                Ns3AiSemaphore::cpu_relax();
+                continue;
+            }
+            __sync_synchronize();
+            // bounded in case the slot is being overwritten, checked below
+            length = std::min(slot.m_length, m_sync->m_maxLength);
+            std::memcpy(msgs, &slot.m_msg, length * sizeof(MsgType));
+            __sync_synchronize();
+            if (slot.m_seq != seq)
+            {
+                continue;
+            }
+            ++m_cursor;
+            return true;
+        }
+    }
+
+    /**
+     * Gets the number of the next message the reader reads
+     */
+    uint64_t GetCursor() const
+    {
+        return m_cursor;
+    }
+
+    /**
+     * Gets the number of messages the reader skipped because the writer
+     * overwrote them first
+     */
+    uint64_t GetLost() const
+    {
+        return m_lost;
+    }
+
+    /**
+     * Whether the writer has finished and the reader has read every message
+     */
+    bool IsFinished() const
+    {
+        return m_sync->m_finished && m_cursor >= m_sync->m_published;
+    }
+
+  private:
+    /**
+     * Gets the slot of message n
+     */
+    Slot& GetSlot(uint64_t n) const
+    {
+        return *reinterpret_cast<Slot*>(m_slots + (n & m_mask) * m_stride);
+    }
+
+    /**
+     * Waits until the wake word differs from wake or the deadline passes
+     *
+     * \return false on timeout
+     */
+    bool WaitWake(uint32_t wake, std::chrono::steady_clock::time_point deadline)
+    {
+        using Clock = std::chrono::steady_clock;
+        Ns3AiSemaphore::atomic_add32(&m_sync->m_waiters, 1);
+        bool woken;
+        while (!(woken = Ns3AiSemaphore::atomic_read32(&m_sync->m_wake) != wake))
+        {
+            Clock::time_point now = Clock::now();
+            if (now >= deadline)
+            {
+                break;
+            }
+            uint64_t left =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+            struct timespec timeout;
+            timeout.tv_sec = left / 1000000000;
+            timeout.tv_nsec = left % 1000000000;
+            Ns3AiSemaphore::futex_wait(&m_sync->m_wake, wake, &timeout);
+        }
+        Ns3AiSemaphore::atomic_add32(&m_sync->m_waiters, -1);
+        return woken;
+    }
+
+    Ns3AiBroadcastSync* m_sync;
+    char* m_slots;
+    std::size_t m_stride; //!< bytes of a slot
+    uint32_t m_mask;
+    uint64_t m_cursor; //!< number of the next message read, for a reader
+    uint64_t m_lost;   //!< number of messages skipped, for a reader
+};
+
+/**
+ * \brief The broadcast of the C++ to Python messages of a channel, see
+ * Ns3AiMsgInterfaceImpl::EnableBroadcast
+ *
+ * Python side creates the ring, and C++ side finds it when it opens the
+ * segment and copies every message it sends into it.
+ */
+template <typename MsgType>
+class Ns3AiMsgBroadcaster
+{
+  public:
+    Ns3AiMsgBroadcaster() = delete;
+
+    /**
+     * \param name the name of the ring in the segment
+     */
+    explicit Ns3AiMsgBroadcaster(const std::string& name)
+        : m_name(name)
+    {
+    }
+
+    /**
+     * Bytes of the segment taken by a ring of the given capacity
+     */
+    std::size_t Size(uint32_t capacity, uint32_t maxLength) const
+    {
+        return Ns3AiBroadcast<MsgType>::Size(m_name, capacity, maxLength);
+    }
+
+    /**
+     * Constructs the ring, on Python side
+     */
+    void Create(boost::interprocess::managed_shared_memory& segment,
+                uint32_t capacity,
+                uint32_t maxLength)
+    {
+        m_broadcast.Create(segment, m_name, capacity, maxLength);
+    }
+
+    /**
+     * Finds the ring if Python side enabled the broadcast, e.g. after the
+     * segment is opened or mapped again
+     */
+    void Open(boost::interprocess::managed_shared_memory& segment)
+    {
+        m_broadcast.Open(segment, m_name);
+    }
+
+    bool IsAttached() const
+    {
+        return m_broadcast.IsAttached();
+    }
+
+    /**
+     * Copies a message of length items into the ring, on C++ side. Aborts
+     * if it is longer than a slot.
+     */
+    void Publish(const MsgType* msgs, uint32_t length)
+    {
+        NS_ABORT_MSG_IF(length > m_broadcast.GetMaxLength(),
+                        "A message of " << length
+                                        << " items does not fit in the broadcast slots of "
+                                        << m_broadcast.GetMaxLength()
+                                        << " items, see EnableBroadcast");
+        m_broadcast.Publish(msgs, length);
+    }
+
+    /**
+     * Tells the subscribers that no message will follow, if the broadcast
+     * is enabled
+     */
+    void SetFinished()
+    {
+        if (IsAttached())
+        {
+            m_broadcast.SetFinished();
+        }
+    }
+
+  private:
+    const std::string m_name;
+    Ns3AiBroadcast<MsgType> m_broadcast;
+};
+
+/**
+ * \brief A read-only subscriber to the C++ to Python messages of a
+ * channel, in a process other than the one answering C++ side (e.g., a
+ * dashboard, a dataset writer or an evaluator)
+ *
+ * Python side of the channel enables the broadcast with
+ * Ns3AiMsgInterfaceImpl::EnableBroadcast, after which C++ side copies
+ * every message it sends into a broadcast ring. Subscribers open the
+ * segment by name and read the ring at their own pace, never delaying
+ * the channel. For a vector-based channel, a message is the items of a
+ * vector (see GetLength).
+ */
+template <typename Cpp2PyMsgType>
+class Ns3AiMsgSubscriber
+{
+  public:
+    Ns3AiMsgSubscriber() = delete;
+
+    /**
+     * Opens the segment of a channel, which must exist
+     *
+     * \param segment_name the name of the channel's segment
+     * \param cpp2py_msg_name the name of its C++ to Python message
+     */
+    explicit Ns3AiMsgSubscriber(const char* segment_name = "My Seg",
+                                const char* cpp2py_msg_name = "My Cpp to Python Msg")
+        : m_segment(boost::interprocess::open_only, segment_name),
+          m_length(0),
+          m_seq(0)
+    {
+        if (!m_broadcast.Open(m_segment, std::string(cpp2py_msg_name) + " Broadcast"))
+        {
+            throw std::runtime_error(std::string("Broadcast is not enabled in segment ") +
+                                     segment_name);
+        }
+        m_msgs.resize(m_broadcast.GetMaxLength());
+    };
+
+    /**
+     * Waits at most timeoutMs milliseconds for the next message and
+     * copies it (see GetMsg)
+     *
+     * \return whether a message is read, false on timeout or when the
+     *         simulation is over (see IsFinished)
+     */
+    bool Recv(uint32_t timeoutMs)
+    {
+        if (!m_broadcast.Read(m_msgs.data(), m_length, timeoutMs * UINT64_C(1000000)))
+        {
+            return false;
+        }
+        m_seq = m_broadcast.GetCursor() - 1;
+        return true;
+    };
+
+    /**
+     * Gets the copy of the message read by Recv, the first item for a
+     * vector-based channel
+     */
+    Cpp2PyMsgType* GetMsg()
+    {
+        return m_msgs.data();
+    };
+
+    /**
+     * Gets the number of items of the message read by Recv, 1 for a
+     * struct-based channel
+     */
+    uint32_t GetLength() const
+    {
+        return m_length;
+    };
+
+    /**
+     * Gets the number of the message read by Recv, counting every message
+     * C++ side sent
+     */
+    uint64_t GetSeq() const
+    {
+        return m_seq;
+    };
+
+    /**
+     * Gets the number of messages this subscriber missed because it fell
+     * too far behind
+     */
+    uint64_t GetLost() const
+    {
+        return m_broadcast.GetLost();
+    };
+
+    /**
+     * Whether the simulation is over and every message is read
+     */
+    bool IsFinished() const
+    {
+        return m_broadcast.IsFinished();
+    };
+
+  private:
+    boost::interprocess::managed_shared_memory m_segment;
+    Ns3AiBroadcast<Cpp2PyMsgType> m_broadcast;
+    std::vector<Cpp2PyMsgType> m_msgs; //!< room for the largest message
+    uint32_t m_length;
+    uint64_t m_seq;
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_BROADCAST_H
@@ -0,0 +1,1139 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_CHANNEL_H
+#define NS3_AI_MSG_CHANNEL_H
+
+#include "ns3-ai-msg-layout.h"
+#include "ns3-ai-msg-memory.h"
+#include "ns3-ai-msg-segment.h"
+#include "ns3-ai-semaphore.h"
+
+#include <ns3/abort.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <boost/interprocess/allocators/allocator.hpp>
+#include <boost/interprocess/containers/vector.hpp>
+#include <boost/interprocess/managed_shared_memory.hpp>
+
+namespace ns3
+{
+
+/**
+ * \brief Structure containing semaphores used in msg interface
+ *
+ * Each semaphore and its waiter count sit on their own cache line, so that
+ * posting one semaphore does not invalidate the line the other process is
+ * spinning on.
+ */
+struct Ns3AiMsgSync
+{
+    alignas(NS3_AI_CACHE_LINE_SIZE) volatile uint32_t m_cpp2pyEmptyCount{1};
+    // number of processes parked on the semaphore above
+    volatile uint32_t m_cpp2pyEmptyWaiters{0};
+    alignas(NS3_AI_CACHE_LINE_SIZE) volatile uint32_t m_cpp2pyFullCount{0};
+    volatile uint32_t m_cpp2pyFullWaiters{0};
+    // rung when a message is sent or the posted ring is full, for Python side
+    // waiting in Ns3AiMsgInterfaceImpl::PyRecvOrDrainBegin
+    volatile uint32_t m_pyWake{0};
+    volatile uint32_t m_pyWakeWaiters{0};
+    alignas(NS3_AI_CACHE_LINE_SIZE) volatile uint32_t m_py2cppEmptyCount{1};
+    volatile uint32_t m_py2cppEmptyWaiters{0};
+    alignas(NS3_AI_CACHE_LINE_SIZE) volatile uint32_t m_py2cppFullCount{0};
+    volatile uint32_t m_py2cppFullWaiters{0};
+    alignas(NS3_AI_CACHE_LINE_SIZE) bool m_isFinished{false};
+    // number of C++ to Python messages sent before the finishing one
+    uint64_t m_finishSeq{0};
+    // number of buffers per message, see Ns3AiMsgInterfaceImpl::EnableActionDelay
+    uint32_t m_depth{1};
+    // whether the other side has opened the segment, which can no longer grow
+    bool m_isOpened{false};
+    // capacity of the vectors in batches, 0 for fixed-size vectors
+    uint32_t m_batchCapacity{0};
+    // FIFO written by C++ side when Python side awaits, see EnableNotify
+    char m_notifyPath[64]{};
+    // pre-faulting and huge pages, see Ns3AiMsgInterfaceImpl::EnablePrefault
+    Ns3AiMsgMemoryState m_memory;
+};
+
+/// Policy of Ns3AiChannel: each message is a single struct
+struct Ns3AiStructMode
+{
+};
+
+/// Policy of Ns3AiChannel: each message is a vector of structs
+struct Ns3AiVectorMode
+{
+};
+
+/// Policy of Ns3AiChannel: C++ side tells Python side when the simulation is over
+struct Ns3AiHandleFinish
+{
+};
+
+/// Policy of Ns3AiChannel: the channel is used until the processes exit
+struct Ns3AiNoFinish
+{
+};
+
+/**
+ * \brief The buffers of the messages of an Ns3AiChannel: one per message,
+ * or several used in turn when actions are delayed (see
+ * Ns3AiChannel::EnableActionDelay)
+ */
+template <typename Cpp2PyBuffer, typename Py2CppBuffer>
+class Ns3AiChannelBuffers
+{
+  public:
+    /**
+     * Gets the number of buffers per message
+     */
+    uint32_t GetDepth() const
+    {
+        return m_depth;
+    };
+
+  protected:
+    Ns3AiChannelBuffers()
+        : m_cpp2py(nullptr),
+          m_py2cpp(nullptr),
+          m_depth(0),
+          m_cpp2pyIndex(0),
+          m_py2cppIndex(0)
+    {
+    }
+
+    /**
+     * Gets the name of the i-th buffer of a message, the name of the
+     * message for the first one
+     */
+    static std::string BufferName(const std::string& name, uint32_t i)
+    {
+        return i == 0 ? name : name + " " + std::to_string(i);
+    }
+
+    void AddBuffers(Cpp2PyBuffer* cpp2py, Py2CppBuffer* py2cpp)
+    {
+        m_cpp2pys.push_back(cpp2py);
+        m_py2cpps.push_back(py2cpp);
+        m_depth = m_cpp2pys.size();
+        Select();
+    }
+
+    /**
+     * Forgets the buffers, before they are found again
+     */
+    void ClearBuffers()
+    {
+        m_cpp2pys.clear();
+        m_py2cpps.clear();
+        m_depth = 0;
+    }
+
+    /**
+     * Makes the buffer at the index the current message, e.g. after the
+     * buffers are found again
+     */
+    void Select()
+    {
+        if (m_cpp2pyIndex < m_depth)
+        {
+            m_cpp2py = m_cpp2pys[m_cpp2pyIndex];
+        }
+        if (m_py2cppIndex < m_depth)
+        {
+            m_py2cpp = m_py2cpps[m_py2cppIndex];
+        }
+    }
+
+    /**
+     * Moves to the next C++ to Python buffer after a message is sent or read
+     */
+    void NextCpp2Py()
+    {
+        if (m_depth > 1)
+        {
+            m_cpp2pyIndex = m_cpp2pyIndex + 1 < m_depth ? m_cpp2pyIndex + 1 : 0;
+            m_cpp2py = m_cpp2pys[m_cpp2pyIndex];
+        }
+    }
+
+    /**
+     * Moves to the next Python to C++ buffer after a message is sent or read
+     */
+    void NextPy2Cpp()
+    {
+        if (m_depth > 1)
+        {
+            m_py2cppIndex = m_py2cppIndex + 1 < m_depth ? m_py2cppIndex + 1 : 0;
+            m_py2cpp = m_py2cpps[m_py2cppIndex];
+        }
+    }
+
+    // the buffers of the current messages
+    Cpp2PyBuffer* m_cpp2py;
+    Py2CppBuffer* m_py2cpp;
+    // all buffers, more than one if actions are delayed
+    std::vector<Cpp2PyBuffer*> m_cpp2pys;
+    std::vector<Py2CppBuffer*> m_py2cpps;
+    uint32_t m_depth;       //!< number of buffers per message
+    uint32_t m_cpp2pyIndex; //!< buffer of the current C++ to Python message
+    uint32_t m_py2cppIndex; //!< buffer of the current Python to C++ message
+};
+
+/**
+ * \brief The messages of an Ns3AiChannel, specialized by mode so that
+ * only the pointers and accessors of that mode exist
+ *
+ * Both modes also give the current messages as items (a struct being one
+ * item), for the code that does not depend on the mode.
+ */
+template <typename Cpp2PyMsgType, typename Py2CppMsgType, typename Mode>
+class Ns3AiChannelMsgs;
+
+template <typename Cpp2PyMsgType, typename Py2CppMsgType>
+class Ns3AiChannelMsgs<Cpp2PyMsgType, Py2CppMsgType, Ns3AiStructMode>
+    : public Ns3AiChannelBuffers<Cpp2PyMsgType, Py2CppMsgType>
+{
+  public:
+    /**
+     * Get the struct used in C++ to Python transmission
+     */
+    Cpp2PyMsgType* GetCpp2PyStruct() const
+    {
+        return this->m_cpp2py;
+    };
+
+    /**
+     * Get the struct used in Python to C++ transmission
+     */
+    Py2CppMsgType* GetPy2CppStruct() const
+    {
+        return this->m_py2cpp;
+    };
+
+    const Cpp2PyMsgType* GetCpp2PyData() const
+    {
+        return this->m_cpp2py;
+    };
+
+    uint32_t GetCpp2PyLength() const
+    {
+        return 1;
+    };
+
+    const Py2CppMsgType* GetPy2CppData() const
+    {
+        return this->m_py2cpp;
+    };
+
+    uint32_t GetPy2CppLength() const
+    {
+        return 1;
+    };
+
+    /**
+     * Copies bytes (a whole struct) into the current C++ to Python message
+     */
+    void CopyCpp2Py(const void* data, std::size_t bytes)
+    {
+        assert(bytes == sizeof(Cpp2PyMsgType));
+        std::memcpy(this->m_cpp2py, data, bytes);
+    };
+
+  protected:
+    /**
+     * Bytes of the segment taken by the i-th buffer of each message
+     */
+    std::size_t Size(const std::string& cpp2pyName,
+                     const std::string& py2cppName,
+                     uint32_t i = 0) const
+    {
+        return Ns3AiMsgLayout::ObjectSize<Cpp2PyMsgType>(this->BufferName(cpp2pyName, i)) +
+               Ns3AiMsgLayout::ObjectSize<Py2CppMsgType>(this->BufferName(py2cppName, i));
+    }
+
+    /**
+     * Constructs the next buffer of each message. Those after the first
+     * one start with the initial Python to C++ message.
+     */
+    void Construct(boost::interprocess::managed_shared_memory& segment,
+                   const std::string& cpp2pyName,
+                   const std::string& py2cppName)
+    {
+        uint32_t i = this->m_depth;
+        Cpp2PyMsgType* cpp2py = Ns3AiMsgLayout::Construct<Cpp2PyMsgType>(
+            segment,
+            this->BufferName(cpp2pyName, i).c_str());
+        Py2CppMsgType* py2cpp = Ns3AiMsgLayout::Construct<Py2CppMsgType>(
+            segment,
+            this->BufferName(py2cppName, i).c_str());
+        if (i != 0)
+        {
+            *py2cpp = *this->m_py2cpps[0];
+        }
+        this->AddBuffers(cpp2py, py2cpp);
+    }
+
+    /**
+     * Finds the next buffer of each message
+     *
+     * \return whether they exist, i.e. the other side uses struct mode
+     */
+    bool Find(boost::interprocess::managed_shared_memory& segment,
+              const std::string& cpp2pyName,
+              const std::string& py2cppName)
+    {
+        uint32_t i = this->m_depth;
+        Cpp2PyMsgType* cpp2py =
+            Ns3AiMsgLayout::Find<Cpp2PyMsgType>(segment, this->BufferName(cpp2pyName, i).c_str());
+        Py2CppMsgType* py2cpp =
+            Ns3AiMsgLayout::Find<Py2CppMsgType>(segment, this->BufferName(py2cppName, i).c_str());
+        if (!cpp2py || !py2cpp)
+        {
+            return false;
+        }
+        this->AddBuffers(cpp2py, py2cpp);
+        return true;
+    }
+};
+
+template <typename Cpp2PyMsgType, typename Py2CppMsgType>
+class Ns3AiChannelMsgs<Cpp2PyMsgType, Py2CppMsgType, Ns3AiVectorMode>
+    : public Ns3AiChannelBuffers<
+          boost::interprocess::vector<
+              Cpp2PyMsgType,
+              boost::interprocess::allocator<
+                  Cpp2PyMsgType,
+                  boost::interprocess::managed_shared_memory::segment_manager>>,
+          boost::interprocess::vector<
+              Py2CppMsgType,
+              boost::interprocess::allocator<
+                  Py2CppMsgType,
+                  boost::interprocess::managed_shared_memory::segment_manager>>>
+{
+  public:
+    typedef boost::interprocess::
+        allocator<Cpp2PyMsgType, boost::interprocess::managed_shared_memory::segment_manager>
+            Cpp2PyMsgAllocator;
+    typedef boost::interprocess::vector<Cpp2PyMsgType, Cpp2PyMsgAllocator> Cpp2PyMsgVector;
+    typedef boost::interprocess::
+        allocator<Py2CppMsgType, boost::interprocess::managed_shared_memory::segment_manager>
+            Py2CppMsgAllocator;
+    typedef boost::interprocess::vector<Py2CppMsgType, Py2CppMsgAllocator> Py2CppMsgVector;
+
+    /**
+     * Get the vector used in C++ to Python transmission
+     */
+    Cpp2PyMsgVector* GetCpp2PyVector() const
+    {
+        return this->m_cpp2py;
+    };
+
+    /**
+     * Get the vector used in Python to C++ transmission
+     */
+    Py2CppMsgVector* GetPy2CppVector() const
+    {
+        return this->m_py2cpp;
+    };
+
+    const Cpp2PyMsgType* GetCpp2PyData() const
+    {
+        return this->m_cpp2py->data();
+    };
+
+    uint32_t GetCpp2PyLength() const
+    {
+        return this->m_cpp2py->size();
+    };
+
+    const Py2CppMsgType* GetPy2CppData() const
+    {
+        return this->m_py2cpp->data();
+    };
+
+    uint32_t GetPy2CppLength() const
+    {
+        return this->m_py2cpp->size();
+    };
+
+    /**
+     * Copies bytes (whole items) into the current C++ to Python message,
+     * resized to them within its capacity, so that nothing moves
+     */
+    void CopyCpp2Py(const void* data, std::size_t bytes)
+    {
+        std::size_t count = bytes / sizeof(Cpp2PyMsgType);
+        assert(count <= this->m_cpp2py->capacity());
+        this->m_cpp2py->resize(count);
+        std::memcpy(this->m_cpp2py->data(), data, bytes);
+    };
+
+  protected:
+    /**
+     * Bytes of the segment taken by the i-th buffer of each message, with
+     * the capacity of the first ones
+     */
+    std::size_t Size(const std::string& cpp2pyName,
+                     const std::string& py2cppName,
+                     uint32_t i = 0) const
+    {
+        std::size_t bytes =
+            Ns3AiMsgLayout::NamedSize(this->BufferName(cpp2pyName, i), sizeof(Cpp2PyMsgVector)) +
+            Ns3AiMsgLayout::NamedSize(this->BufferName(py2cppName, i), sizeof(Py2CppMsgVector));
+        if (this->m_depth != 0)
+        {
+            bytes +=
+                Ns3AiMsgLayout::AllocSize(this->m_cpp2pys[0]->capacity() * sizeof(Cpp2PyMsgType)) +
+                Ns3AiMsgLayout::AllocSize(this->m_py2cpps[0]->capacity() * sizeof(Py2CppMsgType));
+        }
+        return bytes;
+    }
+
+    /**
+     * Constructs the next buffer of each message. Those after the first
+     * one are copies of the first ones, with the same capacity so that
+     * batches fit in every buffer.
+     */
+    void Construct(boost::interprocess::managed_shared_memory& segment,
+                   const std::string& cpp2pyName,
+                   const std::string& py2cppName)
+    {
+        uint32_t i = this->m_depth;
+        std::string cpp2pyBuffer = this->BufferName(cpp2pyName, i);
+        std::string py2cppBuffer = this->BufferName(py2cppName, i);
+        if (i == 0)
+        {
+            const Cpp2PyMsgAllocator allocCpp2Py(segment.get_segment_manager());
+            const Py2CppMsgAllocator allocPy2Cpp(segment.get_segment_manager());
+            this->AddBuffers(segment.construct<Cpp2PyMsgVector>(cpp2pyBuffer.c_str())(allocCpp2Py),
+                             segment.construct<Py2CppMsgVector>(py2cppBuffer.c_str())(allocPy2Cpp));
+        }
+        else
+        {
+            this->AddBuffers(CopyVector(segment, cpp2pyBuffer, *this->m_cpp2pys[0]),
+                             CopyVector(segment, py2cppBuffer, *this->m_py2cpps[0]));
+        }
+    }
+
+    /**
+     * Finds the next buffer of each message
+     *
+     * \return whether they exist, i.e. the other side uses vector mode
+     */
+    bool Find(boost::interprocess::managed_shared_memory& segment,
+              const std::string& cpp2pyName,
+              const std::string& py2cppName)
+    {
+        uint32_t i = this->m_depth;
+        Cpp2PyMsgVector* cpp2py =
+            segment.find<Cpp2PyMsgVector>(this->BufferName(cpp2pyName, i).c_str()).first;
+        Py2CppMsgVector* py2cpp =
+            segment.find<Py2CppMsgVector>(this->BufferName(py2cppName, i).c_str()).first;
+        if (!cpp2py || !py2cpp)
+        {
+            return false;
+        }
+        this->AddBuffers(cpp2py, py2cpp);
+        return true;
+    }
+
+  private:
+    /**
+     * Constructs a named copy of vec with the same capacity
+     */
+    template <typename Vector>
+    static Vector* CopyVector(boost::interprocess::managed_shared_memory& segment,
+                              const std::string& name,
+                              const Vector& vec)
+    {
+        Vector* copy = segment.construct<Vector>(name.c_str())(vec.get_allocator());
+        copy->reserve(vec.capacity());
+        copy->assign(vec.begin(), vec.end());
+        return copy;
+    }
+};
+
+/**
+ * \brief The finish state of an Ns3AiChannel, empty without finish
+ */
+template <typename Finish>
+struct Ns3AiChannelFinish
+{
+};
+
+template <>
+struct Ns3AiChannelFinish<Ns3AiHandleFinish>
+{
+    bool m_isFinished{false};
+    uint64_t m_cpp2pyCount{0}; //!< number of C++ to Python messages sent or read
+};
+
+/**
+ * \brief The lockstep handshake on the semaphores of an Ns3AiMsgSync,
+ * whatever the messages are
+ *
+ * Ns3AiChannel adds the messages of its mode, so that either mode and
+ * both sides of the protocol have a single implementation.
+ *
+ * \tparam Finish Ns3AiHandleFinish or Ns3AiNoFinish
+ */
+template <typename Finish>
+class Ns3AiChannelHandshake : private Ns3AiChannelFinish<Finish>
+{
+    static_assert(std::is_same<Finish, Ns3AiHandleFinish>::value ||
+                      std::is_same<Finish, Ns3AiNoFinish>::value,
+                  "Finish is Ns3AiHandleFinish or Ns3AiNoFinish");
+
+  public:
+    static constexpr bool HANDLE_FINISH = std::is_same<Finish, Ns3AiHandleFinish>::value;
+
+    explicit Ns3AiChannelHandshake(uint32_t spin_budget)
+        : m_sync(nullptr),
+          m_spinBudget(spin_budget)
+    {
+    }
+
+    /**
+     * Uses the semaphores of sync, e.g. after the segment is mapped again
+     */
+    void Attach(Ns3AiMsgSync* sync)
+    {
+        m_sync = sync;
+    };
+
+    void SetSpinBudget(uint32_t spinBudget)
+    {
+        m_spinBudget = spinBudget;
+    };
+
+    uint32_t GetSpinBudget() const
+    {
+        return m_spinBudget;
+    };
+
+    // for C++ side:
+
+    void CppSendBegin()
+    {
+        Ns3AiSemaphore::sem_wait(&m_sync->m_cpp2pyEmptyCount,
+                                 &m_sync->m_cpp2pyEmptyWaiters,
+                                 m_spinBudget);
+    };
+
+    void CppSendEnd()
+    {
+        if constexpr (HANDLE_FINISH)
+        {
+            ++this->m_cpp2pyCount;
+        }
+        Ns3AiSemaphore::sem_post(&m_sync->m_cpp2pyFullCount, &m_sync->m_cpp2pyFullWaiters);
+    };
+
+    void CppRecvBegin()
+    {
+        Ns3AiSemaphore::sem_wait(&m_sync->m_py2cppFullCount,
+                                 &m_sync->m_py2cppFullWaiters,
+                                 m_spinBudget);
+    };
+
+    void CppRecvEnd()
+    {
+        Ns3AiSemaphore::sem_post(&m_sync->m_py2cppEmptyCount, &m_sync->m_py2cppEmptyWaiters);
+    };
+
+    /**
+     * C++ side tells Python side that the simulation is over, at most once
+     */
+    template <typename F = Finish>
+    typename std::enable_if<std::is_same<F, Ns3AiHandleFinish>::value>::type CppSetFinished()
+    {
+        if (this->m_isFinished)
+        {
+            return;
+        }
+        this->m_isFinished = true;
+        CppSendBegin();
+        m_sync->m_finishSeq = this->m_cpp2pyCount;
+        m_sync->m_isFinished = true;
+        CppSendEnd();
+    };
+
+    // for Python side:
+
+    void PyRecvBegin()
+    {
+        Ns3AiSemaphore::sem_wait(&m_sync->m_cpp2pyFullCount,
+                                 &m_sync->m_cpp2pyFullWaiters,
+                                 m_spinBudget);
+        Received();
+    };
+
+    /**
+     * PyRecvBegin giving up after timeout_ns nanoseconds
+     *
+     * \return whether reading has started
+     */
+    bool PyTimedRecvBegin(uint64_t timeout_ns)
+    {
+        if (!Ns3AiSemaphore::sem_timed_wait(&m_sync->m_cpp2pyFullCount,
+                                            &m_sync->m_cpp2pyFullWaiters,
+                                            timeout_ns,
+                                            m_spinBudget))
+        {
+            return false;
+        }
+        Received();
+        return true;
+    };
+
+    /**
+     * PyRecvBegin if a message is ready, without waiting
+     *
+     * \return whether reading has started
+     */
+    bool PyTryRecvBegin()
+    {
+        if (!Ns3AiSemaphore::sem_try_wait(&m_sync->m_cpp2pyFullCount))
+        {
+            return false;
+        }
+        Received();
+        return true;
+    };
+
+    void PyRecvEnd()
+    {
+        if constexpr (HANDLE_FINISH)
+        {
+            ++this->m_cpp2pyCount;
+        }
+        Ns3AiSemaphore::sem_post(&m_sync->m_cpp2pyEmptyCount, &m_sync->m_cpp2pyEmptyWaiters);
+    };
+
+    void PySendBegin()
+    {
+        Ns3AiSemaphore::sem_wait(&m_sync->m_py2cppEmptyCount,
+                                 &m_sync->m_py2cppEmptyWaiters,
+                                 m_spinBudget);
+    };
+
+    /**
+     * PySendBegin giving up after timeout_ns nanoseconds
+     *
+     * \return whether writing has started
+     */
+    bool PyTimedSendBegin(uint64_t timeout_ns)
+    {
+        return Ns3AiSemaphore::sem_timed_wait(&m_sync->m_py2cppEmptyCount,
+                                              &m_sync->m_py2cppEmptyWaiters,
+                                              timeout_ns,
+                                              m_spinBudget);
+    };
+
+    /**
+     * PySendBegin if C++ side has read the previous message, without waiting
+     *
+     * \return whether writing has started
+     */
+    bool PyTrySendBegin()
+    {
+        return Ns3AiSemaphore::sem_try_wait(&m_sync->m_py2cppEmptyCount);
+    };
+
+    void PySendEnd()
+    {
+        Ns3AiSemaphore::sem_post(&m_sync->m_py2cppFullCount, &m_sync->m_py2cppFullWaiters);
+    };
+
+    /**
+     * Python side gets whether the simulation is over
+     */
+    template <typename F = Finish>
+    typename std::enable_if<std::is_same<F, Ns3AiHandleFinish>::value, bool>::type PyGetFinished()
+        const
+    {
+        return this->m_isFinished;
+    };
+
+  protected:
+    Ns3AiMsgSync* m_sync;
+
+  private:
+    /**
+     * Updates whether the simulation is over after a message is received.
+     * With delayed actions, messages sent before the finishing one may
+     * still be unread.
+     */
+    void Received()
+    {
+        if constexpr (HANDLE_FINISH)
+        {
+            this->m_isFinished =
+                m_sync->m_isFinished && m_sync->m_finishSeq == this->m_cpp2pyCount;
+        }
+    };
+
+    uint32_t m_spinBudget;
+};
+
+/**
+ * \brief The lockstep message channel with its mode fixed at compile time
+ *
+ * The channel owns the segment (see Ns3AiMsgSegment), the messages of its
+ * mode and the handshake, with the mode and the finish handling as
+ * policies: GetCpp2PyStruct compiles to a single load, the accessors of the
+ * other mode do not exist, and without finish the finish state and its
+ * checks are gone. It also does what changes the messages themselves:
+ * delayed actions, and batches in vector mode.
+ *
+ * Ns3AiMsgInterfaceImpl, which chooses the mode at run time, holds a
+ * channel of either mode and composes the other features (statistics,
+ * posted messages, notifications, ...) around it. The segment layout and
+ * the protocol are thus the same, so either side may use either class,
+ * e.g. this one in the simulation and the usual binding on Python side.
+ * A channel used on its own aborts when it opens a segment where Python
+ * side enabled a feature that only the impl supports.
+ *
+ * \tparam Mode Ns3AiStructMode or Ns3AiVectorMode
+ * \tparam Finish Ns3AiHandleFinish or Ns3AiNoFinish
+ */
+template <typename Cpp2PyMsgType,
+          typename Py2CppMsgType,
+          typename Mode = Ns3AiStructMode,
+          typename Finish = Ns3AiHandleFinish>
+class Ns3AiChannel : public Ns3AiChannelMsgs<Cpp2PyMsgType, Py2CppMsgType, Mode>,
+                     public Ns3AiChannelHandshake<Finish>
+{
+    typedef Ns3AiChannelMsgs<Cpp2PyMsgType, Py2CppMsgType, Mode> Msgs;
+    typedef Ns3AiChannelHandshake<Finish> Handshake;
+
+    static_assert(std::is_same<Mode, Ns3AiStructMode>::value ||
+                      std::is_same<Mode, Ns3AiVectorMode>::value,
+                  "Mode is Ns3AiStructMode or Ns3AiVectorMode");
+
+  public:
+    static constexpr bool USE_VECTOR = std::is_same<Mode, Ns3AiVectorMode>::value;
+    using Handshake::HANDLE_FINISH;
+
+    Ns3AiChannel() = delete;
+
+    /**
+     * \param with_features whether an Ns3AiMsgInterfaceImpl holds the
+     *        channel, which runs the features Python side enabled and
+     *        finishes the channel itself
+     */
+    explicit Ns3AiChannel(bool is_memory_creator,
+                          uint32_t size = 0,
+                          const char* segment_name = "My Seg",
+                          const char* cpp2py_msg_name = "My Cpp to Python Msg",
+                          const char* py2cpp_msg_name = "My Python to Cpp Msg",
+                          const char* lockable_name = "My Lockable",
+                          uint32_t spin_budget = Ns3AiSemaphore::DEFAULT_SPIN_BUDGET,
+                          bool with_features = false)
+        : Handshake(spin_budget),
+          // the size only needs to hold the messages and the semaphores,
+          // other objects grow the segment if needed (see Reserve)
+          m_segment(is_memory_creator,
+                    segment_name,
+                    std::max<std::size_t>(
+                        size,
+                        Ns3AiMsgLayout::SEGMENT_OVERHEAD +
+                            Ns3AiMsgLayout::ObjectSize<Ns3AiMsgSync>(lockable_name) +
+                            this->Size(cpp2py_msg_name, py2cpp_msg_name))),
+          m_cpp2pyName(cpp2py_msg_name),
+          m_py2cppName(py2cpp_msg_name),
+          m_lockableName(lockable_name),
+          m_withFeatures(with_features)
+    {
+        if (m_segment.IsCreator())
+        {
+            this->Construct(m_segment.Get(), m_cpp2pyName, m_py2cppName);
+            this->Attach(
+                Ns3AiMsgLayout::Construct<Ns3AiMsgSync>(m_segment.Get(), lockable_name));
+        }
+        else
+        {
+            FindObjects();
+            if (!m_withFeatures)
+            {
+                CheckFeatures();
+            }
+            this->m_sync->m_isOpened = true;
+            m_segment.Prepare(this->m_sync->m_memory);
+        }
+        m_segment.AddRemapCallback([this] {
+            FindObjects();
+            // the new mapping is neither advised, populated nor locked
+            m_segment.Prepare(this->m_sync->m_memory);
+        });
+    };
+
+    ~Ns3AiChannel()
+    {
+        if (!m_segment.IsCreator() && !m_withFeatures)
+        {
+            if constexpr (HANDLE_FINISH)
+            {
+                CppSetFinished();
+            }
+            else
+            {
+                RecordFaults();
+            }
+        }
+    };
+
+    Ns3AiChannel(const Ns3AiChannel&) = delete;
+    Ns3AiChannel& operator=(const Ns3AiChannel&) = delete;
+
+    Ns3AiMsgSegment& GetSegment()
+    {
+        return m_segment;
+    };
+
+    Ns3AiMsgSync* GetSync() const
+    {
+        return this->m_sync;
+    };
+
+    /**
+     * Makes sure that bytes can be allocated in the segment, growing it on
+     * the creator before the other side opens it (see
+     * Ns3AiMsgSegment::Reserve)
+     */
+    void Reserve(std::size_t bytes)
+    {
+        m_segment.Reserve(bytes, m_segment.IsCreator() && !this->m_sync->m_isOpened);
+    };
+
+    /**
+     * Records the page faults of this side, if the segment is pre-faulted
+     */
+    void RecordFaults()
+    {
+        m_segment.RecordFaults(this->m_sync->m_memory);
+    };
+
+    /**
+     * Delays the actions by the given number of steps, see
+     * Ns3AiMsgInterfaceImpl::EnableActionDelay. Only valid for the creator,
+     * before the other side opens the segment and after the vectors are
+     * resized.
+     */
+    void EnableActionDelay(uint32_t steps)
+    {
+        assert(m_segment.IsCreator() && this->m_depth == 1);
+        // the last buffers have the longest names
+        Reserve(steps * this->Size(m_cpp2pyName, m_py2cppName, steps));
+        for (uint32_t i = 1; i <= steps; ++i)
+        {
+            this->Construct(m_segment.Get(), m_cpp2pyName, m_py2cppName);
+        }
+        Ns3AiMsgSync* sync = this->m_sync;
+        sync->m_depth = this->m_depth;
+        sync->m_cpp2pyEmptyCount = this->m_depth;
+        // the first actions are ready for C++ side, Python side writes the last buffer
+        sync->m_py2cppFullCount = steps;
+        this->m_py2cppIndex = steps;
+        this->Select();
+    };
+
+    /**
+     * Gets the action delay in steps, 0 if actions are not delayed
+     */
+    uint32_t GetActionDelay() const
+    {
+        return this->m_depth - 1;
+    };
+
+    /**
+     * Resizes both vectors. If they do not fit in the segment, the creator
+     * grows it (see Reserve). Must be called before EnableActionDelay.
+     */
+    void ResizeVectors(uint32_t size)
+    {
+        static_assert(USE_VECTOR, "Only vectors are resized");
+        assert(this->m_depth == 1);
+        std::size_t bytes = 0;
+        if (size > this->m_cpp2py->capacity())
+        {
+            bytes += Ns3AiMsgLayout::AllocSize(size * sizeof(Cpp2PyMsgType));
+        }
+        if (size > this->m_py2cpp->capacity())
+        {
+            bytes += Ns3AiMsgLayout::AllocSize(size * sizeof(Py2CppMsgType));
+        }
+        Reserve(bytes);
+        // reserve first so that the vectors take no more than needed
+        this->m_cpp2py->reserve(size);
+        this->m_cpp2py->resize(size);
+        this->m_py2cpp->reserve(size);
+        this->m_py2cpp->resize(size);
+    };
+
+    /**
+     * Reserves every C++ to Python vector for count items, e.g. the longest
+     * message of a replayed log
+     */
+    void ReserveCpp2Py(std::size_t count)
+    {
+        static_assert(USE_VECTOR, "Only vectors are reserved");
+        std::size_t bytes = 0;
+        for (const typename Msgs::Cpp2PyMsgVector* vec : this->m_cpp2pys)
+        {
+            if (count > vec->capacity())
+            {
+                bytes += Ns3AiMsgLayout::AllocSize(count * sizeof(Cpp2PyMsgType));
+            }
+        }
+        Reserve(bytes);
+        for (typename Msgs::Cpp2PyMsgVector* vec : this->m_cpp2pys)
+        {
+            vec->reserve(count);
+        }
+    };
+
+    /**
+     * Switches the vectors to batches of varying length, see
+     * Ns3AiMsgInterfaceImpl::EnableBatch
+     */
+    void EnableBatch(uint32_t capacity)
+    {
+        static_assert(USE_VECTOR, "Only vectors carry batches");
+        assert(m_segment.IsCreator() && this->m_depth == 1);
+        ResizeVectors(capacity);
+        this->m_cpp2py->clear();
+        this->m_py2cpp->clear();
+        this->m_sync->m_batchCapacity = capacity;
+    };
+
+    /**
+     * Gets the capacity of the batches, 0 if they are not enabled
+     */
+    uint32_t GetBatchCapacity() const
+    {
+        return this->m_sync->m_batchCapacity;
+    };
+
+    /**
+     * Empties the C++ to Python batch, as CppSendBegin does
+     */
+    void StartCpp2PyBatch()
+    {
+        if constexpr (USE_VECTOR)
+        {
+            if (this->m_sync->m_batchCapacity)
+            {
+                this->m_cpp2py->clear();
+            }
+        }
+    };
+
+    /**
+     * Empties the Python to C++ batch, as PySendBegin does
+     */
+    void StartPy2CppBatch()
+    {
+        if constexpr (USE_VECTOR)
+        {
+            if (this->m_sync->m_batchCapacity)
+            {
+                this->m_py2cpp->clear();
+            }
+        }
+    };
+
+    // for C++ side:
+
+    void CppSendBegin()
+    {
+        Handshake::CppSendBegin();
+        StartCpp2PyBatch();
+    };
+
+    /**
+     * C++ side appends an item to the batch being sent
+     *
+     * \return the item, value-initialized
+     */
+    Cpp2PyMsgType* CppAppend()
+    {
+        static_assert(USE_VECTOR, "Only vectors carry batches");
+        assert(this->m_cpp2py->size() < this->m_sync->m_batchCapacity && "Batch is full");
+        this->m_cpp2py->emplace_back();
+        return &this->m_cpp2py->back();
+    };
+
+    /**
+     * C++ side sets the number of items in the batch being sent
+     */
+    void SetCpp2PyLength(uint32_t length)
+    {
+        static_assert(USE_VECTOR, "Only vectors carry batches");
+        assert(length <= this->m_sync->m_batchCapacity && "Batch is full");
+        this->m_cpp2py->resize(length);
+    };
+
+    void CppSendEnd()
+    {
+        this->NextCpp2Py();
+        Handshake::CppSendEnd();
+    };
+
+    void CppRecvEnd()
+    {
+        this->NextPy2Cpp();
+        Handshake::CppRecvEnd();
+    };
+
+    /**
+     * C++ side tells Python side that the simulation is over, at most once,
+     * after recording its page faults (see RecordFaults)
+     */
+    template <typename F = Finish>
+    typename std::enable_if<std::is_same<F, Ns3AiHandleFinish>::value>::type CppSetFinished()
+    {
+        if (!this->PyGetFinished())
+        {
+            // before the finish, after which Python side reports them
+            RecordFaults();
+        }
+        Handshake::CppSetFinished();
+    };
+
+    // for Python side:
+
+    void PyRecvEnd()
+    {
+        this->NextCpp2Py();
+        Handshake::PyRecvEnd();
+    };
+
+    void PySendBegin()
+    {
+        Handshake::PySendBegin();
+        StartPy2CppBatch();
+    };
+
+    bool PyTimedSendBegin(uint64_t timeout_ns)
+    {
+        if (!Handshake::PyTimedSendBegin(timeout_ns))
+        {
+            return false;
+        }
+        StartPy2CppBatch();
+        return true;
+    };
+
+    bool PyTrySendBegin()
+    {
+        if (!Handshake::PyTrySendBegin())
+        {
+            return false;
+        }
+        StartPy2CppBatch();
+        return true;
+    };
+
+    /**
+     * Python side appends an item to the batch being sent
+     */
+    Py2CppMsgType* PyAppend()
+    {
+        static_assert(USE_VECTOR, "Only vectors carry batches");
+        assert(this->m_py2cpp->size() < this->m_sync->m_batchCapacity && "Batch is full");
+        this->m_py2cpp->emplace_back();
+        return &this->m_py2cpp->back();
+    };
+
+    /**
+     * Python side sets the number of items in the batch being sent
+     */
+    void SetPy2CppLength(uint32_t length)
+    {
+        static_assert(USE_VECTOR, "Only vectors carry batches");
+        assert(length <= this->m_sync->m_batchCapacity && "Batch is full");
+        this->m_py2cpp->resize(length);
+    };
+
+    void PySendEnd()
+    {
+        this->NextPy2Cpp();
+        Handshake::PySendEnd();
+    };
+
+  private:
+    /**
+     * Finds the semaphores and every buffer, after the segment is opened or
+     * mapped again
+     */
+    void FindObjects()
+    {
+        boost::interprocess::managed_shared_memory& segment = m_segment.Get();
+        Ns3AiMsgSync* sync = Ns3AiMsgLayout::Find<Ns3AiMsgSync>(segment, m_lockableName.c_str());
+        NS_ABORT_MSG_IF(!sync, "Segment " << m_segment.GetName() << " has no semaphores");
+        this->Attach(sync);
+        this->ClearBuffers();
+        while (this->m_depth < sync->m_depth)
+        {
+            NS_ABORT_MSG_IF(!this->Find(segment, m_cpp2pyName, m_py2cppName),
+                            "The other side does not use "
+                                << (USE_VECTOR ? "vector" : "struct") << " mode");
+        }
+    };
+
+    /**
+     * Aborts if Python side enabled a feature of Ns3AiMsgInterfaceImpl,
+     * which this class would silently ignore. The names are those of the
+     * objects Ns3AiMsgInterfaceImpl creates for them.
+     */
+    void CheckFeatures()
+    {
+        boost::interprocess::managed_shared_memory& segment = m_segment.Get();
+        NS_ABORT_MSG_IF(this->m_sync->m_notifyPath[0],
+                        "Python side awaits notifications, which Ns3AiChannel does not send");
+        NS_ABORT_MSG_IF(Ns3AiMsgLayout::Exists(segment, m_cpp2pyName + " Post"),
+                        "Python side drains posted messages, which Ns3AiChannel does not post");
+        NS_ABORT_MSG_IF(Ns3AiMsgLayout::Exists(segment, m_cpp2pyName + " Broadcast"),
+                        "Python side has subscribers, which Ns3AiChannel does not broadcast to");
+        NS_ABORT_MSG_IF(Ns3AiMsgLayout::Exists(segment, m_cpp2pyName + " Latest"),
+                        "Python side runs free, which Ns3AiChannel does not support");
+        NS_ABORT_MSG_IF(Ns3AiMsgLayout::Exists(segment, m_lockableName + " Stats"),
+                        "Python side reads statistics, which Ns3AiChannel does not record");
+    };
+
+    Ns3AiMsgSegment m_segment;
+    const std::string m_cpp2pyName;
+    const std::string m_py2cppName;
+    const std::string m_lockableName;
+    const bool m_withFeatures;
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_CHANNEL_H
@@ -20,14 +20,31 @@
 #ifndef NS3_AI_MSG_INTERFACE_H
 #define NS3_AI_MSG_INTERFACE_H
 
+#include "ns3-ai-msg-broadcast.h"
+#include "ns3-ai-msg-channel.h"
+#include "ns3-ai-msg-latest.h"
+#include "ns3-ai-msg-layout.h"
+#include "ns3-ai-msg-log.h"
+#include "ns3-ai-msg-notify.h"
+#include "ns3-ai-msg-ring.h"
+#include "ns3-ai-msg-segment.h"
+#include "ns3-ai-msg-stats.h"
 #include "ns3-ai-semaphore.h"
 
+#include <ns3/abort.h>
 #include <ns3/singleton.h>
+#include <ns3/traced-callback.h>
 
+#include <algorithm>
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <string>
+#include <typeindex>
 #include <vector>
 #include <boost/interprocess/allocators/allocator.hpp>
 #include <boost/interprocess/containers/vector.hpp>
@@ -37,107 +54,103 @@ namespace ns3
 {
 
 /**
- * \brief Structure containing semaphores used in msg interface
- */
-struct Ns3AiMsgSync
-{
-    volatile uint8_t m_cpp2pyEmptyCount{1};
-    volatile uint8_t m_cpp2pyFullCount{0};
-    volatile uint8_t m_py2cppEmptyCount{1};
-    volatile uint8_t m_py2cppFullCount{0};
-    bool m_isFinished{false};
-};
-
-/**
- * \brief A template class implementation of the message interface
+ * \brief A template class implementation of the message interface, with
+ * its mode chosen at run time
+ *
+ * The lockstep messages go through an Ns3AiChannel of the chosen mode,
+ * which owns the segment and also does delayed actions and batches. The
+ * optional features are components next to it, each with its own objects
+ * in the segment: statistics (Ns3AiMsgStatsRecorder), posted messages
+ * (Ns3AiMsgPost), the broadcast (Ns3AiMsgBroadcaster), free-running mode
+ * (Ns3AiMsgFreeRun), notifications (Ns3AiMsgNotify) and the log
+ * (Ns3AiMsgLogWriter and Ns3AiMsgLogReader). This class only chooses the
+ * channel and calls the components around the lockstep path.
  */
 template <typename Cpp2PyMsgType, typename Py2CppMsgType>
 class Ns3AiMsgInterfaceImpl
 {
+    typedef Ns3AiChannel<Cpp2PyMsgType, Py2CppMsgType, Ns3AiStructMode, Ns3AiHandleFinish>
+        StructChannel;
+    typedef Ns3AiChannel<Cpp2PyMsgType, Py2CppMsgType, Ns3AiVectorMode, Ns3AiHandleFinish>
+        VectorChannel;
+
   public:
     Ns3AiMsgInterfaceImpl() = delete;
 
     explicit Ns3AiMsgInterfaceImpl(bool is_memory_creator,
                                    bool use_vector,
                                    bool handle_finish,
-                                   uint32_t size = 4096,
+                                   uint32_t size = 0,
                                    const char* segment_name = "My Seg",
                                    const char* cpp2py_msg_name = "My Cpp to Python Msg",
                                    const char* py2cpp_msg_name = "My Python to Cpp Msg",
-                                   const char* lockable_name = "My Lockable")
-        : m_isCreator(is_memory_creator),
-          m_useVector(use_vector),
+                                   const char* lockable_name = "My Lockable",
+                                   uint32_t spin_budget = Ns3AiSemaphore::DEFAULT_SPIN_BUDGET)
+        : m_useVector(use_vector),
           m_handleFinish(handle_finish),
-          m_segName(segment_name),
-          m_isFinished(false)
+          m_isFinished(false),
+          m_stats(std::string(lockable_name) + " Stats"),
+          m_post(std::string(cpp2py_msg_name) + " Post"),
+          m_broadcast(std::string(cpp2py_msg_name) + " Broadcast"),
+          m_freeRun(std::string(cpp2py_msg_name) + " Latest",
+                    std::string(py2cpp_msg_name) + " Latest")
     {
-        using namespace boost::interprocess;
-        if (m_isCreator)
+        if (m_useVector)
         {
-            shared_memory_object::remove(m_segName.c_str());
-            static managed_shared_memory segment(create_only, m_segName.c_str(), size);
-            if (m_useVector)
-            {
-                static const Cpp2PyMsgAllocator alloc_env(segment.get_segment_manager());
-                static const Cpp2PyMsgAllocator alloc_act(segment.get_segment_manager());
-                m_cpp2pyVector = segment.construct<Cpp2PyMsgVector>(cpp2py_msg_name)(alloc_env);
-                m_py2cppVector = segment.construct<Py2CppMsgVector>(py2cpp_msg_name)(alloc_act);
-                m_cpp2pyStruct = nullptr;
-                m_py2CppStruct = nullptr;
-            }
-            else
-            {
-                m_cpp2pyVector = nullptr;
-                m_py2cppVector = nullptr;
-                m_cpp2pyStruct = segment.construct<Cpp2PyMsgType>(cpp2py_msg_name)();
-                m_py2CppStruct = segment.construct<Py2CppMsgType>(py2cpp_msg_name)();
-            }
-            m_sync = segment.construct<Ns3AiMsgSync>(lockable_name)();
+            m_vectorChannel = std::make_unique<VectorChannel>(is_memory_creator,
+                                                              size,
+                                                              segment_name,
+                                                              cpp2py_msg_name,
+                                                              py2cpp_msg_name,
+                                                              lockable_name,
+                                                              spin_budget,
+                                                              true);
         }
         else
         {
-            static managed_shared_memory segment(open_only, segment_name);
-            if (m_useVector)
-            {
-                m_cpp2pyVector = segment.find<Cpp2PyMsgVector>(cpp2py_msg_name).first;
-                m_py2cppVector = segment.find<Py2CppMsgVector>(py2cpp_msg_name).first;
-                m_cpp2pyStruct = nullptr;
-                m_py2CppStruct = nullptr;
-            }
-            else
-            {
-                m_cpp2pyVector = nullptr;
-                m_py2cppVector = nullptr;
-                m_cpp2pyStruct = segment.find<Cpp2PyMsgType>(cpp2py_msg_name).first;
-                m_py2CppStruct = segment.find<Py2CppMsgType>(py2cpp_msg_name).first;
-            }
-            m_sync = segment.find<Ns3AiMsgSync>(lockable_name).first;
+            m_structChannel = std::make_unique<StructChannel>(is_memory_creator,
+                                                              size,
+                                                              segment_name,
+                                                              cpp2py_msg_name,
+                                                              py2cpp_msg_name,
+                                                              lockable_name,
+                                                              spin_budget,
+                                                              true);
+        }
+        m_segment = Dispatch([](auto& channel) { return &channel.GetSegment(); });
+        m_post.SetSpinBudget(spin_budget);
+        // after the callback of the channel, which finds the semaphores
+        m_segment->AddRemapCallback([this] { OpenFeatures(); });
+        if (!m_segment->IsCreator())
+        {
+            OpenFeatures();
+            m_notify.Open(GetSync());
         }
     };
 
     ~Ns3AiMsgInterfaceImpl()
     {
-        if (m_isCreator)
-        {
-            boost::interprocess::shared_memory_object::remove(m_segName.c_str());
-        }
-        else
+        if (!m_segment->IsCreator())
         {
             if (m_handleFinish)
             {
+                // records the page faults first
                 CppSetFinished();
             }
+            else
+            {
+                Dispatch([](auto& channel) { channel.RecordFaults(); });
+            }
         }
     };
 
-    typedef boost::interprocess::
-        allocator<Cpp2PyMsgType, boost::interprocess::managed_shared_memory::segment_manager>
-            Cpp2PyMsgAllocator;
-    typedef boost::interprocess::vector<Cpp2PyMsgType, Cpp2PyMsgAllocator> Cpp2PyMsgVector;
-    typedef boost::interprocess::
-        allocator<Py2CppMsgType, boost::interprocess::managed_shared_memory::segment_manager>
-            Py2CppMsgAllocator;
-    typedef boost::interprocess::vector<Py2CppMsgType, Py2CppMsgAllocator> Py2CppMsgVector;
+    Ns3AiMsgInterfaceImpl(const Ns3AiMsgInterfaceImpl&) = delete;
+    Ns3AiMsgInterfaceImpl& operator=(const Ns3AiMsgInterfaceImpl&) = delete;
+
+    typedef typename VectorChannel::Cpp2PyMsgAllocator Cpp2PyMsgAllocator;
+    typedef typename VectorChannel::Cpp2PyMsgVector Cpp2PyMsgVector;
+    typedef typename VectorChannel::Py2CppMsgAllocator Py2CppMsgAllocator;
+    typedef typename VectorChannel::Py2CppMsgVector Py2CppMsgVector;
 
     // use structure for the simple case:
 
@@ -148,7 +161,7 @@ class Ns3AiMsgInterfaceImpl
     Cpp2PyMsgType* GetCpp2PyStruct()
     {
         assert(!m_useVector);
-        return m_cpp2pyStruct;
+        return m_structChannel->GetCpp2PyStruct();
     };
 
     /**
@@ -158,7 +171,7 @@ class Ns3AiMsgInterfaceImpl
     Py2CppMsgType* GetPy2CppStruct()
     {
         assert(!m_useVector);
-        return m_py2CppStruct;
+        return m_structChannel->GetPy2CppStruct();
     };
 
     // use vector for passing multiple structures at once:
@@ -170,7 +183,7 @@ class Ns3AiMsgInterfaceImpl
     Cpp2PyMsgVector* GetCpp2PyVector()
     {
         assert(m_useVector);
-        return m_cpp2pyVector;
+        return m_vectorChannel->GetCpp2PyVector();
     };
 
     /**
@@ -180,7 +193,44 @@ class Ns3AiMsgInterfaceImpl
     Py2CppMsgVector* GetPy2CppVector()
     {
         assert(m_useVector);
-        return m_py2cppVector;
+        return m_vectorChannel->GetPy2CppVector();
+    };
+
+    /**
+     * Resizes both vectors in vector-based message interface. If they do
+     * not fit in the segment, the creator grows it and maps it again, which
+     * is only possible before the other side opens the segment and
+     * invalidates the pointers (and Python views) got before. Must be
+     * called before EnableActionDelay.
+     */
+    void ResizeVectors(uint32_t size)
+    {
+        assert(m_useVector);
+        m_vectorChannel->ResizeVectors(size);
+    };
+
+    /**
+     * Python side switches the vector-based message interface to batches of
+     * varying length. Both vectors get a fixed capacity, and a message only
+     * carries the items appended since its Begin: CppSendBegin and
+     * PySendBegin start an empty batch, the sender appends items (or sets
+     * the length), and the size of the vector tells the receiver how many
+     * items are live. Nothing is allocated in the segment afterwards, and a
+     * message costs in proportion to its length. Only valid for the shared
+     * memory creator, instead of ResizeVectors and before EnableActionDelay.
+     */
+    void EnableBatch(uint32_t capacity)
+    {
+        assert(m_useVector);
+        m_vectorChannel->EnableBatch(capacity);
+    };
+
+    /**
+     * Gets the capacity of the batches, 0 if they are not enabled
+     */
+    uint32_t GetBatchCapacity() const
+    {
+        return GetSync()->m_batchCapacity;
     };
 
     // for C++ side:
@@ -191,7 +241,29 @@ class Ns3AiMsgInterfaceImpl
      */
     void CppSendBegin()
     {
-        Ns3AiSemaphore::sem_wait(&m_sync->m_cpp2pyEmptyCount);
+        uint64_t start = m_stats.Start();
+        Dispatch([](auto& channel) { channel.CppSendBegin(); });
+        m_stats.Acquired(Ns3AiMsgStats::SEND_WAIT, start);
+    };
+
+    /**
+     * C++ side appends an item to the batch being sent, between
+     * CppSendBegin and CppSendEnd (see EnableBatch)
+     *
+     * \return the item, value-initialized
+     */
+    Cpp2PyMsgType* CppAppend()
+    {
+        return m_vectorChannel->CppAppend();
+    };
+
+    /**
+     * C++ side sets the number of items in the batch being sent, at most
+     * the batch capacity. New items are value-initialized.
+     */
+    void SetCpp2PyLength(uint32_t length)
+    {
+        m_vectorChannel->SetCpp2PyLength(length);
     };
 
     /**
@@ -200,7 +272,22 @@ class Ns3AiMsgInterfaceImpl
      */
     void CppSendEnd()
     {
-        Ns3AiSemaphore::sem_post(&m_sync->m_cpp2pyFullCount);
+        Dispatch([this](auto& channel) {
+            const Cpp2PyMsgType* sent = channel.GetCpp2PyData();
+            uint32_t length = channel.GetCpp2PyLength();
+            m_stats.Released(Ns3AiMsgStats::SEND_FILL,
+                             Ns3AiMsgStats::SEND_COUNT,
+                             Ns3AiMsgStats::SEND_BYTES,
+                             length * sizeof(Cpp2PyMsgType));
+            channel.CppSendEnd();
+            Ns3AiMsgPost<Cpp2PyMsgType>::Wake(channel.GetSync());
+            m_notify.NotifyRecv(channel.GetSync());
+            // copied after waking Python side up, which only reads the message
+            if (m_broadcast.IsAttached() && !m_isFinished)
+            {
+                m_broadcast.Publish(sent, length);
+            }
+        });
     };
 
     /**
@@ -209,7 +296,9 @@ class Ns3AiMsgInterfaceImpl
      */
     void CppRecvBegin()
     {
-        Ns3AiSemaphore::sem_wait(&m_sync->m_py2cppFullCount);
+        uint64_t start = m_stats.Start();
+        Dispatch([](auto& channel) { channel.CppRecvBegin(); });
+        m_stats.Acquired(Ns3AiMsgStats::RECV_WAIT, start);
     };
 
     /**
@@ -218,7 +307,102 @@ class Ns3AiMsgInterfaceImpl
      */
     void CppRecvEnd()
     {
-        Ns3AiSemaphore::sem_post(&m_sync->m_py2cppEmptyCount);
+        Dispatch([this](auto& channel) {
+            m_stats.Released(Ns3AiMsgStats::RECV_READ,
+                             Ns3AiMsgStats::RECV_COUNT,
+                             Ns3AiMsgStats::RECV_BYTES,
+                             channel.GetPy2CppLength() * sizeof(Py2CppMsgType));
+            channel.CppRecvEnd();
+            m_notify.NotifySend(channel.GetSync());
+        });
+    };
+
+    /**
+     * C++ side starts writing a posted (one-way) message and gets the
+     * slot to write into. Posted messages do not need a reply from
+     * Python, and C++ side only waits when Python has not drained the
+     * whole capacity. Python side must enable them with EnablePost.
+     * If Python side drains them when handling a lockstep message, it
+     * waits for that message with PyRecvOrDrainBegin, which also returns
+     * when C++ side waits for room.
+     */
+    Cpp2PyMsgType* CppPostBegin()
+    {
+        return m_post.ProduceBegin(m_segment->Get(), GetSync());
+    };
+
+    /**
+     * C++ side publishes the posted message
+     */
+    void CppPostEnd()
+    {
+        m_post.ProduceEnd(m_stats);
+    };
+
+    /**
+     * C++ side posts a copy of msg (fire-and-forget)
+     */
+    void CppPost(const Cpp2PyMsgType& msg)
+    {
+        *CppPostBegin() = msg;
+        CppPostEnd();
+    };
+
+    /**
+     * C++ side publishes an observation in free-running mode (see
+     * EnableFreeRun) and returns at once
+     *
+     * \param msg the observation
+     * \param time when the observation is made, e.g. the simulation time in
+     *        nanoseconds. The action computed for it carries it back.
+     */
+    void CppPublish(const Cpp2PyMsgType& msg, uint64_t time)
+    {
+        CppPublish(&msg, 1, time);
+    };
+
+    /**
+     * CppPublish for the vector-based interface: the observation is length
+     * items, at most the observation length given to EnableFreeRun
+     */
+    void CppPublish(const Cpp2PyMsgType* msgs, uint32_t length, uint64_t time)
+    {
+        m_freeRun.Attach(m_segment->Get());
+        m_freeRun.Publish(msgs, length, time, m_stats);
+    };
+
+    /**
+     * C++ side copies the latest action written by Python side in
+     * free-running mode, which may answer an older observation than the
+     * latest published one. With statistics enabled, how many observations
+     * and how much time the action lags behind is recorded.
+     *
+     * \param msg the action
+     * \param time if not null, set to the time of the observation the
+     *        action answers
+     * \return false if Python side has not written any action yet
+     */
+    bool CppGetAction(Py2CppMsgType& msg, uint64_t* time = nullptr)
+    {
+        m_freeRun.Attach(m_segment->Get());
+        assert(m_freeRun.GetActionMaxLength() == 1 &&
+               "Actions are vectors, see the other overload");
+        uint32_t length;
+        return m_freeRun.ReadAction(&msg, length, time, m_stats);
+    };
+
+    /**
+     * CppGetAction for the vector-based interface: msgs is resized to the
+     * items of the action
+     */
+    bool CppGetAction(std::vector<Py2CppMsgType>& msgs, uint64_t* time = nullptr)
+    {
+        m_freeRun.Attach(m_segment->Get());
+        uint32_t length = 0;
+        msgs.resize(m_freeRun.GetActionMaxLength());
+        bool read = m_freeRun.ReadAction(msgs.data(), length, time, m_stats);
+        msgs.resize(length);
+        return read;
     };
 
     /**
@@ -228,10 +412,22 @@ class Ns3AiMsgInterfaceImpl
     void CppSetFinished()
     {
         assert(m_handleFinish);
+        if (m_isFinished)
+        {
+            return;
+        }
         m_isFinished = true;
-        CppSendBegin();
-        m_sync->m_isFinished = true;
-        CppSendEnd();
+        // let Python side waiting only for posted messages or observations
+        // know as well; done first because Python side stops draining after
+        // the lockstep finish
+        m_post.SetFinished(m_segment->Get());
+        m_freeRun.SetFinished(m_segment->Get());
+        m_broadcast.SetFinished();
+        Dispatch([this](auto& channel) {
+            channel.CppSetFinished();
+            Ns3AiMsgPost<Cpp2PyMsgType>::Wake(channel.GetSync());
+            m_notify.NotifyRecv(channel.GetSync());
+        });
     };
 
     // for Python side:
@@ -242,11 +438,74 @@ class Ns3AiMsgInterfaceImpl
      */
     void PyRecvBegin()
     {
-        Ns3AiSemaphore::sem_wait(&m_sync->m_cpp2pyFullCount);
-        if (m_handleFinish)
+        if (!m_replay)
         {
-            m_isFinished = m_sync->m_isFinished;
+            Dispatch([](auto& channel) { channel.PyRecvBegin(); });
         }
+        Received();
+    };
+
+    /**
+     * PyRecvBegin giving up after timeoutMs milliseconds, so that Python
+     * side can handle signals or other work while C++ side is busy
+     *
+     * \return whether reading has started
+     */
+    bool PyTimedRecvBegin(uint32_t timeoutMs)
+    {
+        if (!m_replay && !Dispatch([timeoutMs](auto& channel) {
+                return channel.PyTimedRecvBegin(timeoutMs * UINT64_C(1000000));
+            }))
+        {
+            return false;
+        }
+        Received();
+        return true;
+    };
+
+    /**
+     * Python side starts reading if a message is ready, without waiting.
+     * Otherwise, C++ side notifies the descriptor of EnableNotify when it
+     * sends the message, after which this function should be called again.
+     *
+     * \return whether reading has started, as with PyRecvBegin
+     */
+    bool PyTryRecvBegin()
+    {
+        if (!m_replay && !Dispatch([this](auto& channel) {
+                return m_notify.TryRecvBegin([&channel] { return channel.PyTryRecvBegin(); },
+                                             channel.GetSync());
+            }))
+        {
+            return false;
+        }
+        Received();
+        return true;
+    };
+
+    /**
+     * Python side waits until it can start reading, like PyRecvBegin, or
+     * until posted messages are readable (see EnablePost), whichever comes
+     * first. C++ side wakes it up when it sends a message or when it finds
+     * the posted ring full, so that Python side drains the ring instead of
+     * both sides waiting for each other.
+     *
+     * \return whether reading has started; if not, posted messages are
+     *         readable with PyDrainBegin
+     */
+    bool PyRecvOrDrainBegin()
+    {
+        NS_ABORT_MSG_IF(!m_post.IsAttached(), "Posted messages are not enabled, see EnablePost");
+        if (!m_replay && !Dispatch([this](auto& channel) {
+                return m_post.RecvOrDrainBegin([&channel] { return channel.PyTryRecvBegin(); },
+                                               channel.GetSync(),
+                                               channel.GetSpinBudget());
+            }))
+        {
+            return false;
+        }
+        Received();
+        return true;
     };
 
     /**
@@ -255,7 +514,10 @@ class Ns3AiMsgInterfaceImpl
      */
     void PyRecvEnd()
     {
-        Ns3AiSemaphore::sem_post(&m_sync->m_cpp2pyEmptyCount);
+        if (!m_replay)
+        {
+            Dispatch([](auto& channel) { channel.PyRecvEnd(); });
+        }
     };
 
     /**
@@ -264,7 +526,68 @@ class Ns3AiMsgInterfaceImpl
      */
     void PySendBegin()
     {
-        Ns3AiSemaphore::sem_wait(&m_sync->m_py2cppEmptyCount);
+        if (m_replay)
+        {
+            Dispatch([](auto& channel) { channel.StartPy2CppBatch(); });
+        }
+        else
+        {
+            Dispatch([](auto& channel) { channel.PySendBegin(); });
+        }
+    };
+
+    /**
+     * PySendBegin giving up after timeoutMs milliseconds
+     *
+     * \return whether writing has started
+     */
+    bool PyTimedSendBegin(uint32_t timeoutMs)
+    {
+        if (m_replay)
+        {
+            PySendBegin();
+            return true;
+        }
+        return Dispatch([timeoutMs](auto& channel) {
+            return channel.PyTimedSendBegin(timeoutMs * UINT64_C(1000000));
+        });
+    };
+
+    /**
+     * Python side starts writing if C++ side has read the previous message,
+     * without waiting, like PyTryRecvBegin
+     *
+     * \return whether writing has started, as with PySendBegin
+     */
+    bool PyTrySendBegin()
+    {
+        if (m_replay)
+        {
+            PySendBegin();
+            return true;
+        }
+        return Dispatch([this](auto& channel) {
+            return m_notify.TrySendBegin([&channel] { return channel.PyTrySendBegin(); },
+                                         channel.GetSync());
+        });
+    };
+
+    /**
+     * Python side appends an item to the batch being sent, between
+     * PySendBegin and PySendEnd (see EnableBatch)
+     */
+    Py2CppMsgType* PyAppend()
+    {
+        return m_vectorChannel->PyAppend();
+    };
+
+    /**
+     * Python side sets the number of items in the batch being sent, e.g.
+     * before writing them through a NumPy view
+     */
+    void SetPy2CppLength(uint32_t length)
+    {
+        m_vectorChannel->SetPy2CppLength(length);
     };
 
     /**
@@ -273,7 +596,18 @@ class Ns3AiMsgInterfaceImpl
      */
     void PySendEnd()
     {
-        Ns3AiSemaphore::sem_post(&m_sync->m_py2cppFullCount);
+        if (m_recorder)
+        {
+            Dispatch([this](auto& channel) {
+                Record(Ns3AiMsgLogRecord::PY2CPP,
+                       channel.GetPy2CppData(),
+                       channel.GetPy2CppLength());
+            });
+        }
+        if (!m_replay)
+        {
+            Dispatch([](auto& channel) { channel.PySendEnd(); });
+        }
     };
 
     /**
@@ -285,22 +619,541 @@ class Ns3AiMsgInterfaceImpl
         return m_isFinished;
     };
 
+    /**
+     * Python side waits at most timeoutMs milliseconds for an observation
+     * newer than the last one it read in free-running mode, and copies it
+     * (see GetObservation). Observations published in between are skipped.
+     *
+     * \return whether a new observation is read, false on timeout or when
+     *         the simulation is over (see PyGetFinished)
+     */
+    bool PyWaitObservation(uint32_t timeoutMs)
+    {
+        bool read = m_freeRun.WaitObservation(timeoutMs * UINT64_C(1000000));
+        if (m_freeRun.IsFinished())
+        {
+            m_isFinished = true;
+        }
+        return read;
+    };
+
+    /**
+     * Gets the copy of the observation read by PyWaitObservation, its
+     * first item for the vector-based interface
+     */
+    Cpp2PyMsgType* GetObservation()
+    {
+        return m_freeRun.GetObservation();
+    };
+
+    /**
+     * Gets the number of items of the observation read by
+     * PyWaitObservation, 1 for the struct-based interface
+     */
+    uint32_t GetObservationLength() const
+    {
+        return m_freeRun.GetObservationLength();
+    };
+
+    /**
+     * Gets the time of the observation read by PyWaitObservation
+     */
+    uint64_t GetObservationTime() const
+    {
+        return m_freeRun.GetObservationTime();
+    };
+
+    /**
+     * Gets the action to fill before PyPublishAction, its first item for
+     * the vector-based interface
+     */
+    Py2CppMsgType* GetAction()
+    {
+        return m_freeRun.GetAction();
+    };
+
+    /**
+     * Python side sets the number of items of the action published, at
+     * most the action length given to EnableFreeRun (the default)
+     */
+    void SetActionLength(uint32_t length)
+    {
+        m_freeRun.SetActionLength(length);
+    };
+
+    /**
+     * Gets the number of items of the action published
+     */
+    uint32_t GetActionLength() const
+    {
+        return m_freeRun.GetActionLength();
+    };
+
+    /**
+     * Python side publishes the action (GetAction) computed for the
+     * observation read last, overwriting the previous one
+     */
+    void PyPublishAction()
+    {
+        m_freeRun.PublishAction();
+    };
+
+    /**
+     * Python side creates the ring of posted messages, which must happen
+     * before C++ side posts. Only valid for the shared memory creator.
+     *
+     * \param capacity the number of slots, a power of two
+     */
+    void EnablePost(uint32_t capacity)
+    {
+        assert(m_segment->IsCreator());
+        Reserve(m_post.Size(capacity));
+        m_post.Create(m_segment->Get(), capacity);
+    };
+
+    /**
+     * Python side makes C++ side copy every message it sends into a
+     * broadcast ring, read by any number of Ns3AiMsgSubscriber in other
+     * processes (e.g., a dashboard or a dataset writer) while this side
+     * answers C++ side as usual. C++ side never waits for the subscribers:
+     * one that falls more than capacity messages behind loses the oldest
+     * ones. Only valid for the shared memory creator, before C++ side opens
+     * the segment.
+     *
+     * \param capacity the number of slots, a power of two
+     * \param length the number of vector items a slot holds, for the
+     *        vector-based interface. C++ side aborts when it sends a longer
+     *        vector.
+     */
+    void EnableBroadcast(uint32_t capacity, uint32_t length = 1)
+    {
+        assert(m_segment->IsCreator() && (m_useVector || length == 1));
+        Reserve(m_broadcast.Size(capacity, length));
+        m_broadcast.Create(m_segment->Get(), capacity, length);
+    };
+
+    /**
+     * Python side gets the posted messages that can be read with
+     * GetPostedStruct
+     *
+     * \param wait whether to wait until at least one message is posted
+     * \return the number of readable posted messages. With wait, 0 means
+     *         the simulation is over.
+     */
+    uint32_t PyDrainBegin(bool wait = false)
+    {
+        return m_post.DrainBegin(wait);
+    };
+
+    /**
+     * Gets the i-th readable posted message, counting from the oldest one
+     */
+    Cpp2PyMsgType* GetPostedStruct(uint32_t i)
+    {
+        return m_post.Peek(i);
+    };
+
+    /**
+     * Python side releases the count oldest posted messages
+     */
+    void PyDrainEnd(uint32_t count)
+    {
+        m_post.DrainEnd(count);
+    };
+
+    /**
+     * Python side delays the actions by the given number of steps, so that
+     * it computes the action of one step while C++ side simulates the next
+     * one. Each message gets steps + 1 buffers used in turn: C++ side sends
+     * up to steps + 1 messages before it reads an action, and the action it
+     * reads after sending message t is the one Python side wrote for
+     * message t - steps. The first steps actions are copies of the initial
+     * Python to C++ message. Only valid for the shared memory creator,
+     * before C++ side opens the segment and after the vectors are resized.
+     *
+     * Suited to time-step environments, whose next observation does not
+     * depend on how fast the current one is answered.
+     */
+    void EnableActionDelay(uint32_t steps)
+    {
+        Dispatch([steps](auto& channel) { channel.EnableActionDelay(steps); });
+    };
+
+    /**
+     * Gets the action delay in steps, 0 if actions are not delayed
+     */
+    uint32_t GetActionDelay() const
+    {
+        return Dispatch([](const auto& channel) { return channel.GetActionDelay(); });
+    };
+
+    /**
+     * Python side lets an event loop (e.g., asyncio) wait for C++ side
+     * instead of blocking in PyRecvBegin or PySendBegin. C++ side writes to
+     * a FIFO whenever it posts while Python side is waiting in
+     * PyTryRecvBegin or PyTrySendBegin, and GetNotifyFd returns its
+     * non-blocking read end (see Ns3AiMsgNotify). Only valid for the shared
+     * memory creator, before C++ side opens the segment.
+     */
+    void EnableNotify()
+    {
+        assert(m_segment->IsCreator() && !GetSync()->m_isOpened);
+        m_notify.Create(GetSync());
+    };
+
+    /**
+     * Gets the descriptor that becomes readable when C++ side posts, see
+     * EnableNotify. The waiting side drains it (reading until EAGAIN) before
+     * trying again.
+     *
+     * \return -1 if notifications are not enabled
+     */
+    int GetNotifyFd() const
+    {
+        return m_notify.GetFd();
+    };
+
+    /**
+     * Python side appends every message it reads and writes, with the time
+     * it does so, to a memory-mapped log file (see Ns3AiMsgLogWriter), e.g.
+     * to train or test an agent offline with EnableReplay. The file is
+     * complete when the interface is destroyed.
+     *
+     * \param path the log file, created or truncated
+     */
+    void EnableRecord(const std::string& path)
+    {
+        m_recorder = std::make_unique<Ns3AiMsgLogWriter>(path,
+                                                          m_useVector,
+                                                          sizeof(Cpp2PyMsgType),
+                                                          sizeof(Py2CppMsgType));
+    };
+
+    /**
+     * Python side reads the C++ to Python messages from a log written by
+     * EnableRecord instead of from C++ side, which must not run. Receiving
+     * copies the next logged message into the usual buffer, sending does
+     * nothing (unless recording), and the simulation is finished at the
+     * end of the log, so an agent runs unchanged at memory speed. Only
+     * valid for the shared memory creator handling finish, and for logs of
+     * the same message types. The C++ to Python vectors are reserved here
+     * for the longest logged message, which may grow the segment: get the
+     * vectors (and their Python views) afterwards.
+     *
+     * \param path the log file
+     */
+    void EnableReplay(const std::string& path)
+    {
+        assert(m_segment->IsCreator() && m_handleFinish && !GetSync()->m_isOpened);
+        m_replay = std::make_unique<Ns3AiMsgLogReader>(path,
+                                                        m_useVector,
+                                                        sizeof(Cpp2PyMsgType),
+                                                        sizeof(Py2CppMsgType));
+        m_isFinished = false;
+        if (m_useVector)
+        {
+            // replaying must not grow the segment under the views of Python side
+            m_vectorChannel->ReserveCpp2Py(m_replay->GetMaxLength(Ns3AiMsgLogRecord::CPP2PY) /
+                                           sizeof(Cpp2PyMsgType));
+        }
+    };
+
+    /**
+     * Python side enables free-running mode. C++ side publishes observations
+     * into a latest-value slot and goes on at once with the latest action
+     * Python side wrote, so neither side waits for the other: simulated time
+     * does not stop while the agent is slow, at the cost of stale actions.
+     * Suited to decisions that tolerate latency, such as a contention window
+     * or a CCA threshold. Lockstep messages can still be used alongside.
+     * Only valid for the shared memory creator.
+     *
+     * \param observationLength the number of vector items an observation
+     *        holds at most, for the vector-based interface
+     * \param actionLength the same for an action
+     */
+    void EnableFreeRun(uint32_t observationLength = 1, uint32_t actionLength = 1)
+    {
+        assert(m_segment->IsCreator() &&
+               (m_useVector || (observationLength == 1 && actionLength == 1)));
+        Reserve(m_freeRun.Size(observationLength, actionLength));
+        m_freeRun.Create(m_segment->Get(), observationLength, actionLength);
+    };
+
+    // for both sides:
+
+    /**
+     * Sets the number of busy-wait iterations spent in the Begin functions
+     * before backing off and parking on a futex. A larger budget lowers
+     * latency when the other side answers quickly; a smaller one frees the
+     * core sooner when the other side is busy for a long time.
+     */
+    void SetSpinBudget(uint32_t spinBudget)
+    {
+        Dispatch([spinBudget](auto& channel) { channel.SetSpinBudget(spinBudget); });
+        m_post.SetSpinBudget(spinBudget);
+    };
+
+    /**
+     * Gets the spin budget of this side
+     */
+    uint32_t GetSpinBudget() const
+    {
+        return Dispatch([](const auto& channel) { return channel.GetSpinBudget(); });
+    };
+
+    /**
+     * Starts recording message counters and latency histograms in the
+     * segment, which needs sizeof(Ns3AiMsgStats) (about 16 KB) of free space
+     * on C++ side, or grows the segment (see ResizeVectors) on the creator.
+     * Either side can enable them; C++ side records them only if they are
+     * enabled before it opens the segment, or on C++ side itself.
+     */
+    void EnableStats()
+    {
+        if (!GetStats())
+        {
+            Reserve(m_stats.Size());
+            m_stats.Enable(m_segment->Get());
+        }
+    };
+
+    /**
+     * Gets the statistics of the channel
+     *
+     * \return nullptr if they are not enabled
+     */
+    Ns3AiMsgStats* GetStats()
+    {
+        if (!m_stats.Get())
+        {
+            // enabled by C++ side after this side opened the segment
+            m_stats.Open(m_segment->Get());
+        }
+        return m_stats.Get();
+    };
+
+    /**
+     * Gets the trace source of the statistics, which C++ side fires with the
+     * histogram (see Ns3AiMsgStats::Histogram) and the value of every sample
+     * it records, e.g. to feed ns-3 statistics or a trace file. It only fires
+     * while the statistics are enabled (see EnableStats).
+     */
+    TracedCallback<uint32_t, uint64_t>& GetStatsTrace()
+    {
+        return m_stats.GetTrace();
+    };
+
+    /**
+     * Python side pre-faults the segment, in this process now and in C++
+     * side when it opens the segment, so that neither side takes a page
+     * fault on the message path. With hugePages, the segment is rounded up
+     * to whole huge pages and advised to be backed by transparent huge
+     * pages, which needs "advise" or "always" in
+     * /sys/kernel/mm/transparent_hugepage/shmem_enabled. With lock, the
+     * pages are locked in memory, within RLIMIT_MEMLOCK. Only valid for
+     * the shared memory creator, before C++ side opens the segment; the
+     * segment is prepared again if it grows afterwards.
+     */
+    void EnablePrefault(bool hugePages, bool lock)
+    {
+        Ns3AiMsgSync* sync = GetSync();
+        assert(m_segment->IsCreator() && !sync->m_isOpened);
+        sync->m_memory.m_flags = Ns3AiMsgMemory::PREFAULT |
+                                 (hugePages ? uint32_t(Ns3AiMsgMemory::HUGE_PAGES) : 0u) |
+                                 (lock ? uint32_t(Ns3AiMsgMemory::LOCK) : 0u);
+        if (hugePages)
+        {
+            // grows to a multiple of the huge page size, and the channel
+            // prepares the new mapping
+            m_segment->SetGrowAlignment(Ns3AiMsgMemory::HUGE_PAGE_SIZE);
+            m_segment->Grow(0);
+        }
+        else
+        {
+            m_segment->Prepare(sync->m_memory);
+        }
+    };
+
+    /**
+     * Gets the Ns3AiMsgMemory::Flags that took effect on one side, 0 if
+     * pre-faulting is not enabled or C++ side has not opened the segment
+     */
+    uint32_t GetMemoryFlags(bool cppSide) const
+    {
+        return GetSync()->m_memory.m_applied[cppSide ? Ns3AiMsgMemory::CPP : Ns3AiMsgMemory::PY];
+    };
+
+    /**
+     * Gets the bytes of the segment mapped by huge pages on one side,
+     * right after pre-faulting
+     */
+    uint64_t GetHugePageBytes(bool cppSide) const
+    {
+        return GetSync()
+            ->m_memory.m_hugeBytes[cppSide ? Ns3AiMsgMemory::CPP : Ns3AiMsgMemory::PY];
+    };
+
+    /**
+     * Gets the page faults one side took while pre-faulting the segment
+     */
+    uint64_t GetPrefaultFaults(bool cppSide) const
+    {
+        return GetSync()
+            ->m_memory.m_prefaultFaults[cppSide ? Ns3AiMsgMemory::CPP : Ns3AiMsgMemory::PY];
+    };
+
+    /**
+     * Gets the page faults the process of one side took since it
+     * pre-faulted the segment: until now for this side, until the finish
+     * for the other. Counted by the kernel per process, so they include
+     * faults outside the segment (e.g., the simulation allocating memory).
+     */
+    uint64_t GetRunFaults(bool cppSide)
+    {
+        if (cppSide != m_segment->IsCreator())
+        {
+            Dispatch([](auto& channel) { channel.RecordFaults(); });
+        }
+        return GetSync()->m_memory.m_runFaults[cppSide ? Ns3AiMsgMemory::CPP : Ns3AiMsgMemory::PY];
+    };
+
   private:
-    Cpp2PyMsgType* m_cpp2pyStruct;
-    Py2CppMsgType* m_py2CppStruct;
-    Cpp2PyMsgVector* m_cpp2pyVector;
-    Py2CppMsgVector* m_py2cppVector;
+    /**
+     * Calls f with the channel of the mode
+     */
+    template <typename F>
+    decltype(auto) Dispatch(F&& f)
+    {
+        if (m_useVector)
+        {
+            return f(*m_vectorChannel);
+        }
+        return f(*m_structChannel);
+    };
+
+    template <typename F>
+    decltype(auto) Dispatch(F&& f) const
+    {
+        if (m_useVector)
+        {
+            return f(static_cast<const VectorChannel&>(*m_vectorChannel));
+        }
+        return f(static_cast<const StructChannel&>(*m_structChannel));
+    };
+
+    Ns3AiMsgSync* GetSync() const
+    {
+        return Dispatch([](const auto& channel) { return channel.GetSync(); });
+    };
+
+    /**
+     * Makes sure that bytes can be allocated in the segment, see
+     * Ns3AiChannel::Reserve
+     */
+    void Reserve(std::size_t bytes)
+    {
+        Dispatch([bytes](auto& channel) { channel.Reserve(bytes); });
+    };
+
+    /**
+     * Finds the objects of the features, after the segment is opened or
+     * mapped again
+     */
+    void OpenFeatures()
+    {
+        boost::interprocess::managed_shared_memory& segment = m_segment->Get();
+        // record if either side enabled statistics
+        m_stats.Open(segment);
+        if (m_post.IsAttached())
+        {
+            m_post.Open(segment);
+        }
+        if (!m_segment->IsCreator() || m_broadcast.IsAttached())
+        {
+            m_broadcast.Open(segment);
+        }
+        if (m_freeRun.IsAttached())
+        {
+            m_freeRun.Open(segment);
+        }
+    };
+
+    /**
+     * Called when Python side starts reading a message: replays or checks
+     * whether the simulation is over, then records the message
+     */
+    void Received()
+    {
+        if (m_replay)
+        {
+            Replay();
+        }
+        else if (m_handleFinish)
+        {
+            m_isFinished = Dispatch([](auto& channel) { return channel.PyGetFinished(); });
+        }
+        if (m_recorder && !m_isFinished)
+        {
+            Dispatch([this](auto& channel) {
+                Record(Ns3AiMsgLogRecord::CPP2PY,
+                       channel.GetCpp2PyData(),
+                       channel.GetCpp2PyLength());
+            });
+        }
+    };
+
+    /**
+     * Appends the length items of the current message of a direction to
+     * the log
+     */
+    template <typename MsgType>
+    void Record(uint32_t direction, const MsgType* msgs, uint32_t length)
+    {
+        m_recorder->Append(direction, Ns3AiMsgStats::Now(), msgs, length * sizeof(MsgType));
+    };
+
+    /**
+     * Copies the next C++ to Python message of the replayed log into the
+     * current buffer, or finishes at the end of the log
+     */
+    void Replay()
+    {
+        const Ns3AiMsgLogRecord* record = m_replay->Next(Ns3AiMsgLogRecord::CPP2PY);
+        if (!record)
+        {
+            m_isFinished = true;
+            return;
+        }
+        Dispatch([record](auto& channel) { channel.CopyCpp2Py(record + 1, record->m_length); });
+    };
 
-    Ns3AiMsgSync* m_sync;
-    const bool m_isCreator;
     const bool m_useVector;
     const bool m_handleFinish;
-    const std::string m_segName;
     bool m_isFinished;
+    // the lockstep channel of the mode, which owns the segment
+    std::unique_ptr<StructChannel> m_structChannel;
+    std::unique_ptr<VectorChannel> m_vectorChannel;
+    Ns3AiMsgSegment* m_segment; //!< the segment of the channel
+    // the features, destroyed before the channel
+    Ns3AiMsgStatsRecorder m_stats;
+    Ns3AiMsgPost<Cpp2PyMsgType> m_post;
+    // copies of the messages sent, for subscribers
+    Ns3AiMsgBroadcaster<Cpp2PyMsgType> m_broadcast;
+    Ns3AiMsgFreeRun<Cpp2PyMsgType, Py2CppMsgType> m_freeRun;
+    Ns3AiMsgNotify m_notify;
+    // log of the messages, and log replayed instead of C++ side, on Python side
+    std::unique_ptr<Ns3AiMsgLogWriter> m_recorder;
+    std::unique_ptr<Ns3AiMsgLogReader> m_replay;
 };
 
 /**
  * \brief The message interface, a singleton class
+ *
+ * The singleton keeps a registry of named channels. Each channel is an
+ * impl with its own shared memory segment (named after the channel) and
+ * its own semaphores, so that several AI components in one ns-3 process
+ * can talk to their own Python side independently. The settings are
+ * read when a channel is first got, so they may differ among channels.
  */
 
 class Ns3AiMsgInterface : public Singleton<Ns3AiMsgInterface>
@@ -334,15 +1187,44 @@ class Ns3AiMsgInterface : public Singleton<Ns3AiMsgInterface>
     };
 
     /**
-     * Sets shared memory segment size, only valid for
-     * the shared memory creator. Normally the default
-     * size is OK.
+     * Sets the minimum shared memory segment size, only valid for
+     * the shared memory creator. By default (0), the size is
+     * computed from the message types and grown when needed.
      */
     void SetMemorySize(uint32_t size)
     {
         this->m_size = size;
     };
 
+    /**
+     * Sets the number of busy-wait iterations before the waiting side
+     * backs off and parks. See Ns3AiMsgInterfaceImpl::SetSpinBudget.
+     */
+    void SetSpinBudget(uint32_t spinBudget)
+    {
+        this->m_spinBudget = spinBudget;
+    };
+
+    /**
+     * Sets the number of slots in each direction of the ring-buffer
+     * interface, only valid for the shared memory creator. Must be
+     * a power of two.
+     */
+    void SetRingCapacity(uint32_t capacity)
+    {
+        this->m_ringCapacity = capacity;
+    };
+
+    /**
+     * Sets if the channels created afterwards record message counters and
+     * latency histograms, see Ns3AiMsgInterfaceImpl::EnableStats. Recording
+     * costs a few clock reads per message; disabled channels pay nothing.
+     */
+    void SetRecordStats(bool recordStats)
+    {
+        this->m_recordStats = recordStats;
+    };
+
     /**
      * Sets the names of the named objects. See Boost's
      * documentation for details. Normally the default
@@ -361,29 +1243,177 @@ class Ns3AiMsgInterface : public Singleton<Ns3AiMsgInterface>
 
     /**
      * Gets the impl which has semaphore (synchronization)
-     * methods
+     * methods, using the segment name set by SetNames
      */
     template <typename Cpp2PyMsgType, typename Py2CppMsgType>
     Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType>* GetInterface()
     {
-        static Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType> interface(
-            this->m_isMemoryCreator,
-            this->m_useVector,
-            this->m_handleFinish,
-            this->m_size,
-            this->m_segmentName.c_str(),
-            this->m_cpp2pyMsgName.c_str(),
-            this->m_py2cppMsgName.c_str(),
-            this->m_lockableName.c_str());
-        return &interface;
+        return GetInterface<Cpp2PyMsgType, Py2CppMsgType>(this->m_segmentName);
+    };
+
+    /**
+     * Gets the impl of the named channel, creating (or opening) it
+     * at the first call. The channel name is the name of the shared
+     * memory segment.
+     */
+    template <typename Cpp2PyMsgType, typename Py2CppMsgType>
+    Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType>* GetInterface(
+        const std::string& channelName)
+    {
+        typedef Ns3AiMsgInterfaceImpl<Cpp2PyMsgType, Py2CppMsgType> Impl;
+        Impl* interface = FindChannel<Impl>(channelName);
+        if (!interface)
+        {
+            // owned until registered, in case enabling the statistics throws
+            auto created = std::make_unique<Impl>(this->m_isMemoryCreator,
+                                                  this->m_useVector,
+                                                  this->m_handleFinish,
+                                                  this->m_size,
+                                                  channelName.c_str(),
+                                                  this->m_cpp2pyMsgName.c_str(),
+                                                  this->m_py2cppMsgName.c_str(),
+                                                  this->m_lockableName.c_str(),
+                                                  this->m_spinBudget);
+            if (this->m_recordStats)
+            {
+                created->EnableStats();
+            }
+            interface = AddChannel(channelName, std::move(created));
+        }
+        return interface;
+    };
+
+    /**
+     * Gets the named channel with its mode fixed at compile time (see
+     * Ns3AiChannel), creating (or opening) it at the first call. The
+     * vector and finish settings are replaced by the policies. Aborts if
+     * statistics are to be recorded (see SetRecordStats), which
+     * Ns3AiChannel does not do.
+     */
+    template <typename Cpp2PyMsgType,
+              typename Py2CppMsgType,
+              typename Mode = Ns3AiStructMode,
+              typename Finish = Ns3AiHandleFinish>
+    Ns3AiChannel<Cpp2PyMsgType, Py2CppMsgType, Mode, Finish>* GetChannel(
+        const std::string& channelName)
+    {
+        typedef Ns3AiChannel<Cpp2PyMsgType, Py2CppMsgType, Mode, Finish> Impl;
+        Impl* interface = FindChannel<Impl>(channelName);
+        if (!interface)
+        {
+            NS_ABORT_MSG_IF(this->m_recordStats,
+                            "Channel " << channelName
+                                       << " cannot record statistics, get it with GetInterface");
+            interface = AddChannel(channelName,
+                                   std::make_unique<Impl>(this->m_isMemoryCreator,
+                                                          this->m_size,
+                                                          channelName.c_str(),
+                                                          this->m_cpp2pyMsgName.c_str(),
+                                                          this->m_py2cppMsgName.c_str(),
+                                                          this->m_lockableName.c_str(),
+                                                          this->m_spinBudget));
+        }
+        return interface;
+    };
+
+    /**
+     * Gets the ring-buffer impl, which lets C++ side send several
+     * messages before Python side reads them, using the segment name
+     * set by SetNames. The lockable name is not used by this impl.
+     */
+    template <typename Cpp2PyMsgType, typename Py2CppMsgType>
+    Ns3AiMsgRingImpl<Cpp2PyMsgType, Py2CppMsgType>* GetRingInterface()
+    {
+        return GetRingInterface<Cpp2PyMsgType, Py2CppMsgType>(this->m_segmentName);
+    };
+
+    /**
+     * Gets the ring-buffer impl of the named channel
+     */
+    template <typename Cpp2PyMsgType, typename Py2CppMsgType>
+    Ns3AiMsgRingImpl<Cpp2PyMsgType, Py2CppMsgType>* GetRingInterface(
+        const std::string& channelName)
+    {
+        typedef Ns3AiMsgRingImpl<Cpp2PyMsgType, Py2CppMsgType> Impl;
+        Impl* interface = FindChannel<Impl>(channelName);
+        if (!interface)
+        {
+            interface = AddChannel(channelName,
+                                   std::make_unique<Impl>(this->m_isMemoryCreator,
+                                                          this->m_handleFinish,
+                                                          this->m_ringCapacity,
+                                                          this->m_size,
+                                                          channelName.c_str(),
+                                                          this->m_cpp2pyMsgName.c_str(),
+                                                          this->m_py2cppMsgName.c_str(),
+                                                          this->m_spinBudget));
+        }
+        return interface;
+    };
+
+    /**
+     * Destroys the named channel before the end of the program. On
+     * C++ side, this notifies Python side of finish (if enabled).
+     */
+    void CloseChannel(const std::string& channelName)
+    {
+        m_channels.erase(channelName);
     };
 
   private:
+    /**
+     * Gets the segment name used until SetNames: that of the NS3_AI_SEGMENT
+     * environment variable, which Experiment sets so that several simulations
+     * run at once with their own segments, or "My Seg"
+     */
+    static std::string GetDefaultSegmentName()
+    {
+        const char* name = std::getenv("NS3_AI_SEGMENT");
+        return name && *name ? name : "My Seg";
+    };
+
+    /**
+     * \brief A registered channel, type-erased
+     */
+    struct Channel
+    {
+        std::type_index m_type;
+        std::shared_ptr<void> m_impl;
+    };
+
+    template <typename Impl>
+    Impl* FindChannel(const std::string& channelName)
+    {
+        auto it = m_channels.find(channelName);
+        if (it == m_channels.end())
+        {
+            return nullptr;
+        }
+        // the same channel must always be got with the same types
+        assert(it->second.m_type == std::type_index(typeid(Impl)));
+        return static_cast<Impl*>(it->second.m_impl.get());
+    };
+
+    template <typename Impl>
+    Impl* AddChannel(const std::string& channelName, std::unique_ptr<Impl> interface)
+    {
+        Impl* impl = interface.get();
+        m_channels.emplace(
+            channelName,
+            Channel{std::type_index(typeid(Impl)), std::shared_ptr<Impl>(std::move(interface))});
+        return impl;
+    };
+
+    std::map<std::string, Channel> m_channels;
+
     bool m_isMemoryCreator;
     bool m_useVector;
     bool m_handleFinish;
-    uint32_t m_size = 4096;
-    std::string m_segmentName = "My Seg";
+    uint32_t m_size = 0;
+    uint32_t m_spinBudget = Ns3AiSemaphore::DEFAULT_SPIN_BUDGET;
+    uint32_t m_ringCapacity = 64;
+    bool m_recordStats = false;
+    std::string m_segmentName = GetDefaultSegmentName();
     std::string m_cpp2pyMsgName = "My Cpp to Python Msg";
     std::string m_py2cppMsgName = "My Python to Cpp Msg";
     std::string m_lockableName = "My Lockable";
@@ -0,0 +1,509 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_LATEST_H
+#define NS3_AI_MSG_LATEST_H
+
+#include "ns3-ai-msg-layout.h"
+#include "ns3-ai-msg-stats.h"
+#include "ns3-ai-semaphore.h"
+
+#include <ns3/abort.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <boost/interprocess/managed_shared_memory.hpp>
+
+namespace ns3
+{
+
+/**
+ * \brief A latest-value slot in shared memory: the writer overwrites the
+ * message without waiting, and the reader copies whichever message is the
+ * latest.
+ *
+ * The slot is a sequence lock. The version is odd while the message is being
+ * written and grows by two per message, so a reader retries its copy if the
+ * version was odd or changed during the copy. Each message carries a time
+ * (e.g., the simulation time of an observation) and a reference (e.g., the
+ * number of the observation an action answers).
+ *
+ * The slot holds up to a maximum length of messages (e.g., the items of a
+ * vector message), which follow m_msg; 1 for struct-based channels.
+ */
+template <typename MsgType>
+struct Ns3AiLatestSlot
+{
+    alignas(NS3_AI_CACHE_LINE_SIZE) volatile uint32_t m_version;
+    volatile uint32_t m_waiters;
+    volatile uint32_t m_finished;
+    uint32_t m_maxLength;
+    uint64_t m_time;
+    uint64_t m_ref;
+    uint32_t m_length; //!< number of messages written
+    alignas(NS3_AI_CACHE_LINE_SIZE) MsgType m_msg;
+};
+
+/**
+ * \brief Process-local view of a latest-value slot living in a shared memory segment
+ */
+template <typename MsgType>
+class Ns3AiLatest
+{
+  public:
+    typedef Ns3AiLatestSlot<MsgType> Slot;
+
+    static_assert(std::is_trivially_copyable<MsgType>::value,
+                  "Latest-value messages are copied byte by byte");
+
+    Ns3AiLatest()
+        : m_slot(nullptr)
+    {
+    }
+
+    /**
+     * Bytes of the segment taken by a slot holding up to maxLength messages
+     */
+    static std::size_t Size(const std::string& name, uint32_t maxLength = 1)
+    {
+        return Ns3AiMsgLayout::ObjectSize<char>(name, Stride(maxLength));
+    }
+
+    /**
+     * Constructs the slot in the segment
+     *
+     * \param maxLength the number of messages the slot holds
+     */
+    void Create(boost::interprocess::managed_shared_memory& segment,
+                const std::string& name,
+                uint32_t maxLength = 1)
+    {
+        assert(maxLength != 0);
+        m_slot = reinterpret_cast<Slot*>(
+            Ns3AiMsgLayout::Construct<char>(segment, name.c_str(), Stride(maxLength)));
+        m_slot->m_maxLength = maxLength;
+    }
+
+    /**
+     * Finds the slot constructed by the other side
+     *
+     * \return whether the slot exists in the segment
+     */
+    bool Open(boost::interprocess::managed_shared_memory& segment, const std::string& name)
+    {
+        m_slot = Ns3AiMsgLayout::Find<Slot>(segment, name.c_str());
+        return m_slot != nullptr;
+    }
+
+    /**
+     * Whether the slot is created or opened
+     */
+    bool IsAttached() const
+    {
+        return m_slot != nullptr;
+    }
+
+    /**
+     * Gets the number of messages the slot holds
+     */
+    uint32_t GetMaxLength() const
+    {
+        return m_slot->m_maxLength;
+    }
+
+    /**
+     * Overwrites the messages with length (at most the maximum length) new
+     * ones, never waits. Only one process may write.
+     */
+    void Write(const MsgType* msgs, uint32_t length, uint64_t time, uint64_t ref)
+    {
+        assert(length <= m_slot->m_maxLength);
+        uint32_t version = m_slot->m_version;
+        m_slot->m_version = version + 1;
+        __sync_synchronize();
+        m_slot->m_length = length;
+        std::memcpy(&m_slot->m_msg, msgs, length * sizeof(MsgType));
+        m_slot->m_time = time;
+        m_slot->m_ref = ref;
+        Ns3AiSemaphore::store_and_wake(&m_slot->m_version, version + 2, &m_slot->m_waiters);
+    }
+
+    /**
+     * Copies the latest messages
+     *
+     * \param msgs room for the maximum length of messages
+     * \param length set to the number of messages copied
+     * \return their version, 0 if no message has been written
+     */
+    uint32_t Read(MsgType* msgs, uint32_t& length, uint64_t& time, uint64_t& ref) const
+    {
+        while (true)
+        {
+            uint32_t version = Ns3AiSemaphore::atomic_read32(&m_slot->m_version);
+            if (version & 1)
+            {
+                Ns3AiSemaphore::cpu_relax();
+                continue;
+            }
+            if (version == 0)
+            {
+                return 0;
+            }
+            // bounded in case the messages are being overwritten, checked below
+            length = std::min(m_slot->m_length, m_slot->m_maxLength);
+            std::memcpy(msgs, &m_slot->m_msg, length * sizeof(MsgType));
+            time = m_slot->m_time;
+            ref = m_slot->m_ref;
+            // the copy must complete before the version is checked again
+            __sync_synchronize();
+            if (Ns3AiSemaphore::atomic_read32(&m_slot->m_version) == version)
+            {
+                return version;
+            }
+        }
+    }
+
+    /**
+     * Waits until the version differs from the given one (i.e., a newer
+     * message is written) or the writer has finished, for at most
+     * timeout_ns nanoseconds
+     *
+     * \return whether the version differs
+     */
+    bool WaitNewer(uint32_t version, uint64_t timeout_ns) const
+    {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point deadline = Clock::now() + std::chrono::nanoseconds(timeout_ns);
+        if (Ns3AiSemaphore::atomic_read32(&m_slot->m_version) != version)
+        {
+            return true;
+        }
+        Ns3AiSemaphore::atomic_add32(&m_slot->m_waiters, 1);
+        bool newer;
+        while (!(newer = Ns3AiSemaphore::atomic_read32(&m_slot->m_version) != version))
+        {
+            Clock::time_point now = Clock::now();
+            if (now >= deadline)
+            {
+                break;
+            }
+            uint64_t left =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+            struct timespec timeout;
+            timeout.tv_sec = left / 1000000000;
+            timeout.tv_nsec = left % 1000000000;
+            Ns3AiSemaphore::futex_wait(&m_slot->m_version, version, &timeout);
+        }
+        Ns3AiSemaphore::atomic_add32(&m_slot->m_waiters, -1);
+        return newer;
+    }
+
+    /**
+     * Tells the reader that no message will follow. The version changes as
+     * well to wake the reader up, which then checks IsFinished.
+     */
+    void SetFinished()
+    {
+        m_slot->m_finished = 1;
+        Ns3AiSemaphore::store_and_wake(&m_slot->m_version,
+                                       m_slot->m_version + 2,
+                                       &m_slot->m_waiters);
+    }
+
+    bool IsFinished() const
+    {
+        return m_slot->m_finished;
+    }
+
+  private:
+    /**
+     * Bytes of a slot holding up to maxLength messages
+     */
+    static std::size_t Stride(uint32_t maxLength)
+    {
+        return sizeof(Slot) +
+               Ns3AiMsgLayout::AlignUp((maxLength - 1) * sizeof(MsgType), NS3_AI_CACHE_LINE_SIZE);
+    }
+
+    Slot* m_slot;
+};
+
+/**
+ * \brief Free-running mode of a channel, see
+ * Ns3AiMsgInterfaceImpl::EnableFreeRun
+ *
+ * A latest-value slot of observations written by C++ side and one of
+ * actions written by Python side, which Python side creates and C++ side
+ * finds when it first uses them. Python side reads and writes through
+ * copies, so that it never holds a slot.
+ */
+template <typename Cpp2PyMsgType, typename Py2CppMsgType>
+class Ns3AiMsgFreeRun
+{
+  public:
+    Ns3AiMsgFreeRun() = delete;
+
+    /**
+     * \param observationName the name of the observation slot in the segment
+     * \param actionName the name of the action slot
+     */
+    Ns3AiMsgFreeRun(const std::string& observationName, const std::string& actionName)
+        : m_observationName(observationName),
+          m_actionName(actionName),
+          m_published(0),
+          m_publishTime(0),
+          m_observationLength(0),
+          m_actionLength(0),
+          m_observationVersion(0),
+          m_observationTime(0),
+          m_observationRef(0),
+          m_isFinished(false)
+    {
+    }
+
+    /**
+     * Bytes of the segment taken by the slots
+     */
+    std::size_t Size(uint32_t observationLength, uint32_t actionLength) const
+    {
+        return Ns3AiLatest<Cpp2PyMsgType>::Size(m_observationName, observationLength) +
+               Ns3AiLatest<Py2CppMsgType>::Size(m_actionName, actionLength);
+    }
+
+    /**
+     * Constructs the slots, on Python side
+     */
+    void Create(boost::interprocess::managed_shared_memory& segment,
+                uint32_t observationLength,
+                uint32_t actionLength)
+    {
+        m_observation.Create(segment, m_observationName, observationLength);
+        m_action.Create(segment, m_actionName, actionLength);
+        m_latestObservation.assign(observationLength, Cpp2PyMsgType());
+        m_latestAction.assign(actionLength, Py2CppMsgType());
+        m_actionLength = actionLength;
+    }
+
+    /**
+     * Finds the slots, e.g. after the segment is mapped again
+     *
+     * \return whether Python side enabled free-running mode
+     */
+    bool Open(boost::interprocess::managed_shared_memory& segment)
+    {
+        return m_observation.Open(segment, m_observationName) &&
+               m_action.Open(segment, m_actionName);
+    }
+
+    bool IsAttached() const
+    {
+        return m_observation.IsAttached();
+    }
+
+    // for C++ side:
+
+    /**
+     * Finds the slots the first time, aborting if Python side did not
+     * enable free-running mode
+     */
+    void Attach(boost::interprocess::managed_shared_memory& segment)
+    {
+        if (!IsAttached())
+        {
+            NS_ABORT_MSG_IF(!Open(segment),
+                            "Free-running mode is not enabled on Python side, see EnableFreeRun");
+        }
+    }
+
+    /**
+     * Gets the number of items an action holds at most
+     */
+    uint32_t GetActionMaxLength() const
+    {
+        return m_action.GetMaxLength();
+    }
+
+    /**
+     * Publishes an observation of length items made at time. Aborts if it
+     * is longer than the slot.
+     */
+    void Publish(const Cpp2PyMsgType* msgs,
+                 uint32_t length,
+                 uint64_t time,
+                 Ns3AiMsgStatsRecorder& stats)
+    {
+        NS_ABORT_MSG_IF(length > m_observation.GetMaxLength(),
+                        "An observation of " << length << " items does not fit in the slot of "
+                                             << m_observation.GetMaxLength()
+                                             << " items, see EnableFreeRun");
+        m_observation.Write(msgs, length, time, ++m_published);
+        m_publishTime = time;
+        stats.Count(Ns3AiMsgStats::PUBLISH_COUNT, 1);
+    }
+
+    /**
+     * Copies the latest action and records how many observations and how
+     * much time it lags behind
+     *
+     * \param msgs room for the maximum length of an action
+     * \param length set to the number of items copied
+     * \param time if not null, set to the time of the observation the
+     *        action answers
+     * \return false if Python side has not written any action yet
+     */
+    bool ReadAction(Py2CppMsgType* msgs,
+                    uint32_t& length,
+                    uint64_t* time,
+                    Ns3AiMsgStatsRecorder& stats)
+    {
+        uint64_t actionTime;
+        uint64_t ref;
+        if (!m_action.Read(msgs, length, actionTime, ref))
+        {
+            stats.Count(Ns3AiMsgStats::ACTION_MISSING, 1);
+            return false;
+        }
+        if (time)
+        {
+            *time = actionTime;
+        }
+        stats.Count(Ns3AiMsgStats::ACTION_COUNT, 1);
+        stats.Record(Ns3AiMsgStats::ACTION_LAG, m_published - ref);
+        stats.Record(Ns3AiMsgStats::ACTION_AGE,
+                     m_publishTime > actionTime ? m_publishTime - actionTime : 0);
+        return true;
+    }
+
+    /**
+     * Tells Python side that no observation will follow, if it enabled
+     * free-running mode
+     */
+    void SetFinished(boost::interprocess::managed_shared_memory& segment)
+    {
+        if (IsAttached() || m_observation.Open(segment, m_observationName))
+        {
+            m_observation.SetFinished();
+        }
+    }
+
+    // for Python side:
+
+    /**
+     * Waits at most timeout_ns nanoseconds for an observation newer than the
+     * last one read, and copies it
+     *
+     * \return whether a new observation is read, false on timeout or when
+     *         the simulation is over (see IsFinished)
+     */
+    bool WaitObservation(uint64_t timeout_ns)
+    {
+        bool newer = m_observation.WaitNewer(m_observationVersion, timeout_ns);
+        // checked even on timeout, the last read may have raced with the finish
+        if (m_observation.IsFinished())
+        {
+            m_isFinished = true;
+            return false;
+        }
+        if (!newer)
+        {
+            return false;
+        }
+        m_observationVersion = m_observation.Read(m_latestObservation.data(),
+                                                  m_observationLength,
+                                                  m_observationTime,
+                                                  m_observationRef);
+        return true;
+    }
+
+    /**
+     * Whether WaitObservation found the simulation over
+     */
+    bool IsFinished() const
+    {
+        return m_isFinished;
+    }
+
+    Cpp2PyMsgType* GetObservation()
+    {
+        return m_latestObservation.data();
+    }
+
+    uint32_t GetObservationLength() const
+    {
+        return m_observationLength;
+    }
+
+    uint64_t GetObservationTime() const
+    {
+        return m_observationTime;
+    }
+
+    Py2CppMsgType* GetAction()
+    {
+        return m_latestAction.data();
+    }
+
+    void SetActionLength(uint32_t length)
+    {
+        assert(length <= m_latestAction.size() && "Action does not fit in its slot");
+        m_actionLength = length;
+    }
+
+    uint32_t GetActionLength() const
+    {
+        return m_actionLength;
+    }
+
+    /**
+     * Publishes the action computed for the observation read last,
+     * overwriting the previous one
+     */
+    void PublishAction()
+    {
+        m_action.Write(m_latestAction.data(), m_actionLength, m_observationTime, m_observationRef);
+    }
+
+  private:
+    const std::string m_observationName;
+    const std::string m_actionName;
+    Ns3AiLatest<Cpp2PyMsgType> m_observation;
+    Ns3AiLatest<Py2CppMsgType> m_action;
+    uint64_t m_published;   //!< number of observations published, on C++ side
+    uint64_t m_publishTime; //!< time of the latest observation, on C++ side
+    // copies of the observation read and the action to write, on Python side
+    std::vector<Cpp2PyMsgType> m_latestObservation;
+    std::vector<Py2CppMsgType> m_latestAction;
+    uint32_t m_observationLength;  //!< items of the observation read
+    uint32_t m_actionLength;       //!< items of the action written
+    uint32_t m_observationVersion; //!< version of the observation read
+    uint64_t m_observationTime;    //!< time of the observation read
+    uint64_t m_observationRef;     //!< number of the observation read
+    bool m_isFinished;             //!< whether the last observation is read
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_LATEST_H
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_LAYOUT_H
+#define NS3_AI_MSG_LAYOUT_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <boost/interprocess/managed_shared_memory.hpp>
+
+#define NS3_AI_CACHE_LINE_SIZE 64
+
+/**
+ * Alignment of the messages and semaphores in the shared memory segment.
+ * Defaults to a cache line; define it as the page size (e.g., 4096) to put
+ * every message on its own pages. Both sides must use the same value.
+ */
+#ifndef NS3_AI_MSG_ALIGN
+#define NS3_AI_MSG_ALIGN NS3_AI_CACHE_LINE_SIZE
+#endif
+
+namespace ns3
+{
+
+/**
+ * \brief Places named objects in a shared memory segment at a given alignment.
+ *
+ * boost::interprocess only guarantees the alignment of max_align_t for named
+ * objects, so two small objects constructed one after another usually share
+ * a cache line, and alignas on their members is not honored. Here each object
+ * is placed in a named byte buffer that is large enough to align its start and
+ * round its end up to the alignment, so no other object shares its lines.
+ *
+ * The segment is mapped at a page-aligned address in every process, so both
+ * sides compute the same offset for any alignment up to the page size.
+ */
+struct Ns3AiMsgLayout
+{
+    /**
+     * Bytes of a segment used by boost::interprocess itself (224 on 64-bit
+     * Linux with Boost 1.7x, rounded up for other versions)
+     */
+    static constexpr std::size_t SEGMENT_OVERHEAD = 512;
+
+    /**
+     * Bookkeeping of an allocation or a named object, besides the name
+     * (at most 80 bytes on 64-bit Linux, rounded up likewise)
+     */
+    static constexpr std::size_t BLOCK_OVERHEAD = 128;
+
+    static std::size_t AlignUp(std::size_t value, std::size_t align)
+    {
+        return (value + align - 1) & ~(align - 1);
+    }
+
+    /**
+     * Bytes of the segment taken by an allocation (e.g., the elements of
+     * a vector)
+     */
+    static std::size_t AllocSize(std::size_t bytes)
+    {
+        return BLOCK_OVERHEAD + AlignUp(bytes, 16);
+    }
+
+    /**
+     * Bytes of the segment taken by a named object (e.g., a vector)
+     */
+    static std::size_t NamedSize(const std::string& name, std::size_t bytes)
+    {
+        return AllocSize(name.size() + 1 + bytes);
+    }
+
+    /**
+     * Bytes of the segment taken by Construct<T>(segment, name, count, align)
+     */
+    template <typename T>
+    static std::size_t ObjectSize(const std::string& name,
+                                  std::size_t count = 1,
+                                  std::size_t align = NS3_AI_MSG_ALIGN)
+    {
+        return NamedSize(name, AlignUp(count * sizeof(T), align) + align - 1);
+    }
+
+    /**
+     * Constructs an array of count objects, value-initialized
+     */
+    template <typename T>
+    static T* Construct(boost::interprocess::managed_shared_memory& segment,
+                        const char* name,
+                        std::size_t count = 1,
+                        std::size_t align = NS3_AI_MSG_ALIGN)
+    {
+        assert(align != 0 && (align & (align - 1)) == 0);
+        std::size_t bytes = AlignUp(count * sizeof(T), align) + align - 1;
+        char* raw = segment.construct<char>(name)[bytes](0);
+        T* objects = Align<T>(raw, align);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            new (objects + i) T();
+        }
+        return objects;
+    }
+
+    /**
+     * Finds the object, or constructs it if neither side has done so.
+     * T must be a trivial type whose initial state is all bytes zero.
+     */
+    template <typename T>
+    static T* FindOrConstruct(boost::interprocess::managed_shared_memory& segment,
+                              const char* name,
+                              std::size_t align = NS3_AI_MSG_ALIGN)
+    {
+        static_assert(std::is_trivial<T>::value, "T must be zero-initialized");
+        assert(align != 0 && (align & (align - 1)) == 0);
+        std::size_t bytes = AlignUp(sizeof(T), align) + align - 1;
+        char* raw = segment.find_or_construct<char>(name)[bytes](0);
+        return Align<T>(raw, align);
+    }
+
+    /**
+     * Finds the objects constructed by the other side
+     *
+     * \return nullptr if they do not exist in the segment
+     */
+    template <typename T>
+    static T* Find(boost::interprocess::managed_shared_memory& segment,
+                   const char* name,
+                   std::size_t align = NS3_AI_MSG_ALIGN)
+    {
+        char* raw = segment.find<char>(name).first;
+        return raw ? Align<T>(raw, align) : nullptr;
+    }
+
+    /**
+     * Gets whether an object of this name exists in the segment
+     */
+    static bool Exists(boost::interprocess::managed_shared_memory& segment, const std::string& name)
+    {
+        return segment.find<char>(name.c_str()).first != nullptr;
+    }
+
+  private:
+    template <typename T>
+    static T* Align(char* raw, std::size_t align)
+    {
+        return reinterpret_cast<T*>(AlignUp(reinterpret_cast<std::uintptr_t>(raw), align));
+    }
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_LAYOUT_H
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_LOG_H
+#define NS3_AI_MSG_LOG_H
+
+#include "ns3-ai-msg-layout.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * \brief Header at the start of a message log file.
+ *
+ * The sizes are those of the message types (or of the vector items), so that
+ * a log is only replayed with the types it was recorded with. m_end is
+ * updated after every record, so the log of a process that crashed is still
+ * readable up to its last complete record.
+ */
+struct Ns3AiMsgLogHeader
+{
+    char m_magic[8];
+    uint32_t m_version;
+    // 1 if the messages are vectors, whose records hold any number of items
+    uint32_t m_useVector;
+    uint32_t m_cpp2pySize;
+    uint32_t m_py2cppSize;
+    // bytes of the file holding the header and complete records
+    volatile uint64_t m_end;
+};
+
+/**
+ * \brief Header of a record in a message log, followed by length bytes of
+ * payload and padding to 8 bytes
+ */
+struct Ns3AiMsgLogRecord
+{
+    enum Direction : uint32_t
+    {
+        CPP2PY = 0,
+        PY2CPP = 1,
+    };
+
+    // steady clock time of the record, in nanoseconds
+    uint64_t m_time;
+    uint32_t m_length;
+    uint32_t m_direction;
+};
+
+/**
+ * \brief Append-only message log in a memory-mapped file
+ *
+ * Records are copied into the mapping, so appending costs a memcpy; the
+ * file grows by doubling its mapping and is truncated to its content when
+ * closed.
+ */
+class Ns3AiMsgLogWriter
+{
+  public:
+    static constexpr char MAGIC[8] = {'N', 'S', '3', 'A', 'I', 'L', 'O', 'G'};
+    static constexpr uint32_t VERSION = 1;
+    static constexpr std::size_t INITIAL_CAPACITY = 1 << 20;
+
+    /**
+     * Creates (or truncates) the log file
+     *
+     * \param path the file
+     * \param use_vector whether the messages are vectors
+     * \param cpp2py_size the size of a C++ to Python message (or item)
+     * \param py2cpp_size the size of a Python to C++ message (or item)
+     */
+    Ns3AiMsgLogWriter(const std::string& path,
+                      bool use_vector,
+                      uint32_t cpp2py_size,
+                      uint32_t py2cpp_size)
+        : m_path(path),
+          m_fd(-1),
+          m_capacity(0),
+          m_data(nullptr)
+    {
+        m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("Cannot create message log " + path + ": " +
+                                     std::strerror(errno));
+        }
+        Map(INITIAL_CAPACITY);
+        Ns3AiMsgLogHeader* header = Header();
+        std::memcpy(header->m_magic, MAGIC, sizeof(MAGIC));
+        header->m_version = VERSION;
+        header->m_useVector = use_vector;
+        header->m_cpp2pySize = cpp2py_size;
+        header->m_py2cppSize = py2cpp_size;
+        header->m_end = sizeof(Ns3AiMsgLogHeader);
+    }
+
+    Ns3AiMsgLogWriter(const Ns3AiMsgLogWriter&) = delete;
+    Ns3AiMsgLogWriter& operator=(const Ns3AiMsgLogWriter&) = delete;
+
+    ~Ns3AiMsgLogWriter()
+    {
+        uint64_t end = Header()->m_end;
+        munmap(m_data, m_capacity);
+        (void)!ftruncate(m_fd, end);
+        close(m_fd);
+    }
+
+    /**
+     * Appends a record
+     *
+     * \param direction Ns3AiMsgLogRecord::CPP2PY or PY2CPP
+     * \param time the time of the record in nanoseconds
+     * \param payload the message
+     * \param length its size in bytes
+     */
+    void Append(uint32_t direction, uint64_t time, const void* payload, uint32_t length)
+    {
+        uint64_t end = Header()->m_end;
+        uint64_t next = end + sizeof(Ns3AiMsgLogRecord) + Ns3AiMsgLayout::AlignUp(length, 8);
+        if (next > m_capacity)
+        {
+            std::size_t capacity = m_capacity;
+            while (capacity < next)
+            {
+                capacity *= 2;
+            }
+            munmap(m_data, m_capacity);
+            Map(capacity);
+        }
+        Ns3AiMsgLogRecord* record = reinterpret_cast<Ns3AiMsgLogRecord*>(m_data + end);
+        record->m_time = time;
+        record->m_length = length;
+        record->m_direction = direction;
+        std::memcpy(record + 1, payload, length);
+        Header()->m_end = next;
+    }
+
+    /**
+     * Gets the number of bytes written so far
+     */
+    uint64_t GetSize() const
+    {
+        return Header()->m_end;
+    }
+
+  private:
+    Ns3AiMsgLogHeader* Header() const
+    {
+        return reinterpret_cast<Ns3AiMsgLogHeader*>(m_data);
+    }
+
+    /**
+     * Extends the file to capacity bytes and maps all of it
+     */
+    void Map(std::size_t capacity)
+    {
+        if (ftruncate(m_fd, capacity) != 0)
+        {
+            throw std::runtime_error("Cannot extend message log " + m_path + ": " +
+                                     std::strerror(errno));
+        }
+        void* data = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        if (data == MAP_FAILED)
+        {
+            throw std::runtime_error("Cannot map message log " + m_path + ": " +
+                                     std::strerror(errno));
+        }
+        m_data = static_cast<char*>(data);
+        m_capacity = capacity;
+    }
+
+    std::string m_path;
+    int m_fd;
+    std::size_t m_capacity;
+    char* m_data;
+};
+
+/**
+ * \brief Sequential reader of a message log, mapping the whole file read-only
+ */
+class Ns3AiMsgLogReader
+{
+  public:
+    /**
+     * Opens the log file and checks that it was recorded with the given
+     * message types
+     */
+    Ns3AiMsgLogReader(const std::string& path,
+                      bool use_vector,
+                      uint32_t cpp2py_size,
+                      uint32_t py2cpp_size)
+        : m_data(nullptr),
+          m_size(0)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open message log " + path + ": " +
+                                     std::strerror(errno));
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(Ns3AiMsgLogHeader))
+        {
+            void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                m_data = static_cast<const char*>(data);
+                m_size = st.st_size;
+                // sequential reads, let the kernel read ahead
+                madvise(data, m_size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+        const Ns3AiMsgLogHeader* header = reinterpret_cast<const Ns3AiMsgLogHeader*>(m_data);
+        std::string error;
+        if (!m_data ||
+            std::memcmp(header->m_magic, Ns3AiMsgLogWriter::MAGIC, sizeof(header->m_magic)) != 0 ||
+            header->m_version != Ns3AiMsgLogWriter::VERSION || header->m_end > m_size)
+        {
+            error = "Not a message log: " + path;
+        }
+        else if (header->m_useVector != use_vector || header->m_cpp2pySize != cpp2py_size ||
+                 header->m_py2cppSize != py2cpp_size)
+        {
+            error = "Message log " + path + " was recorded with other message types";
+        }
+        if (!error.empty())
+        {
+            if (m_data)
+            {
+                munmap(const_cast<char*>(m_data), m_size);
+            }
+            throw std::runtime_error(error);
+        }
+        m_end = header->m_end;
+        m_offset = sizeof(Ns3AiMsgLogHeader);
+    }
+
+    Ns3AiMsgLogReader(const Ns3AiMsgLogReader&) = delete;
+    Ns3AiMsgLogReader& operator=(const Ns3AiMsgLogReader&) = delete;
+
+    ~Ns3AiMsgLogReader()
+    {
+        munmap(const_cast<char*>(m_data), m_size);
+    }
+
+    /**
+     * Gets the next record in the given direction, skipping the others
+     *
+     * \return the record, whose payload follows it, or nullptr at the end
+     */
+    const Ns3AiMsgLogRecord* Next(uint32_t direction)
+    {
+        while (m_offset < m_end)
+        {
+            const Ns3AiMsgLogRecord* record =
+                reinterpret_cast<const Ns3AiMsgLogRecord*>(m_data + m_offset);
+            m_offset += sizeof(Ns3AiMsgLogRecord) + Ns3AiMsgLayout::AlignUp(record->m_length, 8);
+            if (record->m_direction == direction)
+            {
+                return record;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Gets the length of the longest payload in the given direction, over
+     * the whole log and wherever the reader is
+     */
+    uint32_t GetMaxLength(uint32_t direction) const
+    {
+        uint32_t length = 0;
+        for (uint64_t offset = sizeof(Ns3AiMsgLogHeader); offset < m_end;)
+        {
+            const Ns3AiMsgLogRecord* record =
+                reinterpret_cast<const Ns3AiMsgLogRecord*>(m_data + offset);
+            offset += sizeof(Ns3AiMsgLogRecord) + Ns3AiMsgLayout::AlignUp(record->m_length, 8);
+            if (record->m_direction == direction)
+            {
+                length = std::max(length, record->m_length);
+            }
+        }
+        return length;
+    }
+
+    /**
+     * Goes back to the first record
+     */
+    void Rewind()
+    {
+        m_offset = sizeof(Ns3AiMsgLogHeader);
+    }
+
+  private:
+    const char* m_data;
+    std::size_t m_size;
+    uint64_t m_end;
+    uint64_t m_offset;
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_LOG_H
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_MEMORY_H
+#define NS3_AI_MSG_MEMORY_H
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Linux 5.14, missing from older headers
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+namespace ns3
+{
+
+/**
+ * \brief How each side mapped a segment, in the segment itself so that
+ * Python side can report both sides
+ */
+struct Ns3AiMsgMemoryState
+{
+    // Ns3AiMsgMemory::Flags requested by Python side, applied by both sides
+    uint32_t m_flags{0};
+    // flags that took effect, indexed by Ns3AiMsgMemory::Side
+    uint32_t m_applied[2]{};
+    // bytes of the mapping backed by huge pages after pre-faulting
+    uint64_t m_hugeBytes[2]{};
+    // page faults taken while pre-faulting
+    uint64_t m_prefaultFaults[2]{};
+    // page faults of the process from the pre-faulting to the finish
+    uint64_t m_runFaults[2]{};
+};
+
+/**
+ * \brief Prepares the mapping of a segment before the first message, so
+ * that no page fault lands on the message path.
+ *
+ * A fresh mapping takes a fault on the first touch of every page, in each
+ * process, and the kernel may reclaim or split its pages later. Pre-faulting
+ * populates the page tables up front, transparent huge pages cut the number
+ * of pages (and TLB entries) by 512, and locking keeps the pages resident.
+ */
+struct Ns3AiMsgMemory
+{
+    enum Flags : uint32_t
+    {
+        PREFAULT = 1,
+        HUGE_PAGES = 2,
+        LOCK = 4,
+    };
+
+    enum Side : uint32_t
+    {
+        CPP = 0,
+        PY = 1,
+    };
+
+    /**
+     * Size of a transparent huge page on x86-64 and arm64 with 4 KB pages
+     */
+    static constexpr std::size_t HUGE_PAGE_SIZE = 2 << 20;
+
+    /**
+     * Gets the number of page faults (minor and major) this process has taken
+     */
+    static uint64_t GetFaults()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+        return usage.ru_minflt + usage.ru_majflt;
+    }
+
+    /**
+     * Applies flags to the mapping [addr, addr + size). Huge pages are
+     * advised before the pages are touched, since a page populated small
+     * is only collapsed later by khugepaged. Pre-faulting never writes to
+     * the segment, which the other side may already be using.
+     *
+     * \param addr the page-aligned start of the mapping
+     * \return the flags that took effect
+     */
+    static uint32_t Prepare(void* addr, std::size_t size, uint32_t flags)
+    {
+        uint32_t applied = 0;
+        if ((flags & HUGE_PAGES) && madvise(addr, size, MADV_HUGEPAGE) == 0)
+        {
+            applied |= HUGE_PAGES;
+        }
+        if (flags & PREFAULT)
+        {
+            if (madvise(addr, size, MADV_POPULATE_WRITE) != 0)
+            {
+                // older kernels: a read maps every page, and a write to a
+                // present shared page takes no fault on tmpfs
+                std::size_t page = sysconf(_SC_PAGESIZE);
+                for (std::size_t off = 0; off < size; off += page)
+                {
+                    (void)*static_cast<volatile const char*>(static_cast<char*>(addr) + off);
+                }
+            }
+            applied |= PREFAULT;
+        }
+        if ((flags & LOCK) && mlock(addr, size) == 0)
+        {
+            applied |= LOCK;
+        }
+        return applied;
+    }
+
+    /**
+     * Prepares the mapping for one side and records the outcome in state
+     *
+     * \return the number of faults of the process afterwards, for Finish
+     */
+    static uint64_t Prepare(void* addr, std::size_t size, Ns3AiMsgMemoryState& state, Side side)
+    {
+        uint64_t before = GetFaults();
+        state.m_applied[side] = Prepare(addr, size, state.m_flags);
+        uint64_t after = GetFaults();
+        state.m_prefaultFaults[side] = after - before;
+        state.m_hugeBytes[side] = GetHugeBytes(addr);
+        return after;
+    }
+
+    /**
+     * Records the faults one side took since Prepare
+     *
+     * \param base the value Prepare returned
+     */
+    static void Finish(Ns3AiMsgMemoryState& state, Side side, uint64_t base)
+    {
+        state.m_runFaults[side] = GetFaults() - base;
+    }
+
+    /**
+     * Gets the bytes of the mapping containing addr that are mapped by huge
+     * pages, from /proc/self/smaps
+     */
+    static uint64_t GetHugeBytes(const void* addr)
+    {
+        FILE* smaps = std::fopen("/proc/self/smaps", "r");
+        if (!smaps)
+        {
+            return 0;
+        }
+        uintptr_t target = reinterpret_cast<uintptr_t>(addr);
+        bool inside = false;
+        uint64_t kb = 0;
+        char line[256];
+        while (std::fgets(line, sizeof(line), smaps))
+        {
+            unsigned long start;
+            unsigned long end;
+            unsigned long value;
+            if (std::sscanf(line, "%lx-%lx ", &start, &end) == 2)
+            {
+                if (inside)
+                {
+                    break;
+                }
+                inside = start <= target && target < end;
+            }
+            else if (inside && (std::sscanf(line, "ShmemPmdMapped: %lu kB", &value) == 1 ||
+                                std::sscanf(line, "FilePmdMapped: %lu kB", &value) == 1))
+            {
+                kb += value;
+            }
+        }
+        std::fclose(smaps);
+        return kb * 1024;
+    }
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_MEMORY_H
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_NOTIFY_H
+#define NS3_AI_MSG_NOTIFY_H
+
+#include "ns3-ai-msg-channel.h"
+#include "ns3-ai-semaphore.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * \brief Notifications of a channel through a FIFO, for Python side waiting
+ * in an event loop, see Ns3AiMsgInterfaceImpl::EnableNotify
+ *
+ * Python side creates the FIFO and keeps its non-blocking read end. When
+ * it cannot begin without waiting, it registers as a waiter of the
+ * semaphore, and C++ side writes a byte to the FIFO when it posts a
+ * semaphore with waiters. Eventfds cannot be shared by unrelated
+ * processes, hence the FIFO.
+ */
+class Ns3AiMsgNotify
+{
+  public:
+    Ns3AiMsgNotify()
+        : m_fd(-1),
+          m_writeFd(-1),
+          m_recvArmed(false),
+          m_sendArmed(false)
+    {
+    }
+
+    ~Ns3AiMsgNotify()
+    {
+        if (m_fd >= 0)
+        {
+            close(m_fd);
+            close(m_writeFd);
+            unlink(m_path.c_str());
+            rmdir(m_path.substr(0, m_path.rfind('/')).c_str());
+        }
+        else if (m_writeFd >= 0)
+        {
+            close(m_writeFd);
+        }
+    };
+
+    Ns3AiMsgNotify(const Ns3AiMsgNotify&) = delete;
+    Ns3AiMsgNotify& operator=(const Ns3AiMsgNotify&) = delete;
+
+    /**
+     * Creates the FIFO and publishes its path in sync, on Python side
+     */
+    void Create(Ns3AiMsgSync* sync)
+    {
+        assert(m_fd < 0);
+        char dir[] = "/tmp/ns3ai-XXXXXX";
+        bool created = mkdtemp(dir) != nullptr;
+        assert(created && "Cannot create the directory of the FIFO");
+        (void)created;
+        std::snprintf(sync->m_notifyPath, sizeof(sync->m_notifyPath), "%s/notify", dir);
+        m_path = sync->m_notifyPath;
+        created = mkfifo(m_path.c_str(), 0600) == 0;
+        assert(created && "Cannot create the FIFO");
+        m_fd = open(m_path.c_str(), O_RDONLY | O_NONBLOCK);
+        // keeps the FIFO from reading end-of-file when C++ side exits
+        m_writeFd = open(m_path.c_str(), O_WRONLY | O_NONBLOCK);
+    };
+
+    /**
+     * Opens the FIFO if Python side created one, on C++ side
+     */
+    void Open(const Ns3AiMsgSync* sync)
+    {
+        if (sync->m_notifyPath[0])
+        {
+            // the read end is open on Python side, so this does not block
+            m_writeFd = open(sync->m_notifyPath, O_WRONLY | O_NONBLOCK);
+        }
+    };
+
+    /**
+     * Gets the read end of the FIFO, -1 if it is not created
+     */
+    int GetFd() const
+    {
+        return m_fd;
+    };
+
+    // for C++ side:
+
+    /**
+     * Notifies Python side waiting to receive, after a message is sent
+     */
+    void NotifyRecv(const Ns3AiMsgSync* sync)
+    {
+        Notify(&sync->m_cpp2pyFullWaiters);
+    };
+
+    /**
+     * Notifies Python side waiting to send, after a message is read
+     */
+    void NotifySend(const Ns3AiMsgSync* sync)
+    {
+        Notify(&sync->m_py2cppEmptyWaiters);
+    };
+
+    // for Python side:
+
+    /**
+     * Starts receiving with tryRecvBegin if possible, or waits through the
+     * FIFO, see TryWait
+     */
+    template <typename TryBegin>
+    bool TryRecvBegin(TryBegin tryRecvBegin, Ns3AiMsgSync* sync)
+    {
+        return TryWait(tryRecvBegin, &sync->m_cpp2pyFullWaiters, m_recvArmed);
+    };
+
+    /**
+     * Starts sending with trySendBegin if possible, or waits through the
+     * FIFO, see TryWait
+     */
+    template <typename TryBegin>
+    bool TrySendBegin(TryBegin trySendBegin, Ns3AiMsgSync* sync)
+    {
+        return TryWait(trySendBegin, &sync->m_py2cppEmptyWaiters, m_sendArmed);
+    };
+
+  private:
+    /**
+     * Begins without waiting (tryBegin) if possible. Otherwise, registers
+     * this side as a waiter (armed) of the semaphore, so that the next post
+     * notifies the FIFO, and tries again to not miss a post that happened
+     * in between.
+     */
+    template <typename TryBegin>
+    static bool TryWait(TryBegin tryBegin, volatile uint32_t* waiters, bool& armed)
+    {
+        if (!tryBegin())
+        {
+            if (armed)
+            {
+                return false;
+            }
+            Ns3AiSemaphore::atomic_add32(waiters, 1);
+            armed = true;
+            if (!tryBegin())
+            {
+                return false;
+            }
+        }
+        if (armed)
+        {
+            Ns3AiSemaphore::atomic_add32(waiters, -1);
+            armed = false;
+        }
+        return true;
+    };
+
+    /**
+     * Writes to the FIFO if Python side waits on the semaphore through it
+     */
+    void Notify(const volatile uint32_t* waiters)
+    {
+        if (m_writeFd >= 0 && Ns3AiSemaphore::atomic_read32(waiters) != 0)
+        {
+            // a full FIFO is already readable, so EAGAIN can be ignored
+            char byte = 0;
+            (void)!write(m_writeFd, &byte, 1);
+        }
+    };
+
+    std::string m_path; //!< the FIFO, on Python side
+    int m_fd;           //!< read end of the FIFO, on Python side
+    int m_writeFd;      //!< write end of the FIFO
+    bool m_recvArmed;   //!< whether Python side waits to receive through the FIFO
+    bool m_sendArmed;   //!< whether Python side waits to send through the FIFO
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_NOTIFY_H
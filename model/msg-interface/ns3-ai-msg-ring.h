@@ -0,0 +1,758 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_RING_H
+#define NS3_AI_MSG_RING_H
+
+#include "ns3-ai-msg-channel.h"
+#include "ns3-ai-msg-layout.h"
+#include "ns3-ai-msg-segment.h"
+#include "ns3-ai-msg-stats.h"
+#include "ns3-ai-semaphore.h"
+
+#include <ns3/abort.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <boost/interprocess/managed_shared_memory.hpp>
+
+namespace ns3
+{
+
+/**
+ * \brief Indices of a single-producer single-consumer ring in shared memory.
+ *
+ * The head is only written by the producer and the tail only by the consumer.
+ * They sit on separate cache lines so that the two processes do not
+ * invalidate each other's line on every message.
+ */
+struct Ns3AiRingSync
+{
+    alignas(NS3_AI_CACHE_LINE_SIZE) volatile uint32_t m_head{0};
+    volatile uint32_t m_headWaiters{0};
+    uint64_t m_nextSeq{0};
+    // set by the producer when no message will follow, see Ns3AiRing::SetFinished
+    volatile uint32_t m_finished{0};
+    alignas(NS3_AI_CACHE_LINE_SIZE) volatile uint32_t m_tail{0};
+    volatile uint32_t m_tailWaiters{0};
+    alignas(NS3_AI_CACHE_LINE_SIZE) uint32_t m_capacity{0};
+};
+
+/**
+ * \brief A slot of the ring: the message and its sequence number
+ */
+template <typename MsgType>
+struct Ns3AiRingSlot
+{
+    uint64_t m_seq;
+    MsgType m_msg;
+};
+
+/**
+ * \brief Process-local view of a ring living in a shared memory segment
+ */
+template <typename MsgType>
+class Ns3AiRing
+{
+  public:
+    typedef Ns3AiRingSlot<MsgType> Slot;
+
+    /**
+     * Sequence number marking the slot pushed by SetFinished to wake the
+     * consumer up
+     */
+    static constexpr uint64_t FINISH_SEQ = UINT64_MAX;
+
+    Ns3AiRing()
+        : m_sync(nullptr),
+          m_slots(nullptr),
+          m_mask(0),
+          m_spinBudget(Ns3AiSemaphore::DEFAULT_SPIN_BUDGET)
+    {
+    }
+
+    /**
+     * Bytes of the segment taken by a ring of the given capacity
+     */
+    static std::size_t Size(const std::string& name, uint32_t capacity)
+    {
+        return Ns3AiMsgLayout::ObjectSize<Slot>(name, capacity) +
+               Ns3AiMsgLayout::ObjectSize<Ns3AiRingSync>(name + " Sync");
+    }
+
+    /**
+     * Constructs the ring in the segment. The capacity must be a
+     * power of two.
+     */
+    void Create(boost::interprocess::managed_shared_memory& segment,
+                const std::string& name,
+                uint32_t capacity)
+    {
+        assert(capacity != 0 && (capacity & (capacity - 1)) == 0);
+        m_slots = Ns3AiMsgLayout::Construct<Slot>(segment, name.c_str(), capacity);
+        m_sync = Ns3AiMsgLayout::Construct<Ns3AiRingSync>(segment, (name + " Sync").c_str());
+        m_sync->m_capacity = capacity;
+        m_mask = capacity - 1;
+    }
+
+    /**
+     * Finds the ring constructed by the other side
+     *
+     * \return whether the ring exists in the segment
+     */
+    bool Open(boost::interprocess::managed_shared_memory& segment, const std::string& name)
+    {
+        m_slots = Ns3AiMsgLayout::Find<Slot>(segment, name.c_str());
+        m_sync = Ns3AiMsgLayout::Find<Ns3AiRingSync>(segment, (name + " Sync").c_str());
+        if (!m_slots || !m_sync)
+        {
+            return false;
+        }
+        m_mask = m_sync->m_capacity - 1;
+        return true;
+    }
+
+    /**
+     * Whether the ring is created or opened
+     */
+    bool IsAttached() const
+    {
+        return m_sync != nullptr;
+    }
+
+    void SetSpinBudget(uint32_t spinBudget)
+    {
+        m_spinBudget = spinBudget;
+    }
+
+    uint32_t GetCapacity() const
+    {
+        return m_mask + 1;
+    }
+
+    // for the producer:
+
+    /**
+     * Waits until at least one slot is free and returns it
+     */
+    MsgType* ProduceBegin()
+    {
+        uint32_t head = m_sync->m_head;
+        uint32_t tail = Ns3AiSemaphore::atomic_read32(&m_sync->m_tail);
+        while (head - tail > m_mask)
+        {
+            tail = Ns3AiSemaphore::wait_while_equal(&m_sync->m_tail,
+                                                    tail,
+                                                    &m_sync->m_tailWaiters,
+                                                    m_spinBudget);
+        }
+        return &m_slots[head & m_mask].m_msg;
+    }
+
+    /**
+     * Whether ProduceBegin would wait for the consumer
+     */
+    bool IsFull() const
+    {
+        return m_sync->m_head - Ns3AiSemaphore::atomic_read32(&m_sync->m_tail) > m_mask;
+    }
+
+    /**
+     * Gets the slot being written, between ProduceBegin and ProduceEnd
+     */
+    MsgType* ProduceSlot()
+    {
+        return &m_slots[m_sync->m_head & m_mask].m_msg;
+    }
+
+    /**
+     * Publishes the slot returned by ProduceBegin
+     *
+     * \return the sequence number of the published message
+     */
+    uint64_t ProduceEnd()
+    {
+        return Publish(m_sync->m_nextSeq++);
+    }
+
+    /**
+     * Publishes the slot returned by ProduceBegin with a given sequence
+     * number, e.g. the one of the message that is being answered
+     */
+    uint64_t ProduceEnd(uint64_t seq)
+    {
+        return Publish(seq);
+    }
+
+    /**
+     * Tells the consumer that no message will follow, without waiting for
+     * a free slot: the consumer may have stopped draining or exited. The
+     * flag is set first, then a finish slot wakes the consumer up if the
+     * ring has room. A full ring needs no wake-up, since the consumer only
+     * waits on an empty one and checks the flag before it does.
+     */
+    void SetFinished()
+    {
+        // a full barrier, ordered before the tail is read
+        Ns3AiSemaphore::atomic_cas32(&m_sync->m_finished, 1, 0);
+        uint32_t head = m_sync->m_head;
+        if (head - Ns3AiSemaphore::atomic_read32(&m_sync->m_tail) <= m_mask)
+        {
+            Publish(FINISH_SEQ);
+        }
+    }
+
+    // for the consumer:
+
+    /**
+     * Waits until at least one message is readable
+     *
+     * \return the number of readable messages, 0 if the producer
+     *         has finished and all messages have been consumed
+     */
+    uint32_t ConsumeBegin()
+    {
+        uint32_t tail = m_sync->m_tail;
+        uint32_t head = Ns3AiSemaphore::atomic_read32(&m_sync->m_head);
+        while (head == tail)
+        {
+            // read after the last ConsumeEnd stored the tail, see SetFinished
+            if (Ns3AiSemaphore::atomic_read32(&m_sync->m_finished))
+            {
+                return 0;
+            }
+            head = Ns3AiSemaphore::wait_while_equal(&m_sync->m_head,
+                                                    head,
+                                                    &m_sync->m_headWaiters,
+                                                    m_spinBudget);
+        }
+        uint32_t count = head - tail;
+        if (m_slots[(head - 1) & m_mask].m_seq == FINISH_SEQ)
+        {
+            // the finish slot stays in the ring and is never consumed
+            --count;
+        }
+        return count;
+    }
+
+    /**
+     * Gets the number of readable messages without waiting
+     */
+    uint32_t Available() const
+    {
+        uint32_t head = Ns3AiSemaphore::atomic_read32(&m_sync->m_head);
+        uint32_t count = head - m_sync->m_tail;
+        if (count != 0 && m_slots[(head - 1) & m_mask].m_seq == FINISH_SEQ)
+        {
+            --count;
+        }
+        return count;
+    }
+
+    /**
+     * Gets the i-th readable message, counting from the oldest one
+     */
+    MsgType* Peek(uint32_t i)
+    {
+        return &m_slots[(m_sync->m_tail + i) & m_mask].m_msg;
+    }
+
+    /**
+     * Gets the sequence number of the i-th readable message
+     */
+    uint64_t PeekSeq(uint32_t i) const
+    {
+        return m_slots[(m_sync->m_tail + i) & m_mask].m_seq;
+    }
+
+    /**
+     * Whether the producer has finished and every message is consumed
+     */
+    bool IsFinished() const
+    {
+        return Ns3AiSemaphore::atomic_read32(&m_sync->m_finished) && Available() == 0;
+    }
+
+    /**
+     * Releases the count oldest messages
+     */
+    void ConsumeEnd(uint32_t count)
+    {
+        Ns3AiSemaphore::store_and_wake(&m_sync->m_tail,
+                                       m_sync->m_tail + count,
+                                       &m_sync->m_tailWaiters);
+    }
+
+  private:
+    uint64_t Publish(uint64_t seq)
+    {
+        uint32_t head = m_sync->m_head;
+        m_slots[head & m_mask].m_seq = seq;
+        Ns3AiSemaphore::store_and_wake(&m_sync->m_head, head + 1, &m_sync->m_headWaiters);
+        return seq;
+    }
+
+    Ns3AiRingSync* m_sync;
+    Slot* m_slots;
+    uint32_t m_mask;
+    uint32_t m_spinBudget;
+};
+
+/**
+ * \brief Posted (one-way) C++ to Python messages of a channel, see
+ * Ns3AiMsgInterfaceImpl::EnablePost
+ *
+ * A ring that Python side creates and drains, and that C++ side finds when
+ * it first posts. Python side may wait for a lockstep message of the
+ * channel and for posted messages at once (RecvOrDrainBegin): C++ side
+ * wakes it up (Wake) when it sends a lockstep message or finds the ring
+ * full, so that both sides never wait for each other.
+ */
+template <typename MsgType>
+class Ns3AiMsgPost
+{
+  public:
+    Ns3AiMsgPost() = delete;
+
+    /**
+     * \param name the name of the ring in the segment
+     */
+    explicit Ns3AiMsgPost(const std::string& name)
+        : m_name(name)
+    {
+    }
+
+    /**
+     * Bytes of the segment taken by a ring of the given capacity
+     */
+    std::size_t Size(uint32_t capacity) const
+    {
+        return Ns3AiRing<MsgType>::Size(m_name, capacity);
+    }
+
+    /**
+     * Constructs the ring, on Python side. The capacity must be a power of
+     * two.
+     */
+    void Create(boost::interprocess::managed_shared_memory& segment, uint32_t capacity)
+    {
+        m_ring.Create(segment, m_name, capacity);
+    }
+
+    /**
+     * Finds the ring, e.g. after the segment is mapped again
+     *
+     * \return whether Python side enabled posted messages
+     */
+    bool Open(boost::interprocess::managed_shared_memory& segment)
+    {
+        return m_ring.Open(segment, m_name);
+    }
+
+    bool IsAttached() const
+    {
+        return m_ring.IsAttached();
+    }
+
+    void SetSpinBudget(uint32_t spinBudget)
+    {
+        m_ring.SetSpinBudget(spinBudget);
+    }
+
+    // for C++ side:
+
+    /**
+     * Waits until a slot is free and returns it, finding the ring first
+     */
+    MsgType* ProduceBegin(boost::interprocess::managed_shared_memory& segment, Ns3AiMsgSync* sync)
+    {
+        if (!IsAttached())
+        {
+            NS_ABORT_MSG_IF(!Open(segment),
+                            "Posted messages are not enabled on Python side, see EnablePost");
+        }
+        if (m_ring.IsFull())
+        {
+            // Python side may be waiting for a lockstep message
+            Wake(sync);
+        }
+        return m_ring.ProduceBegin();
+    }
+
+    /**
+     * Publishes the slot and counts it in the statistics
+     */
+    void ProduceEnd(Ns3AiMsgStatsRecorder& stats)
+    {
+        m_ring.ProduceEnd();
+        stats.Count(Ns3AiMsgStats::POST_COUNT, 1);
+        stats.Count(Ns3AiMsgStats::POST_BYTES, sizeof(MsgType));
+    }
+
+    /**
+     * Tells Python side that no message will follow, if it enabled posted
+     * messages
+     */
+    void SetFinished(boost::interprocess::managed_shared_memory& segment)
+    {
+        if (IsAttached() || Open(segment))
+        {
+            m_ring.SetFinished();
+        }
+    }
+
+    /**
+     * Wakes Python side up if it waits in RecvOrDrainBegin
+     */
+    static void Wake(Ns3AiMsgSync* sync)
+    {
+        if (Ns3AiSemaphore::atomic_read32(&sync->m_pyWakeWaiters) != 0)
+        {
+            Ns3AiSemaphore::atomic_add32(&sync->m_pyWake, 1);
+            Ns3AiSemaphore::futex_wake(&sync->m_pyWake);
+        }
+    }
+
+    // for Python side:
+
+    /**
+     * Waits until tryRecvBegin starts reading a lockstep message or posted
+     * messages are readable, whichever comes first
+     *
+     * \return whether reading has started
+     */
+    template <typename TryRecvBegin>
+    bool RecvOrDrainBegin(TryRecvBegin tryRecvBegin, Ns3AiMsgSync* sync, uint32_t spinBudget)
+    {
+        for (uint32_t i = 0;; ++i)
+        {
+            if (tryRecvBegin())
+            {
+                return true;
+            }
+            if (m_ring.Available() != 0)
+            {
+                return false;
+            }
+            if (i < spinBudget)
+            {
+                Ns3AiSemaphore::cpu_relax();
+                continue;
+            }
+            // registered before checking again, so that the wake-up is not missed
+            Ns3AiSemaphore::atomic_add32(&sync->m_pyWakeWaiters, 1);
+            uint32_t wake = Ns3AiSemaphore::atomic_read32(&sync->m_pyWake);
+            if (tryRecvBegin())
+            {
+                Ns3AiSemaphore::atomic_add32(&sync->m_pyWakeWaiters, -1);
+                return true;
+            }
+            if (m_ring.Available() == 0)
+            {
+                Ns3AiSemaphore::futex_wait(&sync->m_pyWake, wake);
+            }
+            Ns3AiSemaphore::atomic_add32(&sync->m_pyWakeWaiters, -1);
+        }
+    }
+
+    /**
+     * Gets the readable posted messages
+     *
+     * \param wait whether to wait until at least one message is posted
+     * \return their number. With wait, 0 means the simulation is over.
+     */
+    uint32_t DrainBegin(bool wait)
+    {
+        return wait ? m_ring.ConsumeBegin() : m_ring.Available();
+    }
+
+    /**
+     * Gets the i-th readable posted message, counting from the oldest one
+     */
+    MsgType* Peek(uint32_t i)
+    {
+        return m_ring.Peek(i);
+    }
+
+    /**
+     * Releases the count oldest posted messages
+     */
+    void DrainEnd(uint32_t count)
+    {
+        m_ring.ConsumeEnd(count);
+    }
+
+  private:
+    const std::string m_name;
+    Ns3AiRing<MsgType> m_ring;
+};
+
+/**
+ * \brief A ring-buffer implementation of the message interface
+ *
+ * Unlike Ns3AiMsgInterfaceImpl, which has one message in each direction,
+ * each direction is a ring of several slots. C++ side can therefore send
+ * many messages without waiting for Python to consume them, and Python
+ * side can drain all pending messages at once. Every message carries a
+ * sequence number, so that a reply can be matched to its request when
+ * lockstep interaction is needed.
+ */
+template <typename Cpp2PyMsgType, typename Py2CppMsgType>
+class Ns3AiMsgRingImpl
+{
+  public:
+    Ns3AiMsgRingImpl() = delete;
+
+    explicit Ns3AiMsgRingImpl(bool is_memory_creator,
+                              bool handle_finish,
+                              uint32_t capacity = 64,
+                              uint32_t size = 0,
+                              const char* segment_name = "My Seg",
+                              const char* cpp2py_msg_name = "My Cpp to Python Msg",
+                              const char* py2cpp_msg_name = "My Python to Cpp Msg",
+                              uint32_t spin_budget = Ns3AiSemaphore::DEFAULT_SPIN_BUDGET)
+        : m_segment(is_memory_creator,
+                    segment_name,
+                    // at least the size of the rings
+                    std::max<std::size_t>(
+                        size,
+                        Ns3AiMsgLayout::SEGMENT_OVERHEAD +
+                            Ns3AiRing<Cpp2PyMsgType>::Size(cpp2py_msg_name, capacity) +
+                            Ns3AiRing<Py2CppMsgType>::Size(py2cpp_msg_name, capacity))),
+          m_handleFinish(handle_finish),
+          m_isFinished(false)
+    {
+        if (m_segment.IsCreator())
+        {
+            m_cpp2py.Create(m_segment.Get(), cpp2py_msg_name, capacity);
+            m_py2cpp.Create(m_segment.Get(), py2cpp_msg_name, capacity);
+        }
+        else
+        {
+            NS_ABORT_MSG_IF(!m_cpp2py.Open(m_segment.Get(), cpp2py_msg_name) ||
+                                !m_py2cpp.Open(m_segment.Get(), py2cpp_msg_name),
+                            "Ring not found in segment " << segment_name);
+        }
+        SetSpinBudget(spin_budget);
+    };
+
+    ~Ns3AiMsgRingImpl()
+    {
+        if (!m_segment.IsCreator() && m_handleFinish)
+        {
+            CppSetFinished();
+        }
+    };
+
+    Ns3AiMsgRingImpl(const Ns3AiMsgRingImpl&) = delete;
+    Ns3AiMsgRingImpl& operator=(const Ns3AiMsgRingImpl&) = delete;
+
+    /**
+     * Gets the number of slots in each direction
+     */
+    uint32_t GetCapacity() const
+    {
+        return m_cpp2py.GetCapacity();
+    };
+
+    /**
+     * Sets the number of busy-wait iterations before backing off.
+     * See Ns3AiMsgInterfaceImpl::SetSpinBudget.
+     */
+    void SetSpinBudget(uint32_t spinBudget)
+    {
+        m_cpp2py.SetSpinBudget(spinBudget);
+        m_py2cpp.SetSpinBudget(spinBudget);
+    };
+
+    // for C++ side:
+
+    /**
+     * C++ side waits for a free slot and returns it for writing.
+     * Only waits when Python lags behind by the whole capacity.
+     */
+    Cpp2PyMsgType* CppSendBegin()
+    {
+        return m_cpp2py.ProduceBegin();
+    };
+
+    /**
+     * Gets the slot being written between CppSendBegin and CppSendEnd
+     */
+    Cpp2PyMsgType* GetCpp2PyStruct()
+    {
+        return m_cpp2py.ProduceSlot();
+    };
+
+    /**
+     * C++ side publishes the slot
+     *
+     * \return the sequence number of the message
+     */
+    uint64_t CppSendEnd()
+    {
+        return m_cpp2py.ProduceEnd();
+    };
+
+    /**
+     * C++ side waits until at least one reply from Python is readable
+     *
+     * \return the number of readable replies, which can be read with
+     *         GetPy2CppStructAt(i)
+     */
+    uint32_t CppRecvBegin()
+    {
+        return m_py2cpp.ConsumeBegin();
+    };
+
+    /**
+     * Gets the i-th readable reply, counting from the oldest one
+     */
+    Py2CppMsgType* GetPy2CppStructAt(uint32_t i)
+    {
+        return m_py2cpp.Peek(i);
+    };
+
+    /**
+     * Gets the sequence number of the message that the i-th readable
+     * reply answers
+     */
+    uint64_t GetPy2CppSeq(uint32_t i) const
+    {
+        return m_py2cpp.PeekSeq(i);
+    };
+
+    /**
+     * C++ side releases the count oldest replies
+     */
+    void CppRecvEnd(uint32_t count = 1)
+    {
+        m_py2cpp.ConsumeEnd(count);
+    };
+
+    /**
+     * C++ side sets the overall status to finished when
+     * the simulation is over
+     */
+    void CppSetFinished()
+    {
+        assert(m_handleFinish);
+        m_isFinished = true;
+        m_cpp2py.SetFinished();
+    };
+
+    // for Python side:
+
+    /**
+     * Python side waits until at least one message is readable
+     *
+     * \return the number of readable messages, which can be read with
+     *         GetCpp2PyStructAt(i). 0 means the simulation is over.
+     */
+    uint32_t PyRecvBegin()
+    {
+        uint32_t count = m_cpp2py.ConsumeBegin();
+        if (m_handleFinish && count == 0)
+        {
+            m_isFinished = m_cpp2py.IsFinished();
+        }
+        return count;
+    };
+
+    /**
+     * Gets the number of readable messages without waiting
+     */
+    uint32_t PyGetAvailable() const
+    {
+        return m_cpp2py.Available();
+    };
+
+    /**
+     * Gets the i-th readable message, counting from the oldest one
+     */
+    Cpp2PyMsgType* GetCpp2PyStructAt(uint32_t i)
+    {
+        return m_cpp2py.Peek(i);
+    };
+
+    /**
+     * Gets the sequence number of the i-th readable message
+     */
+    uint64_t GetCpp2PySeq(uint32_t i) const
+    {
+        return m_cpp2py.PeekSeq(i);
+    };
+
+    /**
+     * Python side releases the count oldest messages
+     */
+    void PyRecvEnd(uint32_t count)
+    {
+        m_cpp2py.ConsumeEnd(count);
+    };
+
+    /**
+     * Python side waits for a free reply slot
+     */
+    Py2CppMsgType* PySendBegin()
+    {
+        return m_py2cpp.ProduceBegin();
+    };
+
+    /**
+     * Gets the slot being written between PySendBegin and PySendEnd
+     */
+    Py2CppMsgType* GetPy2CppStruct()
+    {
+        return m_py2cpp.ProduceSlot();
+    };
+
+    /**
+     * Python side publishes the reply to the message with the given
+     * sequence number
+     */
+    void PySendEnd(uint64_t seq)
+    {
+        m_py2cpp.ProduceEnd(seq);
+    };
+
+    /**
+     * Python side gets whether the simulation is over
+     */
+    bool PyGetFinished()
+    {
+        assert(m_handleFinish);
+        return m_isFinished;
+    };
+
+  private:
+    Ns3AiMsgSegment m_segment;
+    Ns3AiRing<Cpp2PyMsgType> m_cpp2py;
+    Ns3AiRing<Py2CppMsgType> m_py2cpp;
+
+    const bool m_handleFinish;
+    bool m_isFinished;
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_RING_H
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_SEGMENT_H
+#define NS3_AI_MSG_SEGMENT_H
+
+#include "ns3-ai-msg-layout.h"
+#include "ns3-ai-msg-memory.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/interprocess/managed_shared_memory.hpp>
+
+namespace ns3
+{
+
+/**
+ * \brief The shared memory segment of a channel, as mapped by one side
+ *
+ * The creator makes the segment (replacing a stale one of the same name)
+ * and removes it when destroyed; the other side opens it. Before the other
+ * side opens it, the creator can grow it and map it again (see Reserve),
+ * after which the objects of the segment are found again by the remap
+ * callbacks of their owners. The mapping of either side can be pre-faulted
+ * (see Ns3AiMsgMemory).
+ */
+class Ns3AiMsgSegment
+{
+  public:
+    Ns3AiMsgSegment() = delete;
+
+    /**
+     * Creates the segment with at least size bytes, or opens it
+     */
+    Ns3AiMsgSegment(bool is_memory_creator, const char* segment_name, std::size_t size)
+        : m_isCreator(is_memory_creator),
+          m_name(segment_name),
+          m_align(4096),
+          m_faultBase(0)
+    {
+        using namespace boost::interprocess;
+        if (m_isCreator)
+        {
+            shared_memory_object::remove(segment_name);
+            m_segment = managed_shared_memory(
+                create_only,
+                segment_name,
+                std::max<std::size_t>(size, Ns3AiMsgLayout::SEGMENT_OVERHEAD));
+        }
+        else
+        {
+            m_segment = managed_shared_memory(open_only, segment_name);
+        }
+    };
+
+    ~Ns3AiMsgSegment()
+    {
+        if (m_isCreator)
+        {
+            boost::interprocess::shared_memory_object::remove(m_name.c_str());
+        }
+    };
+
+    Ns3AiMsgSegment(const Ns3AiMsgSegment&) = delete;
+    Ns3AiMsgSegment& operator=(const Ns3AiMsgSegment&) = delete;
+
+    /**
+     * Gets the mapping, which changes when the segment grows
+     */
+    boost::interprocess::managed_shared_memory& Get()
+    {
+        return m_segment;
+    };
+
+    bool IsCreator() const
+    {
+        return m_isCreator;
+    };
+
+    const std::string& GetName() const
+    {
+        return m_name;
+    };
+
+    /**
+     * Adds a function called after the segment is mapped again, to find
+     * the objects of its owner in the new mapping. They are called in the
+     * order they are added.
+     */
+    void AddRemapCallback(std::function<void()> callback)
+    {
+        m_remapCallbacks.push_back(std::move(callback));
+    };
+
+    /**
+     * Makes sure that bytes can be allocated in the segment. Otherwise, the
+     * creator grows the segment by bytes (more than what is missing, since
+     * the free memory may be fragmented) if canGrow, i.e. before the other
+     * side opens it; if not, the allocation fails with
+     * boost::interprocess::bad_alloc.
+     */
+    void Reserve(std::size_t bytes, bool canGrow)
+    {
+        if (m_segment.get_free_memory() < bytes && m_isCreator && canGrow)
+        {
+            Grow(bytes);
+        }
+    };
+
+    /**
+     * Grows the segment of the creator by at least bytes, to a multiple of
+     * the alignment (see SetGrowAlignment), maps it again and calls the
+     * remap callbacks, even if the segment had the size already
+     */
+    void Grow(std::size_t bytes)
+    {
+        using namespace boost::interprocess;
+        std::size_t size = m_segment.get_size();
+        std::size_t grown = Ns3AiMsgLayout::AlignUp(size + bytes, m_align);
+        if (grown > size)
+        {
+            m_segment = managed_shared_memory();
+            managed_shared_memory::grow(m_name.c_str(), grown - size);
+            m_segment = managed_shared_memory(open_only, m_name.c_str());
+        }
+        for (const std::function<void()>& callback : m_remapCallbacks)
+        {
+            callback();
+        }
+    };
+
+    /**
+     * Sets the multiple of the size the segment grows to, e.g. the huge
+     * page size. A power of two, the page size by default.
+     */
+    void SetGrowAlignment(std::size_t align)
+    {
+        m_align = align;
+    };
+
+    /**
+     * Applies the pre-faulting options of state to the mapping of this side
+     * (the creator being Python side), if any
+     */
+    void Prepare(Ns3AiMsgMemoryState& state)
+    {
+        if (state.m_flags)
+        {
+            m_faultBase = Ns3AiMsgMemory::Prepare(m_segment.get_address(),
+                                                  m_segment.get_size(),
+                                                  state,
+                                                  GetSide());
+        }
+    };
+
+    /**
+     * Records in state the page faults of this side since Prepare, if the
+     * segment is pre-faulted
+     */
+    void RecordFaults(Ns3AiMsgMemoryState& state) const
+    {
+        if (state.m_flags)
+        {
+            Ns3AiMsgMemory::Finish(state, GetSide(), m_faultBase);
+        }
+    };
+
+  private:
+    Ns3AiMsgMemory::Side GetSide() const
+    {
+        return m_isCreator ? Ns3AiMsgMemory::PY : Ns3AiMsgMemory::CPP;
+    };
+
+    boost::interprocess::managed_shared_memory m_segment;
+    const bool m_isCreator;
+    const std::string m_name;
+    std::size_t m_align;  //!< multiple of the size the segment grows to
+    uint64_t m_faultBase; //!< page faults of the process after pre-faulting
+    std::vector<std::function<void()>> m_remapCallbacks;
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_SEGMENT_H
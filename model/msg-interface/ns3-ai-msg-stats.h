@@ -0,0 +1,377 @@
+/*
+ * Copyright (c) 2023 Huazhong University of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:  Muyuan Shen <muyuan_shen@hust.edu.cn>
+ */
+
+#ifndef NS3_AI_MSG_STATS_H
+#define NS3_AI_MSG_STATS_H
+
+#include "ns3-ai-msg-layout.h"
+
+#include <ns3/traced-callback.h>
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <boost/interprocess/managed_shared_memory.hpp>
+
+namespace ns3
+{
+
+/**
+ * \brief Lock-free log-linear histogram of nanosecond durations.
+ *
+ * Values below SUB_BUCKETS have their own bucket. Above that, every power
+ * of two is split into SUB_BUCKETS linear buckets, so the relative error
+ * of a percentile is at most 1 / SUB_BUCKETS. One process records and any
+ * process mapping the segment can read or reset it.
+ */
+struct Ns3AiHistogram
+{
+    static constexpr uint32_t SUB_BUCKET_BITS = 3;
+    static constexpr uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr uint32_t NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    volatile uint64_t m_buckets[NUM_BUCKETS];
+    volatile uint64_t m_count;
+    volatile uint64_t m_sum;
+    volatile uint64_t m_max;
+
+    static uint32_t BucketOf(uint64_t value)
+    {
+        if (value < SUB_BUCKETS)
+        {
+            return value;
+        }
+        uint32_t exp = 63 - __builtin_clzll(value);
+        uint32_t shift = exp - SUB_BUCKET_BITS;
+        return ((shift + 1) << SUB_BUCKET_BITS) | ((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    /**
+     * Smallest value counted in bucket b
+     */
+    static uint64_t BucketLowerBound(uint32_t b)
+    {
+        if (b < SUB_BUCKETS)
+        {
+            return b;
+        }
+        uint32_t shift = (b >> SUB_BUCKET_BITS) - 1;
+        return static_cast<uint64_t>(SUB_BUCKETS | (b & (SUB_BUCKETS - 1))) << shift;
+    }
+
+    /**
+     * Largest value counted in bucket b
+     */
+    static uint64_t BucketUpperBound(uint32_t b)
+    {
+        return b + 1 < NUM_BUCKETS ? BucketLowerBound(b + 1) - 1 : UINT64_MAX;
+    }
+
+    void Record(uint64_t value)
+    {
+        __sync_fetch_and_add(&m_buckets[BucketOf(value)], 1);
+        __sync_fetch_and_add(&m_count, 1);
+        __sync_fetch_and_add(&m_sum, value);
+        uint64_t max = m_max;
+        while (value > max && !__sync_bool_compare_and_swap(&m_max, max, value))
+        {
+            max = m_max;
+        }
+    }
+
+    uint64_t GetCount() const
+    {
+        return m_count;
+    }
+
+    uint64_t GetBucket(uint32_t b) const
+    {
+        return b < NUM_BUCKETS ? m_buckets[b] : 0;
+    }
+
+    uint64_t GetMax() const
+    {
+        return m_max;
+    }
+
+    double GetMean() const
+    {
+        uint64_t count = m_count;
+        return count ? static_cast<double>(m_sum) / count : 0;
+    }
+
+    /**
+     * Gets the q-quantile (0 <= q <= 1), rounded up to the upper bound
+     * of its bucket and capped by the maximum
+     */
+    uint64_t GetPercentile(double q) const
+    {
+        uint64_t count = m_count;
+        if (count == 0)
+        {
+            return 0;
+        }
+        uint64_t rank = static_cast<uint64_t>(q * count);
+        uint64_t seen = 0;
+        for (uint32_t b = 0; b < NUM_BUCKETS; ++b)
+        {
+            seen += m_buckets[b];
+            if (seen > rank)
+            {
+                uint64_t upper = BucketUpperBound(b);
+                return upper < m_max ? upper : m_max;
+            }
+        }
+        return m_max;
+    }
+
+    void Reset()
+    {
+        for (uint32_t b = 0; b < NUM_BUCKETS; ++b)
+        {
+            m_buckets[b] = 0;
+        }
+        m_count = 0;
+        m_sum = 0;
+        m_max = 0;
+    }
+};
+
+/**
+ * \brief Message counters and latency histograms of a channel, kept in its
+ * shared memory segment.
+ *
+ * The C++ side records how long it waits in CppSendBegin and CppRecvBegin
+ * (i.e. on Python side), and how long it holds the message between Begin
+ * and End. In free-running mode, it records how stale the actions it reads
+ * are. All fields are zero in the initial state.
+ */
+struct Ns3AiMsgStats
+{
+    enum Histogram
+    {
+        SEND_WAIT = 0, //!< CppSendBegin waiting for Python to release the message
+        SEND_FILL,     //!< CppSendBegin to CppSendEnd
+        RECV_WAIT,     //!< CppRecvBegin waiting for the reply of Python
+        RECV_READ,     //!< CppRecvBegin to CppRecvEnd
+        ACTION_LAG,    //!< observations published after the one a free-running action answers
+        ACTION_AGE,    //!< time from the observation a free-running action answers to the latest
+        NUM_HISTOGRAMS
+    };
+
+    enum Counter
+    {
+        SEND_COUNT = 0,
+        SEND_BYTES,
+        RECV_COUNT,
+        RECV_BYTES,
+        POST_COUNT,
+        POST_BYTES,
+        PUBLISH_COUNT,  //!< observations published in free-running mode
+        ACTION_COUNT,   //!< actions read in free-running mode
+        ACTION_MISSING, //!< reads of an action before Python side wrote any
+        NUM_COUNTERS
+    };
+
+    volatile uint64_t m_counters[NUM_COUNTERS];
+    Ns3AiHistogram m_histograms[NUM_HISTOGRAMS];
+
+    /**
+     * Monotonic time in nanoseconds
+     */
+    static uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void Count(Counter counter, uint64_t n)
+    {
+        __sync_fetch_and_add(&m_counters[counter], n);
+    }
+
+    uint64_t GetCounter(uint32_t counter) const
+    {
+        return counter < NUM_COUNTERS ? m_counters[counter] : 0;
+    }
+
+    /**
+     * \throws std::out_of_range if there is no such histogram
+     */
+    Ns3AiHistogram& GetHistogram(uint32_t histogram)
+    {
+        if (histogram >= NUM_HISTOGRAMS)
+        {
+            throw std::out_of_range("No histogram " + std::to_string(histogram));
+        }
+        return m_histograms[histogram];
+    }
+
+    /**
+     * Clears all counters and histograms. Messages in flight during the
+     * reset may be partly counted.
+     */
+    void Reset()
+    {
+        for (uint32_t c = 0; c < NUM_COUNTERS; ++c)
+        {
+            m_counters[c] = 0;
+        }
+        for (uint32_t h = 0; h < NUM_HISTOGRAMS; ++h)
+        {
+            m_histograms[h].Reset();
+        }
+    }
+};
+
+/**
+ * \brief Records the statistics of a channel on one side, if either side
+ * enabled them
+ *
+ * Every function does nothing while the statistics are not enabled, so
+ * that disabled channels only pay a test of a pointer. The recorder also
+ * fires a trace source with every sample it records.
+ */
+class Ns3AiMsgStatsRecorder
+{
+  public:
+    Ns3AiMsgStatsRecorder() = delete;
+
+    /**
+     * \param name the name of the statistics in the segment
+     */
+    explicit Ns3AiMsgStatsRecorder(const std::string& name)
+        : m_name(name),
+          m_stats(nullptr),
+          m_time(0)
+    {
+    }
+
+    /**
+     * Bytes of the segment taken by the statistics
+     */
+    std::size_t Size() const
+    {
+        return Ns3AiMsgLayout::ObjectSize<Ns3AiMsgStats>(m_name);
+    }
+
+    /**
+     * Constructs the statistics in the segment, unless the other side did
+     */
+    void Enable(boost::interprocess::managed_shared_memory& segment)
+    {
+        m_stats = Ns3AiMsgLayout::FindOrConstruct<Ns3AiMsgStats>(segment, m_name.c_str());
+    }
+
+    /**
+     * Finds the statistics if either side enabled them, e.g. after the
+     * segment is opened or mapped again
+     */
+    void Open(boost::interprocess::managed_shared_memory& segment)
+    {
+        m_stats = Ns3AiMsgLayout::Find<Ns3AiMsgStats>(segment, m_name.c_str());
+    }
+
+    /**
+     * Gets the statistics, nullptr if they are not enabled
+     */
+    Ns3AiMsgStats* Get() const
+    {
+        return m_stats;
+    }
+
+    /**
+     * Gets the time a wait starts, for Acquired
+     */
+    uint64_t Start() const
+    {
+        return m_stats ? Ns3AiMsgStats::Now() : 0;
+    }
+
+    /**
+     * Records the wait of a message that started at start, and the time
+     * the message is acquired, for Released
+     */
+    void Acquired(Ns3AiMsgStats::Histogram wait, uint64_t start)
+    {
+        if (m_stats)
+        {
+            m_time = Ns3AiMsgStats::Now();
+            Record(wait, m_time - start);
+        }
+    }
+
+    /**
+     * Records how long the message acquired last was held, and counts it
+     * with its bytes
+     */
+    void Released(Ns3AiMsgStats::Histogram hold,
+                  Ns3AiMsgStats::Counter count,
+                  Ns3AiMsgStats::Counter bytesCount,
+                  uint64_t bytes)
+    {
+        if (m_stats)
+        {
+            Record(hold, Ns3AiMsgStats::Now() - m_time);
+            m_stats->Count(count, 1);
+            m_stats->Count(bytesCount, bytes);
+        }
+    }
+
+    void Count(Ns3AiMsgStats::Counter counter, uint64_t n)
+    {
+        if (m_stats)
+        {
+            m_stats->Count(counter, n);
+        }
+    }
+
+    /**
+     * Records a sample in a histogram and fires the trace source
+     */
+    void Record(Ns3AiMsgStats::Histogram histogram, uint64_t value)
+    {
+        if (m_stats)
+        {
+            m_stats->m_histograms[histogram].Record(value);
+            m_trace(histogram, value);
+        }
+    }
+
+    /**
+     * Gets the trace source fired with the histogram and the value of
+     * every sample recorded
+     */
+    TracedCallback<uint32_t, uint64_t>& GetTrace()
+    {
+        return m_trace;
+    }
+
+  private:
+    const std::string m_name;
+    Ns3AiMsgStats* m_stats;
+    uint64_t m_time; //!< when the current message was acquired
+    TracedCallback<uint32_t, uint64_t> m_trace;
+};
+
+} // namespace ns3
+
+#endif // NS3_AI_MSG_STATS_H
@@ -20,65 +20,267 @@
 #ifndef NS3_AI_SEMAPHORE_H
 #define NS3_AI_SEMAPHORE_H
 
+#include <chrono>
 #include <cstdint>
+#include <ctime>
+#include <sched.h>
+
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 /**
  * \brief Structure providing semaphore operations
+ *
+ * The semaphore is a 32-bit counter in shared memory. Waiting is adaptive:
+ * the waiter first spins on the counter, then backs off with the CPU pause
+ * instruction, and finally parks on a futex (Linux) or yields the CPU
+ * (other platforms) until the other side posts. Each counter has a waiter
+ * count next to it, so that posting only enters the kernel when the other
+ * side is actually parked.
  */
 struct Ns3AiSemaphore
 {
     explicit Ns3AiSemaphore() = default;
 
-    static inline uint8_t atomic_read8(const volatile uint8_t* mem)
+    /**
+     * Default number of busy-wait iterations before the waiter starts
+     * backing off. Another spin budget of the same length is spent with
+     * pause, after which the waiter parks.
+     */
+    static constexpr uint32_t DEFAULT_SPIN_BUDGET = 4096;
+
+    static inline uint32_t atomic_read32(const volatile uint32_t* mem)
     {
-        uint8_t old_val = *mem;
+        uint32_t old_val = *mem;
         __sync_synchronize();
         return old_val;
     }
 
-    static inline uint8_t atomic_cas8(volatile uint8_t* mem, uint8_t with, uint8_t cmp)
+    static inline uint32_t atomic_cas32(volatile uint32_t* mem, uint32_t with, uint32_t cmp)
     {
-        return __sync_val_compare_and_swap(const_cast<uint8_t*>(mem), cmp, with);
+        return __sync_val_compare_and_swap(const_cast<uint32_t*>(mem), cmp, with);
     }
 
-    static inline uint8_t atomic_add8(volatile uint8_t* mem, uint8_t val)
+    static inline uint32_t atomic_add32(volatile uint32_t* mem, uint32_t val)
     {
-        return __sync_fetch_and_add(const_cast<uint8_t*>(mem), val);
+        return __sync_fetch_and_add(const_cast<uint32_t*>(mem), val);
     }
 
-    static inline bool atomic_add_unless8(volatile uint8_t* mem, uint8_t value, uint8_t unless_this)
+    static inline bool atomic_add_unless32(volatile uint32_t* mem,
+                                           uint32_t value,
+                                           uint32_t unless_this)
     {
-        uint8_t old;
-        uint8_t c(atomic_read8(mem));
-        while (c != unless_this && (old = atomic_cas8(mem, c + value, c)) != c)
+        uint32_t old;
+        uint32_t c(atomic_read32(mem));
+        while (c != unless_this && (old = atomic_cas32(mem, c + value, c)) != c)
         {
             c = old;
         }
         return c != unless_this;
     }
 
-    static inline bool sem_try_wait(volatile uint8_t* mem)
+    static inline void cpu_relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield" ::: "memory");
+#else
+        __sync_synchronize();
+#endif
+    }
+
+    /**
+     * Blocks while *mem equals val, at most for the relative timeout if
+     * given. May return spuriously.
+     */
+    static inline void futex_wait(volatile uint32_t* mem,
+                                  uint32_t val,
+                                  const struct timespec* timeout = nullptr)
     {
-        return atomic_add_unless8(mem, -1, 0);
+#ifdef __linux__
+        // Not FUTEX_PRIVATE_FLAG: the word lives in memory shared by two processes
+        syscall(SYS_futex, const_cast<uint32_t*>(mem), FUTEX_WAIT, val, timeout, nullptr, 0);
+#else
+        (void)mem;
+        (void)val;
+        (void)timeout;
+        sched_yield();
+#endif
     }
 
-    static inline void sem_wait(volatile uint8_t* mem)
+    static inline void futex_wake(volatile uint32_t* mem)
     {
-        if (!sem_try_wait(mem))
+#ifdef __linux__
+        syscall(SYS_futex, const_cast<uint32_t*>(mem), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+        (void)mem;
+#endif
+    }
+
+    static inline bool sem_try_wait(volatile uint32_t* mem)
+    {
+        return atomic_add_unless32(mem, -1, 0);
+    }
+
+    /**
+     * Tries to decrement the semaphore while spinning, then backing off
+     * with pause, for spin_budget iterations each
+     *
+     * \return whether the semaphore was decremented
+     */
+    static inline bool sem_spin_wait(volatile uint32_t* mem, uint32_t spin_budget)
+    {
+        if (sem_try_wait(mem))
         {
-            do
+            return true;
+        }
+        for (uint32_t i = 0; i < spin_budget; ++i)
+        {
+            if (sem_try_wait(mem))
+            {
+                return true;
+            }
+        }
+        for (uint32_t i = 0; i < spin_budget; ++i)
+        {
+            cpu_relax();
+            if (sem_try_wait(mem))
             {
-                if (sem_try_wait(mem))
-                {
-                    break;
-                }
-            } while (true);
+                return true;
+            }
         }
+        return false;
     }
 
-    static inline uint8_t sem_post(volatile uint8_t* mem)
+    /**
+     * \param mem the semaphore counter
+     * \param waiters number of processes parked on mem
+     * \param spin_budget busy-wait iterations before backing off
+     */
+    static inline void sem_wait(volatile uint32_t* mem,
+                                volatile uint32_t* waiters,
+                                uint32_t spin_budget = DEFAULT_SPIN_BUDGET)
     {
-        return atomic_add8(mem, 1);
+        if (sem_spin_wait(mem, spin_budget))
+        {
+            return;
+        }
+        // Register as waiter before the last check, so that a post
+        // happening after the check always sees us and wakes us up
+        atomic_add32(waiters, 1);
+        while (!sem_try_wait(mem))
+        {
+            futex_wait(mem, 0);
+        }
+        atomic_add32(waiters, -1);
+    }
+
+    /**
+     * Like sem_wait, but gives up after timeout_ns nanoseconds
+     *
+     * \return whether the semaphore was decremented
+     */
+    static inline bool sem_timed_wait(volatile uint32_t* mem,
+                                      volatile uint32_t* waiters,
+                                      uint64_t timeout_ns,
+                                      uint32_t spin_budget = DEFAULT_SPIN_BUDGET)
+    {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point deadline = Clock::now() + std::chrono::nanoseconds(timeout_ns);
+        if (sem_spin_wait(mem, spin_budget))
+        {
+            return true;
+        }
+        atomic_add32(waiters, 1);
+        bool acquired;
+        while (!(acquired = sem_try_wait(mem)))
+        {
+            Clock::time_point now = Clock::now();
+            if (now >= deadline)
+            {
+                break;
+            }
+            uint64_t left =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+            struct timespec timeout;
+            timeout.tv_sec = left / 1000000000;
+            timeout.tv_nsec = left % 1000000000;
+            futex_wait(mem, 0, &timeout);
+        }
+        atomic_add32(waiters, -1);
+        return acquired;
+    }
+
+    static inline uint32_t sem_post(volatile uint32_t* mem, volatile uint32_t* waiters)
+    {
+        uint32_t old = atomic_add32(mem, 1);
+        if (atomic_read32(waiters) != 0)
+        {
+            futex_wake(mem);
+        }
+        return old;
+    }
+
+    /**
+     * Adaptively waits until *mem no longer equals val. Used for
+     * indices that only grow, such as the head and tail of a ring.
+     *
+     * \param mem the word to watch
+     * \param val the value to wait away from
+     * \param waiters number of processes parked on mem
+     * \param spin_budget busy-wait iterations before backing off
+     * \return the new value of *mem
+     */
+    static inline uint32_t wait_while_equal(volatile uint32_t* mem,
+                                            uint32_t val,
+                                            volatile uint32_t* waiters,
+                                            uint32_t spin_budget = DEFAULT_SPIN_BUDGET)
+    {
+        uint32_t cur;
+        for (uint32_t i = 0; i < spin_budget; ++i)
+        {
+            if ((cur = atomic_read32(mem)) != val)
+            {
+                return cur;
+            }
+        }
+        for (uint32_t i = 0; i < spin_budget; ++i)
+        {
+            cpu_relax();
+            if ((cur = atomic_read32(mem)) != val)
+            {
+                return cur;
+            }
+        }
+        atomic_add32(waiters, 1);
+        while ((cur = atomic_read32(mem)) == val)
+        {
+            futex_wait(mem, val);
+        }
+        atomic_add32(waiters, -1);
+        return cur;
+    }
+
+    /**
+     * Stores val into *mem and wakes the processes waiting on it with
+     * wait_while_equal
+     */
+    static inline void store_and_wake(volatile uint32_t* mem,
+                                      uint32_t val,
+                                      volatile uint32_t* waiters)
+    {
+        __sync_synchronize();
+        *mem = val;
+        __sync_synchronize();
+        if (*waiters != 0)
+        {
+            futex_wake(mem);
+        }
     }
 };
 
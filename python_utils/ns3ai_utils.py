@@ -17,7 +17,10 @@
 #         Hao Yin <haoyin@uw.edu>
 #         Muyuan Shen <muyuan_shen@hust.edu.cn>
 
+import asyncio
+import mmap
 import os
+import struct
 import subprocess
 import psutil
 import time
@@ -34,10 +37,56 @@ def get_setting(setting_map):
     return ret
 
 
-def run_single_ns3(path, pname, setting=None, env=None, show_output=False):
-    if env is None:
-        env = {}
-    env.update(os.environ)
+# parse a CPU set given as an iterable of CPU numbers or as a string in the
+# format of taskset -c, e.g., "0-3,8"
+def parse_cpus(cpus):
+    if cpus is None:
+        return None
+    if not isinstance(cpus, str):
+        return set(int(cpu) for cpu in cpus)
+    result = set()
+    for part in cpus.split(','):
+        part = part.strip()
+        if '-' in part:
+            first, last = part.split('-')
+            result.update(range(int(first), int(last) + 1))
+        elif part:
+            result.add(int(part))
+    return result
+
+
+# NUMA node of a CPU, 0 on hosts without NUMA
+def cpu_node(cpu):
+    try:
+        for name in os.listdir('/sys/devices/system/cpu/cpu{}'.format(cpu)):
+            if name.startswith('node') and name[4:].isdigit():
+                return int(name[4:])
+    except OSError:
+        pass
+    return 0
+
+
+# fault in every page of a shared memory segment from CPUs of the chosen NUMA
+# node, so that the kernel allocates the pages there (first-touch policy).
+# Pages already touched are not moved. Only valid before ns-3 opens the segment.
+def place_segment(segName, cpus):
+    saved = os.sched_getaffinity(0)
+    os.sched_setaffinity(0, cpus)
+    try:
+        with open(os.path.join('/dev/shm', segName), 'r+b') as f:
+            mem = mmap.mmap(f.fileno(), 0)
+            for offset in range(0, len(mem), mmap.PAGESIZE):
+                # writing back the same byte faults the page in for writing
+                mem[offset] = mem[offset]
+            mem.close()
+    finally:
+        os.sched_setaffinity(0, saved)
+
+
+# \param[in] cpus : CPUs the ns-3 process (and its children) may run on (default: any)
+def run_single_ns3(path, pname, setting=None, env=None, show_output=False, cpus=None):
+    # variables passed in env take precedence over those of this process
+    env = dict(os.environ, **(env or {}))
     env['LD_LIBRARY_PATH'] = os.path.abspath(os.path.join(path, 'build', 'lib'))
     # import pdb; pdb.set_trace()
     exec_path = os.path.join(path, 'ns3')
@@ -45,16 +94,23 @@ def run_single_ns3(path, pname, setting=None, env=None, show_output=False):
         cmd = '{} run {}'.format(exec_path, pname)
     else:
         cmd = '{} run {} --{}'.format(exec_path, pname, get_setting(setting))
+
+    def preexec():
+        os.setpgrp()
+        # inherited by the ns3 script and the simulation it runs
+        if cpus is not None:
+            os.sched_setaffinity(0, cpus)
+
     if show_output:
         proc = subprocess.Popen(cmd, shell=True, text=True, env=env,
                                 stdin=subprocess.PIPE,
-                                preexec_fn=os.setpgrp)
+                                preexec_fn=preexec)
     else:
         proc = subprocess.Popen(cmd, shell=True, text=True, env=env,
                                 stdin=subprocess.PIPE,
                                 stdout=subprocess.PIPE,
                                 stderr=subprocess.PIPE,
-                                preexec_fn=os.setpgrp)
+                                preexec_fn=preexec)
 
     return cmd, proc
 
@@ -91,25 +147,271 @@ def sigint_handler(sig, frame):
     exit(1)  # this will execute the `finally` block
 
 
+# names of Ns3AiMsgStats::Counter and Ns3AiMsgStats::Histogram, in order
+STATS_COUNTERS = ['send_count', 'send_bytes', 'recv_count', 'recv_bytes',
+                  'post_count', 'post_bytes', 'publish_count', 'action_count',
+                  'action_missing']
+STATS_HISTOGRAMS = ['send_wait', 'send_fill', 'recv_wait', 'recv_read',
+                    'action_lag', 'action_age']
+
+
+# read the statistics of a channel created with recordStats=True (or enabled
+# on C++ side), durations are in nanoseconds
+# \param[in] reset : whether to clear them after reading
+def read_msg_stats(msgInterface, reset=False):
+    stats = msgInterface.GetStats()
+    if stats is None:
+        return None
+    result = {}
+    for i, name in enumerate(STATS_COUNTERS):
+        result[name] = stats.GetCounter(i)
+    for i, name in enumerate(STATS_HISTOGRAMS):
+        hist = stats.GetHistogram(i)
+        result[name] = {
+            'count': hist.GetCount(),
+            'mean': hist.GetMean(),
+            'p50': hist.GetPercentile(0.5),
+            'p90': hist.GetPercentile(0.9),
+            'p99': hist.GetPercentile(0.99),
+            'max': hist.GetMax(),
+        }
+    if reset:
+        stats.Reset()
+    return result
+
+
+MEMORY_FLAGS = ['prefault', 'huge_pages', 'lock']
+
+
+# read how each side mapped the segment of a channel created with prefault,
+# hugePages or lockMemory: the options that took effect, the bytes mapped by
+# huge pages, the page faults taken while pre-faulting and those taken since
+# (by the whole process, until now for Python side and until the finish for
+# ns-3). The ns-3 entries are zero until ns-3 opens the segment.
+def read_memory_report(msgInterface):
+    if not msgInterface.GetMemoryFlags(False):
+        return None
+    result = {}
+    for side, cppSide in (('python', False), ('ns3', True)):
+        flags = msgInterface.GetMemoryFlags(cppSide)
+        result[side] = {
+            'applied': [name for i, name in enumerate(MEMORY_FLAGS) if flags & (1 << i)],
+            'huge_page_bytes': msgInterface.GetHugePageBytes(cppSide),
+            'prefault_faults': msgInterface.GetPrefaultFaults(cppSide),
+            'run_faults': msgInterface.GetRunFaults(cppSide),
+        }
+    return result
+
+
+# read a log written by a channel created with recordPath, without ns-3 or
+# the binding module (see Ns3AiMsgLogWriter for the format). Yields a tuple
+# (direction, time, payload) per message, where direction is 'cpp2py' or
+# 'py2cpp', time is in nanoseconds and payload is a memoryview of the raw
+# message (or vector items), e.g. for numpy.frombuffer with a matching dtype.
+def read_msg_log(path):
+    with open(path, 'rb') as f:
+        data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    if data[:8] != b'NS3AILOG':
+        raise Exception('ns3ai_utils: Error: {} is not a message log'.format(path))
+    end, = struct.unpack_from('<Q', data, 24)
+    offset = 32
+    view = memoryview(data)
+    while offset < end:
+        t, length, direction = struct.unpack_from('<QII', data, offset)
+        offset += 16
+        yield ('cpp2py', 'py2cpp')[direction], t, view[offset:offset + length]
+        offset += (length + 7) & ~7
+
+
+# number of vector items a broadcast or free-running slot holds: the given
+# length, else the fixed vector size or the batch capacity
+def _slot_length(length, vectorSize, batchCapacity, name):
+    length = length or vectorSize or batchCapacity
+    if not length:
+        raise Exception('ns3ai_utils: Error: {} is needed for vectors of unknown size'.format(name))
+    return length
+
+
+# create the message interface (Python side is the memory creator). A shmSize
+# of 0 creates a segment just large enough for the messages, which grows when
+# vectors are resized or statistics, posted messages or delayed actions are
+# enabled, before ns-3 opens it.
+def create_msg_interface(msgModule, handleFinish, useVector, vectorSize, shmSize, segName,
+                         cpp2pyMsgName, py2cppMsgName, lockableName, spinBudget, ringCapacity,
+                         postCapacity=None, recordStats=False, actionDelay=0, batchCapacity=None,
+                         asyncNotify=False, freeRun=False, recordPath=None,
+                         broadcastCapacity=None, prefault=False, hugePages=False,
+                         lockMemory=False, broadcastLength=None, freeRunLength=None):
+    if ringCapacity is not None:
+        # ring-buffer interface: many messages in flight per direction
+        if useVector:
+            raise Exception('ns3ai_utils: Error: Ring-buffer interface does not support vector')
+        msgInterface = msgModule.Ns3AiMsgRingImpl(
+            True, handleFinish, ringCapacity,
+            shmSize, segName, cpp2pyMsgName, py2cppMsgName
+        )
+    else:
+        msgInterface = msgModule.Ns3AiMsgInterfaceImpl(
+            True, useVector, handleFinish,
+            shmSize, segName, cpp2pyMsgName, py2cppMsgName, lockableName
+        )
+    # busy-wait iterations before Python side backs off and sleeps on futex
+    if spinBudget is not None:
+        msgInterface.SetSpinBudget(spinBudget)
+    # one-way messages posted by C++ side, drained with PyDrainBegin/PyDrainEnd
+    if postCapacity is not None:
+        if ringCapacity is not None or useVector:
+            raise Exception('ns3ai_utils: Error: Posted messages need the struct interface')
+        msgInterface.EnablePost(postCapacity)
+    # C++ side copies every message it sends for read-only subscribers in
+    # other processes, see Ns3AiMsgSubscriber. A slot holds a whole vector.
+    if broadcastCapacity is not None:
+        if ringCapacity is not None:
+            raise Exception('ns3ai_utils: Error: Ring-buffer interface does not broadcast')
+        if useVector:
+            msgInterface.EnableBroadcast(broadcastCapacity,
+                                         _slot_length(broadcastLength, vectorSize, batchCapacity,
+                                                      'broadcastLength'))
+        else:
+            msgInterface.EnableBroadcast(broadcastCapacity)
+    if recordStats:
+        if ringCapacity is not None:
+            raise Exception('ns3ai_utils: Error: Ring-buffer interface does not record statistics')
+        msgInterface.EnableStats()
+    if batchCapacity is not None:
+        # vectors of fixed capacity, each message carries its own length
+        if not useVector or vectorSize is not None:
+            raise Exception('ns3ai_utils: Error: Batches need vectors without a fixed size')
+        msgInterface.EnableBatch(batchCapacity)
+    elif useVector:
+        if vectorSize is None:
+            raise Exception('ns3ai_utils: Error: Using vector but size is unknown')
+        msgInterface.ResizeVectors(vectorSize)
+    # C++ side reads the action of actionDelay steps ago, so that Python side
+    # computes an action while C++ side simulates the next step
+    if actionDelay:
+        if ringCapacity is not None:
+            raise Exception('ns3ai_utils: Error: Ring-buffer interface does not delay actions')
+        msgInterface.EnableActionDelay(actionDelay)
+    # C++ side notifies a file descriptor, see AsyncMsgInterface
+    if asyncNotify:
+        if ringCapacity is not None:
+            raise Exception('ns3ai_utils: Error: Ring-buffer interface does not notify')
+        msgInterface.EnableNotify()
+    # C++ side publishes observations and reads the latest action without
+    # waiting, see PyWaitObservation and PyPublishAction. For vectors, the
+    # slots hold freeRunLength items, or a pair (observation, action).
+    if freeRun:
+        if ringCapacity is not None:
+            raise Exception('ns3ai_utils: Error: Ring-buffer interface does not run freely')
+        if useVector:
+            if not isinstance(freeRunLength, (tuple, list)):
+                freeRunLength = (freeRunLength, freeRunLength)
+            msgInterface.EnableFreeRun(*(_slot_length(length, vectorSize, batchCapacity,
+                                                      'freeRunLength')
+                                         for length in freeRunLength))
+        else:
+            msgInterface.EnableFreeRun()
+    # Python side logs every message, see read_msg_log and Experiment.replay
+    if recordPath is not None:
+        if ringCapacity is not None:
+            raise Exception('ns3ai_utils: Error: Ring-buffer interface does not record messages')
+        msgInterface.EnableRecord(recordPath)
+    # both sides populate their mapping before the first message, optionally
+    # backed by transparent huge pages and locked, see read_memory_report.
+    # Last, so that the segment is at its final size.
+    if prefault or hugePages or lockMemory:
+        if ringCapacity is not None:
+            raise Exception('ns3ai_utils: Error: Ring-buffer interface does not pre-fault')
+        msgInterface.EnablePrefault(hugePages, lockMemory)
+    return msgInterface
+
+
+# asyncio wrapper of a message interface created with asyncNotify=True. The
+# Begin functions are coroutines that wait on the notification descriptor
+# instead of blocking, so one event loop can serve many ns-3 processes:
+#
+#   aio = AsyncMsgInterface(exp.run())
+#   await aio.PyRecvBegin()
+#   ...
+#   aio.PyRecvEnd()
+#
+# Other methods are those of the wrapped interface.
+class AsyncMsgInterface:
+    def __init__(self, msgInterface):
+        self.msgInterface = msgInterface
+        self.fd = msgInterface.GetNotifyFd()
+        if self.fd < 0:
+            raise Exception('ns3ai_utils: Error: Notifications are not enabled')
+
+    def __getattr__(self, name):
+        return getattr(self.msgInterface, name)
+
+    async def _wait(self, tryBegin):
+        loop = asyncio.get_running_loop()
+        while not tryBegin():
+            readable = loop.create_future()
+            loop.add_reader(self.fd, lambda: readable.done() or readable.set_result(None))
+            try:
+                await readable
+            finally:
+                loop.remove_reader(self.fd)
+            # drain the notifications before trying again
+            try:
+                while os.read(self.fd, 4096):
+                    pass
+            except BlockingIOError:
+                pass
+
+    async def PyRecvBegin(self):
+        await self._wait(self.msgInterface.PyTryRecvBegin)
+
+    async def PySendBegin(self):
+        await self._wait(self.msgInterface.PyTrySendBegin)
+
+
 # This class sets up the shared memory and runs the simulation process.
 class Experiment:
-    _created = False
-
     # init ns-3 environment
-    # \param[in] memSize : share memory size
+    # \param[in] shmSize : minimum shared memory size (default: as needed)
     # \param[in] targetName : program name of ns3
     # \param[in] path : current working directory
+    # \param[in] prefault : populate the segments on both sides before the first message
+    # \param[in] hugePages : also back them by transparent huge pages
+    # \param[in] lockMemory : also lock them in memory (see read_memory_report)
+    # \param[in] pyCpus : CPUs Python side runs on, e.g., "2" (default: any)
+    # \param[in] ns3Cpus : CPUs the ns-3 process runs on, e.g., "3" (default: any)
+    # \param[in] broadcastLength : vector items a broadcast slot holds, for the vector
+    #                              interface (default: vectorSize or batchCapacity)
+    # \param[in] freeRunLength : the same for free-running slots, or a pair
+    #                            (observation, action)
+    # The shared memory segments are placed on the NUMA node of pyCpus (or of
+    # ns3Cpus if only those are given), see get_placement.
     def __init__(self, targetName, ns3Path, msgModule,
                  handleFinish=False,
                  useVector=False, vectorSize=None,
-                 shmSize=4096,
+                 shmSize=0,
                  segName="My Seg",
                  cpp2pyMsgName="My Cpp to Python Msg",
                  py2cppMsgName="My Python to Cpp Msg",
-                 lockableName="My Lockable"):
-        if self._created:
-            raise Exception('ns3ai_utils: Error: Experiment is singleton')
-        self._created = True
+                 lockableName="My Lockable",
+                 spinBudget=None,
+                 ringCapacity=None,
+                 postCapacity=None,
+                 recordStats=False,
+                 actionDelay=0,
+                 batchCapacity=None,
+                 asyncNotify=False,
+                 freeRun=False,
+                 recordPath=None,
+                 broadcastCapacity=None,
+                 prefault=False,
+                 hugePages=False,
+                 lockMemory=False,
+                 pyCpus=None,
+                 ns3Cpus=None,
+                 broadcastLength=None,
+                 freeRunLength=None):
         self.targetName = targetName  # ns-3 target name, not file name
         os.chdir(ns3Path)
         self.msgModule = msgModule
@@ -121,42 +423,172 @@ class Experiment:
         self.cpp2pyMsgName = cpp2pyMsgName
         self.py2cppMsgName = py2cppMsgName
         self.lockableName = lockableName
+        self.spinBudget = spinBudget
+        self.ringCapacity = ringCapacity
+        self.postCapacity = postCapacity
+        self.recordStats = recordStats
+        self.actionDelay = actionDelay
+        self.batchCapacity = batchCapacity
+        self.asyncNotify = asyncNotify
+        self.freeRun = freeRun
+        self.recordPath = recordPath
+        self.broadcastCapacity = broadcastCapacity
+        self.broadcastLength = broadcastLength
+        self.freeRunLength = freeRunLength
+        self.prefault = prefault
+        self.hugePages = hugePages
+        self.lockMemory = lockMemory
+        self.pyCpus = parse_cpus(pyCpus)
+        self.ns3Cpus = parse_cpus(ns3Cpus)
+        self.segmentCpus = self.pyCpus or self.ns3Cpus
+        if self.pyCpus:
+            os.sched_setaffinity(0, self.pyCpus)
+        if self.pyCpus and self.ns3Cpus:
+            if self.pyCpus & self.ns3Cpus:
+                print('ns3ai_utils: Warning: Python side and ns-3 share CPUs, '
+                      'spinning waits compete with the other process')
+            if {cpu_node(c) for c in self.pyCpus} != {cpu_node(c) for c in self.ns3Cpus}:
+                print('ns3ai_utils: Warning: Python side and ns-3 run on different NUMA '
+                      'nodes, every message crosses the interconnect')
 
-        self.msgInterface = msgModule.Ns3AiMsgInterfaceImpl(
-            True, self.useVector, self.handleFinish,
-            self.shmSize, self.segName, self.cpp2pyMsgName, self.py2cppMsgName, self.lockableName
-        )
-        if self.useVector:
-            if self.vectorSize is None:
-                raise Exception('ns3ai_utils: Error: Using vector but size is unknown')
-            self.msgInterface.GetCpp2PyVector().resize(self.vectorSize)
-            self.msgInterface.GetPy2CppVector().resize(self.vectorSize)
+        self.msgInterface = self._create_channel(
+            msgModule, handleFinish, useVector, vectorSize, shmSize, segName,
+            cpp2pyMsgName, py2cppMsgName, lockableName, spinBudget, ringCapacity,
+            postCapacity, recordStats, actionDelay, batchCapacity, asyncNotify,
+            freeRun, recordPath, broadcastCapacity, prefault, hugePages, lockMemory,
+            broadcastLength, freeRunLength)
+        # additional named channels, see add_channel
+        self.channels = {}
 
         self.proc = None
         self.simCmd = None
+        self.runTime = None
         print('ns3ai_utils: Experiment initialized')
 
     def __del__(self):
         self.kill()
         del self.msgInterface
+        self.channels.clear()
         print('ns3ai_utils: Experiment destroyed')
 
+    # create another channel, with its own shared memory segment and
+    # semaphores, for another AI component of the same ns-3 program.
+    # C++ side gets it with Ns3AiMsgInterface::Get()->GetInterface<...>(segName)
+    # \param[in] segName : name of the channel and its segment
+    # \param[in] msgModule : binding module of the channel (default: the Experiment's)
+    # other options are the same as those of the constructor
+    def add_channel(self, segName, msgModule=None,
+                    handleFinish=False,
+                    useVector=False, vectorSize=None,
+                    shmSize=0,
+                    cpp2pyMsgName="My Cpp to Python Msg",
+                    py2cppMsgName="My Python to Cpp Msg",
+                    lockableName="My Lockable",
+                    spinBudget=None,
+                    ringCapacity=None,
+                    postCapacity=None,
+                    recordStats=False,
+                    actionDelay=0,
+                    batchCapacity=None,
+                    asyncNotify=False,
+                    freeRun=False,
+                    recordPath=None,
+                    broadcastCapacity=None,
+                    prefault=False,
+                    hugePages=False,
+                    lockMemory=False,
+                    broadcastLength=None,
+                    freeRunLength=None):
+        if segName == self.segName or segName in self.channels:
+            raise Exception('ns3ai_utils: Error: Channel {} already exists'.format(segName))
+        if msgModule is None:
+            msgModule = self.msgModule
+        self.channels[segName] = self._create_channel(
+            msgModule, handleFinish, useVector, vectorSize, shmSize, segName,
+            cpp2pyMsgName, py2cppMsgName, lockableName, spinBudget, ringCapacity,
+            postCapacity, recordStats, actionDelay, batchCapacity, asyncNotify,
+            freeRun, recordPath, broadcastCapacity, prefault, hugePages, lockMemory,
+            broadcastLength, freeRunLength)
+        return self.channels[segName]
+
+    # create a channel with Python side on the CPUs of the segments, so that
+    # the pages touched while creating it are allocated on their NUMA node
+    def _create_channel(self, *args):
+        saved = os.sched_getaffinity(0)
+        if self.segmentCpus:
+            os.sched_setaffinity(0, self.segmentCpus)
+        try:
+            return create_msg_interface(*args)
+        finally:
+            os.sched_setaffinity(0, saved)
+
+    # the CPUs and NUMA nodes of Python side, of the ns-3 process (None
+    # if it is not running) and of the shared memory segments
+    def get_placement(self):
+        pyCpus = sorted(os.sched_getaffinity(0))
+        ns3Cpus = None
+        if self.proc and self.isalive():
+            try:
+                ns3Cpus = sorted(os.sched_getaffinity(self.proc.pid))
+            except OSError:
+                pass
+        return {
+            'python_cpus': pyCpus,
+            'python_nodes': sorted({cpu_node(c) for c in pyCpus}),
+            'ns3_cpus': ns3Cpus,
+            'ns3_nodes': sorted({cpu_node(c) for c in ns3Cpus}) if ns3Cpus else None,
+            'segment_nodes': (sorted({cpu_node(c) for c in self.segmentCpus})
+                              if self.segmentCpus else None),
+        }
+
     # run ns3 script in cmd with the setting being input
     # \param[in] setting : ns3 script input parameters(default : None)
     # \param[in] show_output : whether to show output or not(default : False)
-    def run(self, setting=None, show_output=False):
+    # \param[in] checkEarly : whether to wait and check that the simulation
+    #                         did not end at once, otherwise the caller does
+    #                         it with check_early_ending (default : True)
+    def run(self, setting=None, show_output=False, checkEarly=True):
         self.kill()
+        if self.segmentCpus:
+            # the segments no longer grow once ns-3 opens them
+            for segName in [self.segName] + list(self.channels):
+                place_segment(segName, self.segmentCpus)
+        # the default segment name on C++ side, see Ns3AiMsgInterface::SetNames
         self.simCmd, self.proc = run_single_ns3(
-            './', self.targetName, setting=setting, show_output=show_output)
+            './', self.targetName, setting=setting, env={'NS3_AI_SEGMENT': self.segName},
+            show_output=show_output, cpus=self.ns3Cpus)
         print("ns3ai_utils: Running ns-3 with: ", self.simCmd)
-        # exit if an early error occurred, such as wrong target name
-        time.sleep(SIMULATION_EARLY_ENDING)
-        if not self.isalive():
-            print('ns3ai_utils: Subprocess died very early')
-            exit(1)
+        self.runTime = time.monotonic()
+        if checkEarly:
+            self.check_early_ending()
+        if self.pyCpus or self.ns3Cpus:
+            print('ns3ai_utils: Placement:', self.get_placement())
         signal.signal(signal.SIGINT, sigint_handler)
         return self.msgInterface
 
+    # raise if the simulation started by run ended at once, on an early error
+    # such as a wrong target name. Waits until SIMULATION_EARLY_ENDING after
+    # the start, so that the simulations of several Experiments started
+    # together are checked with a single wait.
+    def check_early_ending(self):
+        remaining = self.runTime + SIMULATION_EARLY_ENDING - time.monotonic()
+        if remaining > 0:
+            time.sleep(remaining)
+        if not self.isalive():
+            raise Exception('ns3ai_utils: Error: Subprocess died very early: {}'.format(
+                self.simCmd))
+
+    # feed a log written with recordPath to the agent instead of running
+    # ns-3: receiving gives the logged messages in order, sending does
+    # nothing, and the simulation is finished at the end of the log
+    # (needs handleFinish=True). Replaces run.
+    # \param[in] logPath : the log file, of the same message types
+    def replay(self, logPath):
+        self.kill()
+        self.msgInterface.EnableReplay(logPath)
+        print("ns3ai_utils: Replaying", logPath)
+        return self.msgInterface
+
     def kill(self):
         if self.proc and self.isalive():
             kill_proc_tree(self.proc)
@@ -167,4 +599,4 @@ class Experiment:
         return self.proc.poll() is None
 
 
-__all__ = ['Experiment']
+__all__ = ['Experiment', 'AsyncMsgInterface', 'read_msg_log', 'read_memory_report']